@@ -12,9 +12,40 @@
 #define ENHANCE_INCLUDED
 
 #include <functional>
+#include <algorithm>
+#include <iterator>
 #include <type_traits>
+#include <cstring>
+#include <cstdint>
+#include <cassert>
+#include <memory>
+#include <new>
+#include <vector>
+#include <string>
+#include <array>
+#include <tuple>
+#include <limits>
 #include <ostream>
+#include <stdexcept>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
 #include <iostream>
+#include <fstream>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <exception>
+#include <cstddef>
+#if __cplusplus >= 201703L
+#include <string_view>
+#if defined(__has_include)
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#define ENHANCE_PMR
+#endif
+#endif
+#endif
 using std::cout;
 using std::endl;
 
@@ -29,6 +60,45 @@ using std::endl;
 
 #endif // FORCE_INLINE
 
+// hint to fetch the cache line at `p`
+#ifdef __GNUC__
+#define ENHANCE_PREFETCH(p) __builtin_prefetch(p)
+#else
+#define ENHANCE_PREFETCH(p) ((void)(p))
+#endif
+
+// vectorized kernels for contiguous ranges (see 3.3) use GCC/Clang
+// vector extensions. Define ENHANCE_NO_SIMD to disable them.
+#if !defined(ENHANCE_NO_SIMD) && defined(__GNUC__)
+#define ENHANCE_SIMD
+#if defined(__x86_64__) || defined(__i386__)
+#define ENHANCE_SIMD_X86
+#endif
+#endif
+
+// `MappedRecordFile` (see 4.5) maps files on POSIX systems and reads
+// them into memory elsewhere
+#if defined(__unix__) || defined(__APPLE__)
+#define ENHANCE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// `Serializable` saves contiguous ranges of numbers into Boost archives
+// with `boost::serialization::make_array` (see 4.5), if Boost is found
+// by `__has_include` or ENHANCE_BOOST_SERIALIZATION is defined (for
+// the whole build, e.g. on the command line)
+#if defined(__has_include) && !defined(ENHANCE_BOOST_SERIALIZATION)
+#if __has_include(<boost/serialization/array_wrapper.hpp>)
+#define ENHANCE_BOOST_SERIALIZATION
+#endif
+#endif
+#ifdef ENHANCE_BOOST_SERIALIZATION
+#include <boost/serialization/array_wrapper.hpp>
+#endif
+
 #if defined(_MSC_VER) && _MSC_VER < 1800
 #error "This version of Visual C++ does not support `template aliases` used by Enhance`. Either use Visual C++ 2013 or later or contact the maintainer of `Enhance`, who will be happy to backport to your version."
 #endif
@@ -47,6 +117,9 @@ using std::endl;
 namespace enhance {
 
   struct Nothing{};
+
+  // helper for SFINAE based detection of members
+  template<class> struct Void { typedef void type; };
   
     //#################### 1 the `access` function ############################
     /*
@@ -300,6 +373,68 @@ namespace enhance {
     }
 
 
+    //#################### 2.6 Descending Wrapper ############################
+    /** The `descending` wrapper marks an accessor, whose values should
+        be ordered descendingly in sort keys (see 4.7). All other
+        combiners access the value unchanged.
+
+        usage:
+
+        descending(&A::timestamp)
+     */
+  template<class Accessor>
+    struct Descending{
+
+      Accessor m;
+
+      Descending(Accessor m):m(m){};
+
+      template<class Target>
+      auto operator()(Target& d) const
+        -> decltype(access(m, d))
+      {
+        return access(m, d);
+      }
+    };
+
+    // factory function for template argument deduction
+    template<class Accessor>
+    Descending<Accessor> descending(Accessor a){
+      return Descending<Accessor>(a);
+    }
+
+    //#################### 2.7 Tag Wrapper ############################
+    /** The `tag` wrapper gives an accessor a stable field number for
+        tagged serialization (see 4.5), which stays the same, when
+        other accessors are added or removed. All other combiners
+        access the value unchanged.
+
+        usage:
+
+        tag<3>(&A::price)
+     */
+  template<unsigned Tag, class Accessor>
+    struct Tagged{
+
+      Accessor m;
+
+      Tagged(Accessor m):m(m){};
+
+      template<class Target>
+      auto operator()(Target& d) const
+        -> decltype(access(m, d))
+      {
+        return access(m, d);
+      }
+    };
+
+    // factory function for template argument deduction
+    template<unsigned Tag, class Accessor>
+    Tagged<Tag, Accessor> tag(Accessor a){
+      return Tagged<Tag, Accessor>(a);
+    }
+
+
     //#################### 3 Combiners ############################
     /*
       A `Combiner` iteratively applies a given operator a list of
@@ -354,7 +489,8 @@ namespace enhance {
       //call the target's `enhance` member, which should call the
       //()-operator of the derived class passed to it.
       FORCE_INLINE Result callEnhance(){
-        target.enhance(static_cast<Derived&>(*this));
+        if(!static_cast<Derived&>(*this).decided())
+          target.enhance(static_cast<Derived&>(*this));
         return result;
       }
 
@@ -367,6 +503,7 @@ namespace enhance {
 
       // the trivial version of the ()-operator
 			FORCE_INLINE Result operator()(){
+        static_cast<Derived&>(*this).flushRun();
         static_cast<Derived&>(*this).finalize();
         return result;
       }
@@ -418,12 +555,22 @@ namespace enhance {
 
       void initialize() const{
       }
+
+      // true, if the result is known without visiting the accessor
+      // list of the target (it is then not called at all)
+      bool decided() const{
+        return false;
+      }
           
       void beforeStep() const{
       }
           
       void finalize() const{
       }
+
+      bool flushRun() const{
+        return false;
+      }
           
 
     private:
@@ -439,6 +586,207 @@ namespace enhance {
 
     };
 
+    //#################### 3.0 Runs of adjacent data members ############################
+    /*
+      Consecutive data member accessors referring to adjacent members
+      (i.e. without padding in between) are collected into a single
+      run of bytes, if the `Operator` declares the members'
+      type `blockable`. The whole run is then handled by a single call
+      of `Operator::applyBlock`, e.g. one `memcmp` instead of one
+      comparison per member.
+
+      `Operator` opts in by providing
+
+        template<class Value> struct blockable; // with bool `value`
+
+        static bool applyBlock(Result&, Bytes* x, size_t n) // unary
+        static bool applyBlock(Result&, Bytes* x, Bytes2* y, size_t n) // binary
+
+      where `Bytes` is `char` or `const char`. Whether members are
+      adjacent is checked using their addresses, which the compiler
+      resolves at compile time, if the member pointers are known.
+    */
+
+  // Types whose values are equal, if and only if their object
+  // representations are equal. Specialize for your own types
+  // (e.g. padding-free structs of integers).
+  template<class Value>
+  struct IsBitwiseComparable : std::integral_constant<bool,
+    std::is_integral<Value>::value || std::is_enum<Value>::value ||
+    std::is_pointer<Value>::value> {};
+
+  template<class Operator, class Value, class Enable = void>
+  struct Blockable : std::false_type {};
+
+  template<class Operator, class Value>
+  struct Blockable<Operator, Value, typename std::enable_if<
+    Operator::template blockable<Value>::value>::type> : std::true_type {};
+
+  template<class Operator, class Enable = void>
+  struct HasBlocks : std::false_type {};
+
+  template<class Operator>
+  struct HasBlocks<Operator, typename Void<
+    typename Operator::template blockable<int> >::type> : std::true_type {};
+
+  // pointer to the object representation of `x`, keeping constness
+  template<class Value>
+  FORCE_INLINE typename std::conditional<std::is_const<Value>::value,
+                                         const char, char>::type*
+  bytesOf(Value& x){
+    return reinterpret_cast<typename std::conditional
+      <std::is_const<Value>::value, const char, char>::type*>
+      (std::addressof(x));
+  }
+
+  /*
+    Contiguous ranges of values can be handled by a single call of
+    `Operator::applyRange` instead of one `Operator::apply` per
+    element (see 3.3). `Operator` opts in by providing
+
+      static bool applyRange(Result&, Value* x, size_t n) // unary
+      static bool applyRange(Result&, Value* x, Value2* y, size_t n) // binary
+
+    for the supported element types.
+  */
+
+  // raw pointers to the elements of contiguous iterators
+  template<class It, class Enable = void>
+  struct Contiguous : std::false_type {};
+
+  template<class Value>
+  struct Contiguous<Value*> : std::true_type {
+    static Value* pointer(Value* it){ return it; }
+  };
+
+  template<class It>
+  struct Contiguous<It, typename std::enable_if<
+    std::is_same<It, typename std::vector<typename It::value_type>::iterator>::value ||
+    std::is_same<It, typename std::vector<typename It::value_type>::const_iterator>::value ||
+    std::is_same<It, std::string::iterator>::value ||
+    std::is_same<It, std::string::const_iterator>::value
+    >::type> : std::true_type {
+    static typename std::remove_reference<typename It::reference>::type*
+    pointer(It it){ return std::addressof(*it); }
+  };
+
+  template<class Operator, class Result, class It, class Enable = void>
+  struct HasUnaryRangeKernel : std::false_type {};
+
+  template<class Operator, class Result, class It>
+  struct HasUnaryRangeKernel<Operator, Result, It, typename Void<decltype(
+      Operator::applyRange(std::declval<Result&>(),
+                           Contiguous<It>::pointer(std::declval<It>()),
+                           size_t()))>::type> : std::true_type {};
+
+  template<class Operator, class Result, class It, class It2, class Enable = void>
+  struct HasBinaryRangeKernel : std::false_type {};
+
+  template<class Operator, class Result, class It, class It2>
+  struct HasBinaryRangeKernel<Operator, Result, It, It2, typename Void<decltype(
+      Operator::applyRange(std::declval<Result&>(),
+                           Contiguous<It>::pointer(std::declval<It>()),
+                           Contiguous<It2>::pointer(std::declval<It2>()),
+                           size_t()))>::type> : std::true_type {};
+
+  /*
+    Unary combiners hand the containers of `container(ac)` accessors
+    as a whole to `Operator::applyContainer`, e.g. to save the number
+    of elements along with them or to resize them on load, if
+    `Operator` provides
+
+      static bool applyContainer(Result&, Container& c)
+
+    for the container type. Otherwise the elements are visited like
+    those of other ranges.
+  */
+  template<class Operator, class Result, class Target, class A, class B,
+           class Enable = void>
+  struct HasContainerKernel : std::false_type {};
+
+  template<class Operator, class Result, class Target, class Accessor>
+  struct HasContainerKernel<Operator, Result, Target, Begin<Accessor>, End<Accessor>,
+                            typename Void<decltype(
+      Operator::applyContainer(std::declval<Result&>(),
+                               access(std::declval<Accessor>(),
+                                      std::declval<Target&>())))>::type>
+    : std::true_type {};
+
+  /*
+    If all accessors of a list give scalar values (e.g. a struct of a
+    few numbers), a binary combiner can evaluate all of them without
+    checking for an early stop, which avoids a hard to predict branch
+    per component. `Operator` opts in by providing
+
+      static void applyBranchless(Result&, const Value& x, const Value& y)
+  */
+
+  // true, if all `Accessors` give scalar values of `Target`
+  template<class Target, class... Accessors>
+  struct AllScalar : std::true_type {};
+
+  template<class Target, class Accessor, class Enable = void>
+  struct ScalarAccessor : std::false_type {};
+
+  template<class Target, class Accessor>
+  struct ScalarAccessor<Target, Accessor, typename Void<decltype(
+      access(std::declval<Accessor>(), std::declval<Target&>()))>::type>
+    : std::is_scalar<typename std::decay<decltype(
+        access(std::declval<Accessor>(), std::declval<Target&>()))>::type> {};
+
+  template<class Target, class Accessor, class... Rest>
+  struct AllScalar<Target, Accessor, Rest...> : std::integral_constant<bool,
+    ScalarAccessor<Target, Accessor>::value &&
+    AllScalar<Target, Rest...>::value> {};
+
+  // true, if `Operator` handles runs of blocks (see 3.0) and one of
+  // the values given by `Accessors` is blockable, i.e. could be part
+  // of a run
+  template<class Operator, class Target, class... Accessors>
+  struct AnyBlockable : std::false_type {};
+
+  template<class Operator, class Target, class Accessor, class Enable = void>
+  struct BlockableAccessor : std::false_type {};
+
+  template<class Operator, class Target, class Accessor>
+  struct BlockableAccessor<Operator, Target, Accessor, typename std::enable_if<
+                             HasBlocks<Operator>::value, typename Void<decltype(
+                               access(std::declval<Accessor>(),
+                                      std::declval<Target&>()))>::type>::type>
+    : Operator::template blockable<typename std::decay<decltype(
+        access(std::declval<Accessor>(), std::declval<Target&>()))>::type> {};
+
+  template<class Operator, class Target, class Accessor, class... Rest>
+  struct AnyBlockable<Operator, Target, Accessor, Rest...> : std::integral_constant<bool,
+    BlockableAccessor<Operator, Target, Accessor>::value ||
+    AnyBlockable<Operator, Target, Rest...>::value> {};
+
+  template<class Operator, class Result, class Enable = void>
+  struct HasBranchless : std::false_type {};
+
+  template<class Operator, class Result>
+  struct HasBranchless<Operator, Result, typename Void<decltype(
+      Operator::applyBranchless(std::declval<Result&>(), std::declval<const int&>(),
+                                std::declval<const int&>()))>::type> : std::true_type {};
+
+  /*
+    A binary combiner can skip the whole accessor list, if the result
+    follows from the targets themselves (e.g. from cached hashes, see
+    `CachedHashable`). `Operator` opts in by providing
+
+      static bool decide(Result&, const Target& x, const Target2& y)
+
+    which returns `true`, if it set the result. Only the complete
+    accessor list of `enhance` is skipped, not explicitly given ones.
+  */
+  template<class Operator, class Result, class Target, class Target2, class Enable = void>
+  struct HasDecide : std::false_type {};
+
+  template<class Operator, class Result, class Target, class Target2>
+  struct HasDecide<Operator, Result, Target, Target2, typename Void<decltype(
+      Operator::decide(std::declval<Result&>(), std::declval<Target&>(),
+                       std::declval<Target2&>()))>::type> : std::true_type {};
+
     //#################### 3.1 Unary Combiner ############################
     /*
       A Combiner for 'unary' operators, i.e. operators, that act on
@@ -476,9 +824,24 @@ namespace enhance {
 
       template<class Accessor>
       FORCE_INLINE bool singleStep(Accessor ac) {
-        static_cast<derived_t&>(*this).beforeStep();
-        return Operator::apply
-          (this->result, access(ac,this->target));
+        if(flushRun()) return true;
+        return applyStep(ac);
+      }
+
+      //specialization for data member accessors, that collects
+      //adjacent members into runs (see 3.0). `const` members of a
+      //non-const target are handled on their own.
+      template<class Value, class T>
+      FORCE_INLINE typename std::enable_if<!std::is_function<Value>::value, bool>::type
+      singleStep(Value T::* ac) {
+        return memberStep(ac, std::integral_constant<bool,
+                          Blockable<Operator, Value>::value &&
+                          (std::is_const<Target>::value || !std::is_const<Value>::value)>());
+      }
+
+      // handle the collected run (if any)
+      FORCE_INLINE bool flushRun(){
+        return flushRun(HasBlocks<Operator>());
       }
 
       struct Functor{
@@ -491,29 +854,102 @@ namespace enhance {
       //specialization for `Range` accessors
       template<class A,class B>
       FORCE_INLINE bool singleStep(Range<A,B> ac) {
-        // cout<<"ss1"<<endl;
+        if(flushRun()) return true;
+        //use `Operator::applyContainer` if possible
+        return containerStep(ac, std::integral_constant<bool,
+                             std::is_same<Derived, std::false_type>::value &&
+                             HasContainerKernel<Operator, result_t, Target, A, B>::value>());
+      }
+
+      template<class Accessor>
+      FORCE_INLINE bool containerStep(Range<Begin<Accessor>, End<Accessor> > ac,
+                                      std::true_type) {
+        return Operator::applyContainer(this->result, access(ac.a.m, this->target));
+      }
+
+      template<class A,class B>
+      FORCE_INLINE bool containerStep(Range<A,B> ac, std::false_type) {
         //copy the begin iterator
         auto   b = access(ac.a,this->target);
         //reference to the end iterator
         auto&& e = access(ac.b,this->target);
 
-        for(; b<e; ++b){
-          static_cast<derived_t&>(*this).beforeStep();
-          if(Operator::apply(this->result, *b))
-            return true;
-        }
-        return false;
+        //use `Operator::applyRange` if possible (see 3.3)
+        return rangeStep(b, e, std::integral_constant<bool,
+                         std::is_same<Derived, std::false_type>::value &&
+                         std::is_same<decltype(b), typename std::decay<decltype(e)>::type>::value &&
+                         HasUnaryRangeKernel<Operator, result_t, decltype(b)>::value>());
       }
 
       //Compile Time Range specialization.
 			template<int begin, int end, class Accessor>
       FORCE_INLINE bool singleStep(FromTo<begin, end, Accessor> a)
 			{
+        if(flushRun()) return true;
         auto& ref = access(a.m, this->target);
         return recurseRange<begin,endHelper<end,decltype(ref)>::value >(ref);
       }
 
       private:
+      typedef typename std::conditional<std::is_const<Target>::value,
+                                        const char, char>::type bytes_t;
+      bytes_t* runX = nullptr;
+      size_t runSize = 0;
+
+      template<class Accessor>
+      FORCE_INLINE bool applyStep(Accessor ac) {
+        static_cast<derived_t&>(*this).beforeStep();
+        return Operator::apply
+          (this->result, access(ac,this->target));
+      }
+
+      template<class Accessor>
+      FORCE_INLINE bool memberStep(Accessor ac, std::false_type) {
+        if(flushRun()) return true;
+        return applyStep(ac);
+      }
+
+      template<class It, class End>
+      FORCE_INLINE bool rangeStep(It b, End& e, std::false_type) {
+        for(; b<e; ++b){
+          static_cast<derived_t&>(*this).beforeStep();
+          if(Operator::apply(this->result, *b))
+            return true;
+        }
+        return false;
+      }
+
+      template<class It>
+      FORCE_INLINE bool rangeStep(It b, const It& e, std::true_type) {
+        if(!(b<e)) return false;
+        return Operator::applyRange(this->result, Contiguous<It>::pointer(b),
+                                    size_t(e - b));
+      }
+
+      template<class Value, class T>
+      FORCE_INLINE bool memberStep(Value T::* ac, std::true_type) {
+        bytes_t* x = bytesOf(this->target.*ac);
+        if(runSize && x == runX + runSize){
+          runSize += sizeof(Value);
+          return false;
+        }
+        if(flushRun()) return true;
+        runX = x;
+        runSize = sizeof(Value);
+        return false;
+      }
+
+      FORCE_INLINE bool flushRun(std::false_type){
+        return false;
+      }
+
+      FORCE_INLINE bool flushRun(std::true_type){
+        if(!runSize) return false;
+        size_t n = runSize;
+        runSize = 0;
+        return Operator::applyBlock(this->result, runX, n);
+      }
+
       template<int begin, int end, class B>
 			FORCE_INLINE typename std::enable_if<begin < end, bool>::type
       recurseRange(B& o)
@@ -581,22 +1017,58 @@ namespace enhance {
 
     template<class Accessor>
       FORCE_INLINE bool singleStep(Accessor ac) {
-        static_cast<derived_t&>(*this).beforeStep();
-        return Operator::apply
-          (this->result, access(ac,this->target),
-                         access(ac,this->target2));
+        if(flushRun()) return true;
+        return applyStep(ac);
+      }
+
+      //specialization for data member accessors, that collects
+      //adjacent members into runs (see 3.0). `const` members of
+      //non-const targets are handled on their own.
+      template<class Value, class T>
+      FORCE_INLINE typename std::enable_if<!std::is_function<Value>::value, bool>::type
+      singleStep(Value T::* ac) {
+        return memberStep(ac, std::integral_constant<bool,
+                          Blockable<Operator, Value>::value &&
+                          ((std::is_const<Target>::value && std::is_const<Target2>::value) ||
+                           !std::is_const<Value>::value)>());
+      }
+
+      // handle the collected run (if any)
+      FORCE_INLINE bool flushRun(){
+        return flushRun(HasBlocks<Operator>());
+      }
+
+      // see `HasDecide`
+      FORCE_INLINE bool decided(){
+        return decided(HasDecide<Operator, result_t, Target, Target2>());
       }
 
       struct Functor{
         typename BinaryCombiner::result_t operator()
-        (Target& target, Target2& target2){
+        (Target& target, Target2& target2) const{
           return BinaryCombiner(target, target2);
         }
       };
 
+#if !defined(_MSC_VER) || _MSC_VER >= 1800
+      // the complete accessor list, as passed by `enhance`. Uses
+      // `Operator::applyBranchless` if possible (see 3.0), but not
+      // for derived combiners, whose steps would be skipped, nor if
+      // values could be handled in runs of blocks
+      template<class... Accessors>
+      FORCE_INLINE result_t operator()(Accessors... acs){
+        return applyAll(std::integral_constant<bool,
+                        std::is_same<Derived, std::false_type>::value &&
+                        HasBranchless<Operator, result_t>::value &&
+                        AllScalar<Target, Accessors...>::value &&
+                        !AnyBlockable<Operator, Target, Accessors...>::value>(), acs...);
+      }
+#endif
+
       //specialization for `Range` accessors
       template<class A,class B>
       FORCE_INLINE bool singleStep(Range<A,B> ac) {
+        if(flushRun()) return true;
         //copy the begin iterators
         auto   b_x = access(ac.a,this->target);
         auto   b_y = access(ac.a,this->target2);
@@ -608,25 +1080,117 @@ namespace enhance {
         // are possible, esp. for operator==, where differing length
         // simply should result in the value `false`.)
         assert(e_x-b_x==e_y-b_y);
-
-        for(; b_x<e_x; ++b_x, ++b_y){
-          static_cast<derived_t&>(*this).beforeStep();
-          if(Operator::apply(this->result, *b_x, *b_y))
-            return true;
-        }
-        return false;
+        (void)e_y;
+
+        //use `Operator::applyRange` if possible (see 3.3)
+        return rangeStep(b_x, e_x, b_y, std::integral_constant<bool,
+                         std::is_same<Derived, std::false_type>::value &&
+                         std::is_same<decltype(b_x), typename std::decay<decltype(e_x)>::type>::value &&
+                         HasBinaryRangeKernel<Operator, result_t, decltype(b_x),
+                                              decltype(b_y)>::value>());
       }
 
       //Compile Time Range specialization.
 			template<int begin, int end, class Accessor>
       FORCE_INLINE bool singleStep(FromTo<begin, end, Accessor> a)
 			{
+        if(flushRun()) return true;
         auto& ref = access(a.m, this->target);
         auto& ref2 = access(a.m, this->target2);
         return recurseRange<begin,endHelper<end,decltype(ref)>::value >(ref, ref2);
       }
 
       private:
+      typedef typename std::conditional<std::is_const<Target>::value,
+                                        const char, char>::type bytes_t;
+      typedef typename std::conditional<std::is_const<Target2>::value,
+                                        const char, char>::type bytes2_t;
+
+#if !defined(_MSC_VER) || _MSC_VER >= 1800
+      template<class... Accessors>
+      FORCE_INLINE result_t applyAll(std::false_type, Accessors... acs){
+        return BinaryCombiner::Combiner::operator()(acs...);
+      }
+
+      template<class... Accessors>
+      FORCE_INLINE result_t applyAll(std::true_type, Accessors... acs){
+        int expand[] = {0, (Operator::applyBranchless
+                            (this->result, access(acs, this->target),
+                             access(acs, this->target2)), 0)...};
+        (void)expand;
+        return BinaryCombiner::Combiner::operator()();
+      }
+#endif
+      bytes_t* runX = nullptr;
+      bytes2_t* runY = nullptr;
+      size_t runSize = 0;
+
+      template<class Accessor>
+      FORCE_INLINE bool applyStep(Accessor ac) {
+        static_cast<derived_t&>(*this).beforeStep();
+        return Operator::apply
+          (this->result, access(ac,this->target),
+                         access(ac,this->target2));
+      }
+
+      template<class Accessor>
+      FORCE_INLINE bool memberStep(Accessor ac, std::false_type) {
+        if(flushRun()) return true;
+        return applyStep(ac);
+      }
+
+      template<class It, class End, class It2>
+      FORCE_INLINE bool rangeStep(It b_x, End& e_x, It2 b_y, std::false_type) {
+        for(; b_x<e_x; ++b_x, ++b_y){
+          static_cast<derived_t&>(*this).beforeStep();
+          if(Operator::apply(this->result, *b_x, *b_y))
+            return true;
+        }
+        return false;
+      }
+
+      template<class It, class It2>
+      FORCE_INLINE bool rangeStep(It b_x, const It& e_x, It2 b_y, std::true_type) {
+        if(!(b_x<e_x)) return false;
+        return Operator::applyRange(this->result, Contiguous<It>::pointer(b_x),
+                                    Contiguous<It2>::pointer(b_y),
+                                    size_t(e_x - b_x));
+      }
+
+      template<class Value, class T>
+      FORCE_INLINE bool memberStep(Value T::* ac, std::true_type) {
+        bytes_t* x = bytesOf(this->target.*ac);
+        bytes2_t* y = bytesOf(this->target2.*ac);
+        if(runSize && x == runX + runSize && y == runY + runSize){
+          runSize += sizeof(Value);
+          return false;
+        }
+        if(flushRun()) return true;
+        runX = x;
+        runY = y;
+        runSize = sizeof(Value);
+        return false;
+      }
+
+      FORCE_INLINE bool flushRun(std::false_type){
+        return false;
+      }
+
+      FORCE_INLINE bool flushRun(std::true_type){
+        if(!runSize) return false;
+        size_t n = runSize;
+        runSize = 0;
+        return Operator::applyBlock(this->result, runX, runY, n);
+      }
+
+      FORCE_INLINE bool decided(std::false_type){
+        return false;
+      }
+
+      FORCE_INLINE bool decided(std::true_type){
+        return Operator::decide(this->result, this->target, target2);
+      }
+
     template<int begin, int end, class B, class C>
 			FORCE_INLINE typename std::enable_if<begin < end, bool>::type
     recurseRange(B& x, C& y)
@@ -646,63 +1210,494 @@ namespace enhance {
       }
     };
 
-    //#################### 4 Modules ############################
-    //#################### 4.1 Comparison Operators ############################
+    //#################### 3.3 Vectorized range kernels ############################
     /*
-      
-      This adopts the terminology of std::tuple.
-
-      From http://en.cppreference.com/w/cpp/utility/tuple/operator_cmp:
+      Kernels for contiguous ranges of `float`, `double`, `int32_t` and
+      `int64_t` used by `Operator::applyRange` (see 3.1) of `Equal`,
+      `Addition`, `Subtraction`, `ScalarProduct`, `ScalarMultiply` and
+      `ScalarDivide`.
+
+      The kernels are written using GCC/Clang vector extensions. On
+      x86, an AVX2 version is selected at runtime, if supported by the
+      CPU, otherwise 16 byte vectors (SSE2) are used. Other compilers
+      use a plain loop.
+
+      Note that `dot` sums up floating point values in a different
+      order than the element by element loop, so results may differ
+      in the last bits.
+     */
+  namespace simd {
 
-      Point-wise comparison: Compares every pair of components.
-      
-      Lexicographic comparison: Returns the result of the underlying
-      comparison operator applied to the first pair of components that
-      is not `==`.
+    template<class Value>
+    struct Supported : std::integral_constant<bool,
+      std::is_same<Value, float>::value || std::is_same<Value, double>::value ||
+      std::is_same<Value, int32_t>::value || std::is_same<Value, int64_t>::value> {};
 
-      All comparison operators are short-circuited; they do not access
-      tuple elements beyond what is necessary to determine the result
-      of the comparison.
+    template<class Value>
+    struct SupportedFloat : std::integral_constant<bool,
+      std::is_same<Value, float>::value || std::is_same<Value, double>::value> {};
 
-      Specilize e.g. using Comparison, ComparisonPW, ComparisonLEX
+    template<class Value>
+    struct Add {
+      FORCE_INLINE static void scalar(Value& a, const Value& b){ a += b; }
+      template<class V> FORCE_INLINE static void vector(V& a, const V& b){ a += b; }
+    };
 
-     */
+    template<class Value>
+    struct Sub {
+      FORCE_INLINE static void scalar(Value& a, const Value& b){ a -= b; }
+      template<class V> FORCE_INLINE static void vector(V& a, const V& b){ a -= b; }
+    };
 
-  template<class Base>
-  struct ComparisonOp : Base {
-    typedef bool result_t;
-    template<class A, class B>
-    static bool init(A&, B&){ return true; }
-  };
+    template<class Value>
+    struct Mul {
+      FORCE_INLINE static void scalar(Value& a, const Value& b){ a *= b; }
+      template<class V> FORCE_INLINE static void vector(V& a, const V& b){ a *= b; }
+    };
 
-  /* Template for point-wise comparison 
-   */
-  template<template<class> class Operator>
-  struct PointwiseComparisonOp {
     template<class Value>
-    static bool apply(bool& r, Value&& a, Value&& b){
-      Operator<Value> op;
-      if(op(std::forward<Value>(a),std::forward<Value>(b)))
-        return false;
-      r = false;
-      return true;
+    struct Div {
+      FORCE_INLINE static void scalar(Value& a, const Value& b){ a /= b; }
+      template<class V> FORCE_INLINE static void vector(V& a, const V& b){ a /= b; }
+    };
+
+#ifdef ENHANCE_SIMD
+    // The loops below are instantiated with the vector size of the
+    // selected instruction set, inlined into functions compiled for
+    // that instruction set.
+
+    // a[i] = a[i] Op b[i]
+    template<size_t Bytes, template<class> class Op, class Value>
+    FORCE_INLINE void zipLoop(Value* a, const Value* b, size_t n){
+      typedef Value V __attribute__((vector_size(Bytes)));
+      const size_t w = Bytes / sizeof(Value);
+      size_t i = 0;
+      for(; i + w <= n; i += w){
+        V x, y;
+        std::memcpy(&x, a + i, Bytes);
+        std::memcpy(&y, b + i, Bytes);
+        Op<Value>::vector(x, y);
+        std::memcpy(a + i, &x, Bytes);
+      }
+      for(; i < n; ++i)
+        Op<Value>::scalar(a[i], b[i]);
     }
-  };
 
-  /* Template for lexicographic comparison 
-   */
-  template<template<class> class Operator>
-  struct LexicographicalComparisonOp {
-    template<class Value>
-    static bool apply(bool& r, Value&& a, Value&& b){
-      Operator<Value> op;
-      if(a == b) return false;
-      r = op(std::forward<Value>(a),std::forward<Value>(b));
-      return true;
+    // a[i] = a[i] Op s
+    template<size_t Bytes, template<class> class Op, class Value>
+    FORCE_INLINE void scalarLoop(Value* a, Value s, size_t n){
+      typedef Value V __attribute__((vector_size(Bytes)));
+      const size_t w = Bytes / sizeof(Value);
+      V y;
+      for(size_t j = 0; j < w; ++j)
+        y[j] = s;
+      size_t i = 0;
+      for(; i + w <= n; i += w){
+        V x;
+        std::memcpy(&x, a + i, Bytes);
+        Op<Value>::vector(x, y);
+        std::memcpy(a + i, &x, Bytes);
+      }
+      for(; i < n; ++i)
+        Op<Value>::scalar(a[i], s);
     }
-  };
 
-  // Combiner aliases for the different operator types and single operators
+    template<size_t Bytes, class Value>
+    FORCE_INLINE Value dotLoop(const Value* a, const Value* b, size_t n){
+      typedef Value V __attribute__((vector_size(Bytes)));
+      const size_t w = Bytes / sizeof(Value);
+      V acc = V();
+      size_t i = 0;
+      for(; i + w <= n; i += w){
+        V x, y;
+        std::memcpy(&x, a + i, Bytes);
+        std::memcpy(&y, b + i, Bytes);
+        acc += x * y;
+      }
+      Value r = 0;
+      for(size_t j = 0; j < w; ++j)
+        r += acc[j];
+      for(; i < n; ++i)
+        r += a[i] * b[i];
+      return r;
+    }
+
+    // `==` semantics for floating point values, i.e. -0.0 == 0.0 and
+    // NaN != NaN
+    template<size_t Bytes, class Value>
+    FORCE_INLINE bool equalLoop(const Value* a, const Value* b, size_t n){
+      typedef Value V __attribute__((vector_size(Bytes)));
+      typedef decltype(V() != V()) M;
+      const size_t w = Bytes / sizeof(Value), chunk = 4 * w;
+      size_t i = 0;
+      // the lanes of the accumulated comparison masks are only
+      // checked once per chunk
+      for(; i + chunk <= n; i += chunk){
+        M differ = M();
+        for(size_t k = 0; k < chunk; k += w){
+          V x, y;
+          std::memcpy(&x, a + i + k, Bytes);
+          std::memcpy(&y, b + i + k, Bytes);
+          differ |= x != y;
+        }
+        bool any = false;
+        for(size_t j = 0; j < w; ++j)
+          any |= differ[j] != 0;
+        if(any)
+          return false;
+      }
+      for(; i < n; ++i)
+        if(!(a[i] == b[i]))
+          return false;
+      return true;
+    }
+
+#ifdef ENHANCE_SIMD_X86
+    inline bool hasAvx2(){
+      static const bool avx2 = (__builtin_cpu_init(),
+                                __builtin_cpu_supports("avx2") != 0);
+      return avx2;
+    }
+
+    template<template<class> class Op, class Value>
+    __attribute__((target("avx2"))) void zipAvx2(Value* a, const Value* b, size_t n){
+      zipLoop<32, Op>(a, b, n);
+    }
+
+    template<template<class> class Op, class Value>
+    __attribute__((target("avx2"))) void scalarAvx2(Value* a, Value s, size_t n){
+      scalarLoop<32, Op>(a, s, n);
+    }
+
+    template<class Value>
+    __attribute__((target("avx2"))) Value dotAvx2(const Value* a, const Value* b, size_t n){
+      return dotLoop<32>(a, b, n);
+    }
+
+    template<class Value>
+    __attribute__((target("avx2"))) bool equalAvx2(const Value* a, const Value* b, size_t n){
+      return equalLoop<32>(a, b, n);
+    }
+#endif // ENHANCE_SIMD_X86
+
+    template<template<class> class Op, class Value>
+    void zip(Value* a, const Value* b, size_t n){
+#ifdef ENHANCE_SIMD_X86
+      if(hasAvx2())
+        return zipAvx2<Op>(a, b, n);
+#endif
+      zipLoop<16, Op>(a, b, n);
+    }
+
+    template<template<class> class Op, class Value>
+    void scalar(Value* a, Value s, size_t n){
+#ifdef ENHANCE_SIMD_X86
+      if(hasAvx2())
+        return scalarAvx2<Op>(a, s, n);
+#endif
+      scalarLoop<16, Op>(a, s, n);
+    }
+
+    template<class Value>
+    Value dot(const Value* a, const Value* b, size_t n){
+#ifdef ENHANCE_SIMD_X86
+      if(hasAvx2())
+        return dotAvx2(a, b, n);
+#endif
+      return dotLoop<16>(a, b, n);
+    }
+
+    template<class Value>
+    bool equal(const Value* a, const Value* b, size_t n){
+      if(!SupportedFloat<Value>::value)
+        return std::memcmp(a, b, n * sizeof(Value)) == 0;
+#ifdef ENHANCE_SIMD_X86
+      if(hasAvx2())
+        return equalAvx2(a, b, n);
+#endif
+      return equalLoop<16>(a, b, n);
+    }
+
+#else // ENHANCE_SIMD
+
+    template<template<class> class Op, class Value>
+    void zip(Value* a, const Value* b, size_t n){
+      for(size_t i = 0; i < n; ++i)
+        Op<Value>::scalar(a[i], b[i]);
+    }
+
+    template<template<class> class Op, class Value>
+    void scalar(Value* a, Value s, size_t n){
+      for(size_t i = 0; i < n; ++i)
+        Op<Value>::scalar(a[i], s);
+    }
+
+    template<class Value>
+    Value dot(const Value* a, const Value* b, size_t n){
+      Value r = 0;
+      for(size_t i = 0; i < n; ++i)
+        r += a[i] * b[i];
+      return r;
+    }
+
+    template<class Value>
+    bool equal(const Value* a, const Value* b, size_t n){
+      if(!SupportedFloat<Value>::value)
+        return std::memcmp(a, b, n * sizeof(Value)) == 0;
+      for(size_t i = 0; i < n; ++i)
+        if(!(a[i] == b[i]))
+          return false;
+      return true;
+    }
+
+#endif // ENHANCE_SIMD
+  }
+
+    //#################### 4 Modules ############################
+    //#################### 4.1 Comparison Operators ############################
+    /*
+      
+      This adopts the terminology of std::tuple.
+
+      From http://en.cppreference.com/w/cpp/utility/tuple/operator_cmp:
+
+      Point-wise comparison: Compares every pair of components.
+      
+      Lexicographic comparison: Returns the result of the underlying
+      comparison operator applied to the first pair of components that
+      is not `==`.
+
+      All comparison operators are short-circuited; they do not access
+      tuple elements beyond what is necessary to determine the result
+      of the comparison.
+
+      Specilize e.g. using Comparison, ComparisonPW, ComparisonLEX
+
+     */
+
+  template<class Base>
+  struct ComparisonOp : Base {
+    typedef bool result_t;
+    template<class A, class B>
+    static bool init(A&, B&){ return true; }
+  };
+
+  // Runs of adjacent bitwise comparable members (see 3.0) can only
+  // be compared as a block by `std::equal_to`
+  template<template<class> class Operator>
+  struct PointwiseBlockOp {
+  };
+
+  template<class Derived> struct CachedHashable;
+
+  template<>
+  struct PointwiseBlockOp<std::equal_to> {
+    template<class Value>
+    struct blockable : IsBitwiseComparable<Value> {};
+
+    // objects, that cache their hash (see `CachedHashable`), differ,
+    // if their hashes differ (see 3.2)
+    template<class Target>
+    FORCE_INLINE static bool decide(bool& r, const Target& a, const Target& b){
+      return decideCached(r, a, b, std::is_base_of<CachedHashable<Target>, Target>());
+    }
+
+    static bool applyBlock(bool& r, const char* a, const char* b, size_t n){
+      if(std::memcmp(a, b, n) == 0)
+        return false;
+      r = false;
+      return true;
+    }
+
+    template<class Value>
+    static typename std::enable_if<simd::Supported<Value>::value, bool>::type
+    applyRange(bool& r, const Value* a, const Value* b, size_t n){
+      if(simd::equal(a, b, n))
+        return false;
+      r = false;
+      return true;
+    }
+
+  private:
+    template<class Target>
+    static bool decideCached(bool&, const Target&, const Target&, std::false_type){
+      return false;
+    }
+
+    template<class Target>
+    static bool decideCached(bool& r, const Target& a, const Target& b, std::true_type){
+      if(a.hashValue() == b.hashValue())
+        return false;
+      r = false;
+      return true;
+    }
+  };
+
+  /* Template for point-wise comparison 
+   */
+  template<template<class> class Operator>
+  struct PointwiseComparisonOp : PointwiseBlockOp<Operator> {
+    template<class Value>
+    static bool apply(bool& r, Value&& a, Value&& b){
+      Operator<Value> op;
+      if(op(std::forward<Value>(a),std::forward<Value>(b)))
+        return false;
+      r = false;
+      return true;
+    }
+
+    // used, if all components are scalars (see 3.2)
+    template<class Value>
+    FORCE_INLINE static void applyBranchless(bool& r, const Value& a, const Value& b){
+      r &= bool(Operator<Value>()(a, b));
+    }
+  };
+
+  /* Point-wise comparison without short-circuiting: every pair of
+     components is compared and the results are combined with a
+     bitwise AND, which avoids a (hard to predict) branch per
+     component.
+   */
+  template<template<class> class Operator>
+  struct BranchlessPointwiseComparisonOp {
+    template<class Value>
+    FORCE_INLINE static bool apply(bool& r, const Value& a, const Value& b){
+      r &= bool(Operator<Value>()(a, b));
+      return false;
+    }
+  };
+
+  /* Three-way comparison of a single pair of values. The result is
+     negative, zero or positive, if `a` is less than, equal to or
+     greater than `b`.
+
+     Types with a `compare` member (like `std::string` or classes
+     inheriting `ThreeWayComparable`) use it, arithmetic types,
+     enums and pointers are compared directly (NaNs are equivalent to
+     everything) and containers, for which `IsLexicographic` is true
+     (`std::vector` and `std::array`), element by element (the shorter
+     one is less, if it is a prefix of the other). Everything else
+     falls back to `==` and `<`, so a class' own `operator<` is used.
+     Specialize `ThreeWay` to provide a single pass implementation for
+     other types, or `IsLexicographic` for other containers, whose
+     `<` compares their elements lexicographically.
+   */
+  template<class Value, class Enable = void>
+  struct HasCompareMember : std::false_type {};
+
+  template<class Value>
+  struct HasCompareMember<Value, typename Void<decltype(
+      std::declval<const Value&>().compare(std::declval<const Value&>()))>::type>
+    : std::true_type {};
+
+  template<class Value>
+  struct IsLexicographic : std::false_type {};
+
+  template<class Element, class Allocator>
+  struct IsLexicographic<std::vector<Element, Allocator> > : std::true_type {};
+
+  template<class Element, size_t n>
+  struct IsLexicographic<std::array<Element, n> > : std::true_type {};
+
+  template<class Value, class Enable = void>
+  struct ThreeWay {
+    int operator()(const Value& a, const Value& b) const{
+      if(a == b) return 0;
+      return a < b ? -1 : 1;
+    }
+  };
+
+  template<class Value>
+  struct ThreeWay<Value, typename std::enable_if<
+                           std::is_arithmetic<Value>::value ||
+                           std::is_enum<Value>::value ||
+                           std::is_pointer<Value>::value>::type> {
+    FORCE_INLINE int operator()(const Value& a, const Value& b) const{
+      return (b < a) - (a < b);
+    }
+  };
+
+  template<class Value>
+  struct ThreeWay<Value, typename std::enable_if<HasCompareMember<Value>::value>::type> {
+    FORCE_INLINE int operator()(const Value& a, const Value& b) const{
+      return a.compare(b);
+    }
+  };
+
+  template<class Value>
+  struct ThreeWay<Value, typename std::enable_if<
+                           IsLexicographic<Value>::value &&
+                           !HasCompareMember<Value>::value>::type> {
+    typedef typename std::decay<
+      decltype(*std::declval<const Value&>().begin())>::type Element;
+
+    int operator()(const Value& a, const Value& b) const{
+      auto i = a.begin(), j = b.begin();
+      const auto iEnd = a.end(), jEnd = b.end();
+      for(; i != iEnd && j != jEnd; ++i, ++j)
+        if(const int c = ThreeWay<Element>()(*i, *j))
+          return c;
+      return int(j == jEnd) - int(i == iEnd);
+    }
+  };
+
+  template<class Value>
+  FORCE_INLINE int threeWay(const Value& a, const Value& b){
+    return ThreeWay<Value>()(a, b);
+  }
+
+  // whether `a` and `b` are unordered, i.e. one is a NaN
+  template<class Value>
+  FORCE_INLINE typename std::enable_if<!std::is_floating_point<Value>::value, bool>::type
+  unordered(const Value&, const Value&){
+    return false;
+  }
+
+  template<class Value>
+  FORCE_INLINE typename std::enable_if<std::is_floating_point<Value>::value, bool>::type
+  unordered(const Value& a, const Value& b){
+    return a != a || b != b;
+  }
+
+  /* Template for lexicographic comparison. Every pair of components
+     is only visited once, using `ThreeWay`. The sign of the first
+     non-zero result is then passed to `Operator<int>`. Like `==`
+     followed by `Operator`, the comparison is false at the first
+     pair, that is unordered.
+   */
+  template<template<class> class Operator>
+  struct LexicographicalComparisonOp {
+    template<class Value>
+    static bool apply(bool& r, Value&& a, Value&& b){
+      int c = threeWay(a, b);
+      if(c == 0){
+        if(!unordered(a, b)) return false;
+        r = false;
+        return true;
+      }
+      r = Operator<int>()(c, 0);
+      return true;
+    }
+  };
+
+  /* Three-way lexicographic comparison of all components. The result
+     is the `ThreeWay` result of the first pair of components that is
+     not equal, or zero.
+   */
+  struct ThreeWayOp {
+    typedef int result_t;
+
+    template<class A, class B>
+    static int init(A&, B&){ return 0; }
+
+    template<class Value>
+    static bool apply(int& r, Value&& a, Value&& b){
+      r = threeWay(a, b);
+      return r != 0;
+    }
+  };
+
+  // Combiner aliases for the different operator types and single operators
   template<class Operator, class Target>
   using Comparison = BinaryCombiner<
     ComparisonOp<Operator>, const Target>;
@@ -711,6 +1706,10 @@ namespace enhance {
   using ComparisonPW = Comparison<
     PointwiseComparisonOp<Operator>, Target>;
 
+  template<template<class> class Operator, class Target>
+  using ComparisonPWBranchless = Comparison<
+    BranchlessPointwiseComparisonOp<Operator>, Target>;
+
   template<template<class> class Operator, class Target>
   using ComparisonLEX = Comparison<
     LexicographicalComparisonOp<Operator>, Target>;
@@ -745,6 +1744,27 @@ namespace enhance {
   template<class Target>
   using GreaterEqualPW = ComparisonPW<std::greater_equal, Target>;
 
+  template<class Target>
+  using EqualBranchless = ComparisonPWBranchless<std::equal_to, Target>;
+
+  template<class Target>
+  using UnequalBranchless = ComparisonPWBranchless<std::not_equal_to, Target>;
+
+  template<class Target>
+  using LessPWBranchless = ComparisonPWBranchless<std::less, Target>;
+
+  template<class Target>
+  using GreaterPWBranchless = ComparisonPWBranchless<std::greater, Target>;
+
+  template<class Target>
+  using LessEqualPWBranchless = ComparisonPWBranchless<std::less_equal, Target>;
+
+  template<class Target>
+  using GreaterEqualPWBranchless = ComparisonPWBranchless<std::greater_equal, Target>;
+
+  template<class Target>
+  using Compare = BinaryCombiner<ThreeWayOp, const Target>;
+
   // factory functions for template argument deduction:
   
   template<class Target>
@@ -767,6 +1787,21 @@ namespace enhance {
     return Greater<const Target>(x,y);
   }
 
+  template<class Target>
+  LessEqual<const Target> lessEqual(const Target& x,const Target& y){
+    return LessEqual<const Target>(x,y);
+  }
+  
+  template<class Target>
+  GreaterEqual<const Target> greaterEqual(const Target& x,const Target& y){
+    return GreaterEqual<const Target>(x,y);
+  }
+
+  template<class Target>
+  Compare<const Target> compare(const Target& x,const Target& y){
+    return Compare<const Target>(x,y);
+  }
+
   template<class Target>
   LessEqualPW<const Target> lessEqualPW(const Target& x,const Target& y){
     return LessEqualPW<const Target>(x,y);
@@ -776,6 +1811,36 @@ namespace enhance {
   GreaterEqualPW<const Target> greaterEqualPW(const Target& x,const Target& y){
     return GreaterEqualPW<const Target>(x,y);
   }
+
+  template<class Target>
+  EqualBranchless<const Target> equalBranchless(const Target& x,const Target& y){
+    return EqualBranchless<const Target>(x,y);
+  }
+
+  template<class Target>
+  UnequalBranchless<const Target> unequalBranchless(const Target& x,const Target& y){
+    return UnequalBranchless<const Target>(x,y);
+  }
+
+  template<class Target>
+  LessPWBranchless<const Target> lessPWBranchless(const Target& x,const Target& y){
+    return LessPWBranchless<const Target>(x,y);
+  }
+
+  template<class Target>
+  GreaterPWBranchless<const Target> greaterPWBranchless(const Target& x,const Target& y){
+    return GreaterPWBranchless<const Target>(x,y);
+  }
+
+  template<class Target>
+  LessEqualPWBranchless<const Target> lessEqualPWBranchless(const Target& x,const Target& y){
+    return LessEqualPWBranchless<const Target>(x,y);
+  }
+
+  template<class Target>
+  GreaterEqualPWBranchless<const Target> greaterEqualPWBranchless(const Target& x,const Target& y){
+    return GreaterEqualPWBranchless<const Target>(x,y);
+  }
   
   template<class Target>
   LessPW<const Target> lessPW(const Target& x,const Target& y){
@@ -858,6 +1923,15 @@ namespace enhance {
       return unequal(static_cast<const Derived&>(*this), y);
     }
   };
+
+  // provides `compare`, which is picked up by `ThreeWay`, so nested
+  // enhanced classes are also compared in a single pass
+  template<class Derived>
+  struct ThreeWayComparable {
+    int compare(const Derived& y) const{
+      return enhance::compare(static_cast<const Derived&>(*this), y);
+    }
+  };
     //#################### 4.2 Arithmetic Operators ############################
 
     //#################### 4.2.1 componentwise addition and subtraction ############################
@@ -877,6 +1951,13 @@ namespace enhance {
       a += std::forward<Value2>(b);
       return false;
     }
+
+    template<class Value>
+    static typename std::enable_if<simd::Supported<Value>::value, bool>::type
+    applyRange(Nothing&, Value* a, const Value* b, size_t n){
+      simd::zip<simd::Add>(a, b, n);
+      return false;
+    }
   };
   
   struct SubtractionOp {
@@ -887,6 +1968,13 @@ namespace enhance {
       a -= std::forward<Value2>(b);
       return false;
     }
+
+    template<class Value>
+    static typename std::enable_if<simd::Supported<Value>::value, bool>::type
+    applyRange(Nothing&, Value* a, const Value* b, size_t n){
+      simd::zip<simd::Sub>(a, b, n);
+      return false;
+    }
   };
   
   // Combiner aliases
@@ -947,6 +2035,15 @@ namespace enhance {
       r += std::forward<Value>(a) * std::forward<Value>(b);
       return false;
     }
+
+    // only if the product is computed in `Scalar` anyway
+    template<class Value>
+    static typename std::enable_if<simd::Supported<Value>::value &&
+                                   std::is_same<Scalar, Value>::value, bool>::type
+    applyRange(Scalar& r, const Value* a, const Value* b, size_t n){
+      r += simd::dot(a, b, n);
+      return false;
+    }
   };
 
   template<class Scalar, class Target>
@@ -979,6 +2076,15 @@ namespace enhance {
       a *= r;
       return false;
     }
+
+    template<class Value>
+    static typename std::enable_if<simd::Supported<Value>::value &&
+                                   std::is_same<typename std::decay<Scalar>::type,
+                                                Value>::value, bool>::type
+    applyRange(Scalar& r, Value* a, size_t n){
+      simd::scalar<simd::Mul>(a, Value(r), n);
+      return false;
+    }
   };
 
   template<class Scalar>
@@ -990,6 +2096,16 @@ namespace enhance {
       a /= r;
       return false;
     }
+
+    // integer division is not vectorized
+    template<class Value>
+    static typename std::enable_if<simd::SupportedFloat<Value>::value &&
+                                   std::is_same<typename std::decay<Scalar>::type,
+                                                Value>::value, bool>::type
+    applyRange(Scalar& r, Value* a, size_t n){
+      simd::scalar<simd::Div>(a, Value(r), n);
+      return false;
+    }
   };
 
   template<class Op, class Target>
@@ -1080,6 +2196,18 @@ namespace enhance {
       a=b;
       return false;
     }
+
+    // runs of adjacent trivially copyable members are copied at once
+    template<class Value>
+    struct blockable : std::integral_constant<bool,
+      std::is_trivially_copyable<Value>::value &&
+      !std::is_const<Value>::value> {};
+
+    static bool applyBlock(result_t&, char* a, const char* b, size_t n){
+      if(a != b)
+        std::memcpy(a, b, n);
+      return false;
+    }
   };
 
   // Combiner alias
@@ -1112,6 +2240,26 @@ namespace enhance {
 
    */
 
+  // hash of a run of bytes, used for runs of adjacent bitwise
+  // comparable members (see 3.0)
+  inline size_t hashBytes(const char* p, size_t n){
+    const uint64_t kMul = 0x9ddfea08eb382d69ULL;
+    uint64_t h = n * kMul, k;
+    for(; n >= 8; n -= 8, p += 8){
+      std::memcpy(&k, p, 8);
+      h = (h ^ (k * kMul)) * kMul;
+      h ^= h >> 47;
+    }
+    if(n){
+      k = 0;
+      std::memcpy(&k, p, n);
+      h = (h ^ (k * kMul)) * kMul;
+      h ^= h >> 47;
+    }
+    h *= kMul;
+    return size_t(h ^ (h >> 47));
+  }
+
   // default implementation taken from CityHash's Hash128to64
   struct DefaultHashCombiner {
     FORCE_INLINE void operator()(size_t& result, size_t hash){
@@ -1156,19 +2304,147 @@ namespace enhance {
       combiner(r, hasher(v));
       return false;
     }
-  };
-
-  // Combiner alias
-  template<class Target, template<class> class Hasher=std::hash,
-           class HashCombiner=DefaultHashCombiner>
-  using Hash = UnaryCombiner<HashOp<Hasher, HashCombiner> ,const Target>;
+
+    // runs of adjacent bitwise comparable members are hashed as one
+    // block of bytes, unless a custom `Hasher` is given
+    template<class Value>
+    struct blockable : std::integral_constant<bool,
+      IsBitwiseComparable<Value>::value &&
+      std::is_same<Hasher<Value>, std::hash<Value> >::value> {};
+
+    static bool applyBlock(result_t& r, const char* x, size_t n){
+      HashCombiner combiner;
+      combiner(r, hashBytes(x, n));
+      return false;
+    }
+  };
+
+  // streaming hash of all values using `StreamHasher` (see below)
+  template<class StreamHasher>
+  struct Streaming {};
+
+  // a `StreamHasher`, that is fed the canonical, platform independent
+  // representation of the values (see `StableHash`) instead of their
+  // object representation
+  template<class StreamHasher>
+  struct Canonical : StreamHasher {};
+
+  template<class StreamHasher>
+  struct IsCanonical : std::false_type {};
+
+  template<class StreamHasher>
+  struct IsCanonical<Canonical<StreamHasher> > : std::true_type {};
+
+  template<class Target, class StreamHasher>
+  struct StreamingHash;
+
+  template<class Target, template<class> class Hasher, class HashCombiner>
+  struct HashSelect {
+    typedef UnaryCombiner<HashOp<Hasher, HashCombiner>, const Target> type;
+  };
+
+  template<class Target, template<class> class Hasher, class StreamHasher>
+  struct HashSelect<Target, Hasher, Streaming<StreamHasher> > {
+    typedef StreamingHash<const Target, StreamHasher> type;
+  };
+
+  // Combiner alias. `Hash<T, std::hash, Streaming<WyHash>>` selects
+  // the streaming hash.
+  template<class Target, template<class> class Hasher=std::hash,
+           class HashCombiner=DefaultHashCombiner>
+  using Hash = typename HashSelect<Target, Hasher, HashCombiner>::type;
 
 
   // factory functions for template argument deduction:
   template<class Target, template<class> class Hasher=std::hash,
            class HashCombiner=DefaultHashCombiner>
-  Hash<Target> hash(Target& x){
-    return Hash<Target>(x);
+  Hash<Target, Hasher, HashCombiner> hash(Target& x){
+    return Hash<Target, Hasher, HashCombiner>(x);
+  }
+
+  /*
+    Batch hashing
+
+    `hashMany(first, n, out)` writes the hashes of `n` objects to
+    `out`. Every object is hashed by `Hash<T>`, including specialized
+    `enhance(Hash<T>&)` members, so the results are identical to `hash`.
+    The objects ahead are prefetched. The hashes are not mixed in SIMD
+    lanes: the 64-bit multiplications of `DefaultHashCombiner` do not
+    vectorize without AVX-512, and interleaving several objects in one
+    loop measured no faster (`./benchmark batch_hash`).
+   */
+
+  // objects prefetched ahead of the one being hashed
+  const size_t hashManyPrefetch = 8;
+
+  template<template<class> class Hasher=std::hash,
+           class HashCombiner=DefaultHashCombiner, class Target>
+  void hashMany(const Target* first, size_t n, size_t* out){
+    for(size_t i = 0; i < n; ++i){
+      if(i + hashManyPrefetch < n)
+        ENHANCE_PREFETCH(first + i + hashManyPrefetch);
+      out[i] = Hash<const Target, Hasher, HashCombiner>(first[i]);
+    }
+  }
+
+  template<template<class> class Hasher=std::hash,
+           class HashCombiner=DefaultHashCombiner, class Target>
+  void hashMany(const std::vector<Target>& x, std::vector<size_t>& out){
+    out.resize(x.size());
+    hashMany<Hasher, HashCombiner>(x.data(), x.size(), out.data());
+  }
+
+  // base class that stores the result of `hash` inside the object.
+  // It is computed on first use and reused by `ENHANCE_STD_HASH`,
+  // and `Equal` (and thereby `==` and `equal`) compares the stored
+  // hashes before the members (see `PointwiseBlockOp<std::equal_to>`).
+  // So objects, that are equal, need to have equal hashes, as for
+  // unordered containers.
+  //
+  // Call `invalidateHash()` after modifying a member. Custom copy
+  // assignments (e.g. `ENHANCE_COPY_ASSIGMENT`) do not assign the
+  // base and therefore have to call it, too.
+  //
+  // The lazy computation is not synchronized: compute the hash
+  // before sharing an object between threads.
+  template<class Derived>
+  struct CachedHashable {
+    size_t hashValue() const{
+      if(!hashCached){
+        cachedHash = hash(static_cast<const Derived&>(*this));
+        hashCached = true;
+      }
+      return cachedHash;
+    }
+
+    void invalidateHash() const{
+      hashCached = false;
+    }
+
+    bool operator==(const Derived& y) const{
+      return equal(static_cast<const Derived&>(*this), y);
+    }
+
+  protected:
+    CachedHashable() : cachedHash(0), hashCached(false) {}
+
+  private:
+    mutable size_t cachedHash;
+    mutable bool   hashCached;
+  };
+
+  template<class Target>
+  typename std::enable_if<std::is_base_of<CachedHashable<Target>, Target>::value,
+                          size_t>::type
+  hashValue(const Target& x){
+    return x.hashValue();
+  }
+
+  template<class Target>
+  typename std::enable_if<!std::is_base_of<CachedHashable<Target>, Target>::value,
+                          size_t>::type
+  hashValue(const Target& x){
+    return hash(x);
   }
 
 // custom specialization of std::hash can be injected in namespace std
@@ -1176,150 +2452,5741 @@ namespace enhance {
   namespace std{                                             \
     template<> struct hash<TARGET> {                         \
       std::size_t operator()(const TARGET& s) const {        \
-        return enhance::hash(s);                             \
+        return enhance::hashValue(s);                        \
       }                                                      \
     };                                                       \
   }
-    
-    //#################### 4.5 Serialization functionality ############################
+
   /*
+    Streaming hash (hash_append)
+
+    Instead of hashing every value on its own and combining the
+    results, all values feed their bytes into one `StreamHasher`,
+    which is finalized once per object. A `StreamHasher` has
+
+      typedef ... result_type;
+      void operator()(const void* data, size_t n); // appends bytes
+      explicit operator result_type();             // finalizes
+
+    `WyHash` and `XXH64` are provided.
+
+    `HashAppend<Value>` appends a single value:
+
+    - integers, enums and pointers: their bytes
+    - floating point values: their bytes, -0.0 as 0.0
+    - strings and `std::vector`s: their elements, followed by the size
+    - classes with an `enhance` member: their accessed values
+    - everything else: its `std::hash` value
+
+    Elements of `Range` accessors are followed by their number, too.
+    Specialize `HashAppend` to support other types.
    */
 
-  template<class Archive, class Operator>
-  struct SerializeOp : Operator {
-    typedef Archive& result_t;
+  template<class StreamHasher, class Target> struct HashAppender;
+
+  template<class StreamHasher, class Value>
+  FORCE_INLINE void hashAppend(StreamHasher& h, const Value& v);
+
+  template<class StreamHasher, class Value, class Enable = void>
+  struct HashAppend {
+    static_assert(!IsCanonical<StreamHasher>::value,
+                  "no canonical representation, specialize `HashAppend`");
+
+    static void apply(StreamHasher& h, const Value& v){
+      hashAppend(h, std::hash<Value>()(v));
+    }
   };
 
-  struct LoadOp {
-    template<class Archive, class Value>
-    static bool apply(Archive& a, Value& v)
-    {
-      a >> v;
-      return false;
+  // bitwise comparable classes are hashed by their bytes (see below)
+  template<class StreamHasher, class Value>
+  struct HashAppend<StreamHasher, Value, typename std::enable_if<
+      !(IsBitwiseComparable<Value>::value && !IsCanonical<StreamHasher>::value),
+      typename Void<decltype(std::declval<const Value&>().enhance(
+        std::declval<HashAppender<StreamHasher, const Value>&>()))>::type>::type> {
+    static void apply(StreamHasher& h, const Value& v){
+      HashAppender<StreamHasher, const Value>(v, h).callEnhance();
     }
   };
 
-  struct SaveOp {
-    template<class Archive, class Value>
-    static bool apply(Archive& a, const Value& v)
-    {
-      a << v;
-      return false;
+  template<class StreamHasher, class Value>
+  struct HashAppend<StreamHasher, Value, typename std::enable_if<
+                                           IsBitwiseComparable<Value>::value &&
+                                           !IsCanonical<StreamHasher>::value>::type> {
+    FORCE_INLINE static void apply(StreamHasher& h, const Value& v){
+      h(std::addressof(v), sizeof(Value));
     }
   };
 
-  // Combiner aliases
-  template<class Archive, class Operator, class Target>
-  using Serialize = UnaryCombiner<SerializeOp<Archive, Operator>,Target>;
+  template<class StreamHasher, class Value>
+  struct HashAppend<StreamHasher, Value, typename std::enable_if<
+                                           std::is_floating_point<Value>::value &&
+                                           !IsCanonical<StreamHasher>::value>::type> {
+    FORCE_INLINE static void apply(StreamHasher& h, Value v){
+      if(v == 0)
+        v = 0;
+      h(&v, sizeof(Value));
+    }
+  };
 
-  template<class Archive, class Target>
-  using Save = Serialize<Archive, SaveOp, Target>;
+  template<class StreamHasher>
+  struct HashAppend<StreamHasher, std::string, typename std::enable_if<
+                                                 !IsCanonical<StreamHasher>::value>::type> {
+    FORCE_INLINE static void apply(StreamHasher& h, const std::string& v){
+      h(v.data(), v.size());
+      hashAppend(h, v.size());
+    }
+  };
 
-  template<class Archive, class Target>
-  using Load = Serialize<Archive, LoadOp, Target>;
+  template<class StreamHasher, class Value, class Allocator>
+  struct HashAppend<StreamHasher, std::vector<Value, Allocator>, typename std::enable_if<
+                                           !IsCanonical<StreamHasher>::value>::type> {
+    static void apply(StreamHasher& h, const std::vector<Value, Allocator>& v){
+      appendElements(h, v.data(), v.size(), IsBitwiseComparable<Value>());
+      hashAppend(h, v.size());
+    }
 
-  template<class Archive, class Target>
-  using SerializeSplit = Serialize
-    <Archive, typename std::conditional<Archive::is_saving::value,
-                                        SaveOp, LoadOp>::type,
-     Target>;
-  
-  // factory functions for template argument deduction:
-  template<class Archive, class Target>
-  SerializeSplit<Archive, Target> serialize
-    (Target& x, Archive& ar){
-    return SerializeSplit<Archive, Target>(x, ar);
-  }
+  private:
+    static void appendElements(StreamHasher& h, const Value* x, size_t n,
+                               std::true_type){
+      h(x, n * sizeof(Value));
+    }
 
-  //base function for `serialize` member function inheritance
-  template<class Derived>
-  struct Serializable {
-    
-    template<class Archive>
-    void serialize(Archive &ar, const unsigned int version){
-      enhance::serialize(static_cast<Derived&>(*this),
-                         ar).callEnhance();
+    static void appendElements(StreamHasher& h, const Value* x, size_t n,
+                               std::false_type){
+      for(size_t i = 0; i < n; ++i)
+        hashAppend(h, x[i]);
     }
   };
 
-    //############ 4.6 string conversion / pretty printing  functionality ###############
-  struct InsertionOp {
-    typedef std::ostream& result_t;
-    
+  template<class StreamHasher, class Value>
+  FORCE_INLINE void hashAppend(StreamHasher& h, const Value& v){
+    HashAppend<StreamHasher, Value>::apply(h, v);
+  }
+
+  template<class StreamHasher>
+  struct HashAppendOp {
+    typedef StreamHasher& result_t;
+
     template<class Value>
-    static bool apply(result_t& r, Value&& a){
-      r << a;
+    static bool apply(result_t h, const Value& v){
+      hashAppend(h, v);
+      return false;
+    }
+
+    // runs of adjacent bitwise comparable members are appended at
+    // once, i.e. the same bytes in one call
+    template<class Value>
+    struct blockable : std::integral_constant<bool,
+      IsBitwiseComparable<Value>::value && !IsCanonical<StreamHasher>::value> {};
+
+    static bool applyBlock(result_t h, const char* x, size_t n){
+      h(x, n);
       return false;
     }
   };
 
-  template<char delim1, char sep1, char sep2, char delim2, bool Grouping, class Target>
-  struct Insertion : UnaryCombiner<InsertionOp,Target,
-                                   Insertion<delim1, sep1, sep2, delim2, Grouping, Target>> {
+  // appends the accessed values of `target` to a `StreamHasher`
+  template<class StreamHasher, class Target>
+  struct HashAppender : UnaryCombiner<HashAppendOp<StreamHasher>, Target,
+                                      HashAppender<StreamHasher, Target> > {
 
-    bool first;
-    
-    FORCE_INLINE Insertion(Target& target,
-                           std::ostream& result)
-      : Insertion::UnaryCombiner(target, result)
-      , first(true){
-      result << delim1;
+    FORCE_INLINE HashAppender(Target& target, StreamHasher& h)
+      : HashAppender::UnaryCombiner(target, h){};
+
+    using HashAppender::UnaryCombiner::singleStep;
+
+    // the elements of a range, followed by their number
+    template<class A,class B>
+    FORCE_INLINE bool singleStep(Range<A,B> ac){
+      if(this->flushRun()) return true;
+      auto   b = access(ac.a,this->target);
+      auto&& e = access(ac.b,this->target);
+      typedef decltype(b) it_t;
+      hashAppend(this->result, appendRange(b, e, std::integral_constant<bool,
+        !IsCanonical<StreamHasher>::value && Contiguous<it_t>::value &&
+        std::is_same<it_t, typename std::decay<decltype(e)>::type>::value &&
+        IsBitwiseComparable<typename std::iterator_traits<it_t>::value_type>::value>()));
+      return false;
+    }
+
+  private:
+    // returns the number of elements
+    template<class It, class End>
+    FORCE_INLINE size_t appendRange(It b, End& e, std::false_type){
+      size_t n = 0;
+      for(; b<e; ++b, ++n)
+        hashAppend(this->result, *b);
+      return n;
+    }
+
+    // contiguous elements are appended in one call
+    template<class It>
+    FORCE_INLINE size_t appendRange(It b, const It& e, std::true_type){
+      if(!(b<e)) return 0;
+      size_t n = e - b;
+      this->result(Contiguous<It>::pointer(b), n * sizeof(*Contiguous<It>::pointer(b)));
+      return n;
+    }
+  };
+
+  // hash of a single object, finalized once
+  template<class Target, class StreamHasher>
+  struct StreamingHash {
+    typedef typename StreamHasher::result_type result_t;
+
+    Target& target;
+
+    FORCE_INLINE StreamingHash(Target& target) : target(target){};
+
+    FORCE_INLINE operator result_t() const{
+      StreamHasher h;
+      HashAppender<StreamHasher, Target>(target, h).callEnhance();
+      return result_t(h);
+    }
+
+    // hash using the given accessors
+    template<class... Accessors>
+    FORCE_INLINE result_t operator()(Accessors... acs) const{
+      StreamHasher h;
+      HashAppender<StreamHasher, Target>(target, h)(acs...);
+      return result_t(h);
+    }
+
+    struct Functor{
+      size_t operator()(Target& target) const{
+        return size_t(result_t(StreamingHash(target)));
+      }
     };
+  };
 
-    void beforeStep(){
-      if(!first)
-        this->result << sep1 << sep2;
-      else
-        first = false;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define ENHANCE_BIG_ENDIAN
+#endif
+
+  namespace hashing {
+
+    // little endian reads, so the hashers give the same results on
+    // all platforms
+    FORCE_INLINE uint64_t read64(const unsigned char* p){
+      uint64_t v;
+      std::memcpy(&v, p, 8);
+#ifdef ENHANCE_BIG_ENDIAN
+      v = __builtin_bswap64(v);
+#endif
+      return v;
     }
 
-    using Insertion::UnaryCombiner::singleStep;
-    
-    //specialization for `Range` accessors
-			template<int begin, int end, class Accessor>
-      FORCE_INLINE bool singleStep(FromTo<begin, end, Accessor> ac){
-        return wrap(ac);
+    FORCE_INLINE uint32_t read32(const unsigned char* p){
+      uint32_t v;
+      std::memcpy(&v, p, 4);
+#ifdef ENHANCE_BIG_ENDIAN
+      v = __builtin_bswap32(v);
+#endif
+      return v;
     }
 
-    //specialization for `Range` accessors
-    template<class A,class B>
-    FORCE_INLINE bool singleStep(Range<A,B> ac) {
-      return wrap(ac);
+    FORCE_INLINE uint64_t rotl(uint64_t x, int r){
+      return (x << r) | (x >> (64 - r));
     }
-    
-    template<class Accessor> bool wrap(Accessor ac)
-    {
-      if(Grouping){
-        beforeStep();
-        Insertion<delim1, sep1, sep2, delim2, false, Target>
-          (this->target, this->result)(ac);
-        return false;
+
+    // 64 x 64 -> 128 bit multiplication, folded to 64 bits
+    FORCE_INLINE uint64_t mum(uint64_t a, uint64_t b){
+#ifdef __SIZEOF_INT128__
+      __uint128_t r = (__uint128_t)a * b;
+      return uint64_t(r) ^ uint64_t(r >> 64);
+#else
+      uint64_t ha = a >> 32, hb = b >> 32, la = uint32_t(a), lb = uint32_t(b);
+      uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+      uint64_t t = rl + (rm0 << 32), c = t < rl;
+      uint64_t lo = t + (rm1 << 32);
+      c += lo < t;
+      uint64_t hi = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+      return lo ^ hi;
+#endif
+    }
+  }
+
+  /* wyhash-style hasher: every appended piece of bytes is mixed into
+     the state with a folded 128 bit multiplication, using wyhash's
+     reads of short inputs. This is fast for the small pieces of
+     single values, but unlike `XXH64` the result depends on how the
+     bytes are split into calls (which is the same for all objects of
+     a type). Not bit-compatible with wyhash.
+   */
+  struct WyHash {
+    typedef uint64_t result_type;
+
+    explicit WyHash(uint64_t seed = 0)
+      : seed(seed ^ 0xa0761d6478bd642fULL), total(0){}
+
+    FORCE_INLINE void operator()(const void* data, size_t n){
+      using namespace hashing;
+      const unsigned char* p = static_cast<const unsigned char*>(data);
+      uint64_t a, b;
+      if(n <= 16){
+        if(n >= 4){
+          const size_t d = (n >> 3) << 2;
+          a = (uint64_t(read32(p)) << 32) | read32(p + d);
+          b = (uint64_t(read32(p + n - 4)) << 32) | read32(p + n - 4 - d);
+        }else if(n > 0){
+          a = (uint64_t(p[0]) << 16) | (uint64_t(p[n >> 1]) << 8) | p[n - 1];
+          b = 0;
+        }else
+          a = b = 0;
+      }else{
+        size_t i = n;
+        for(; i > 16; i -= 16, p += 16)
+          seed = mum(read64(p) ^ 0xe7037ed1a0b428dbULL, read64(p + 8) ^ seed);
+        a = read64(p + i - 16);
+        b = read64(p + i - 8);
       }
-      return Insertion::UnaryCombiner::singleStep(ac);
+      seed = mum(a ^ 0xe7037ed1a0b428dbULL, b ^ seed ^ n);
+      total += n;
     }
 
-    void finalize()
-    {
-      this->result << delim2;
+    explicit operator result_type() const{
+      return hashing::mum(seed ^ 0x8ebc6af09c88c6e3ULL,
+                          total ^ 0x589965cc75374cc3ULL);
+    }
+
+  private:
+    uint64_t seed, total;
+  };
+
+  // streaming XXH64 (https://github.com/Cyan4973/xxHash)
+  struct XXH64 {
+    typedef uint64_t result_type;
+
+    explicit XXH64(uint64_t seed = 0)
+      : seed(seed), total(0), used(0){
+      v[0] = seed + P1 + P2;
+      v[1] = seed + P2;
+      v[2] = seed;
+      v[3] = seed - P1;
+    }
+
+    FORCE_INLINE void operator()(const void* data, size_t n){
+      if(used + n < 32){
+        std::memcpy(buffer + used, data, n);
+        used += n;
+        total += n;
+        return;
+      }
+      update(static_cast<const unsigned char*>(data), n);
+    }
+
+    explicit operator result_type() const{
+      using namespace hashing;
+      uint64_t h;
+      if(total >= 32){
+        h = rotl(v[0], 1) + rotl(v[1], 7) + rotl(v[2], 12) + rotl(v[3], 18);
+        for(int i = 0; i < 4; ++i)
+          h = (h ^ round(0, v[i])) * P1 + P4;
+      }else
+        h = seed + P5;
+      h += total;
+      const unsigned char* p = buffer;
+      const unsigned char* end = buffer + used;
+      for(; p + 8 <= end; p += 8)
+        h = rotl(h ^ round(0, read64(p)), 27) * P1 + P4;
+      if(p + 4 <= end){
+        h = rotl(h ^ (uint64_t(read32(p)) * P1), 23) * P2 + P3;
+        p += 4;
+      }
+      for(; p < end; ++p)
+        h = rotl(h ^ (*p * P5), 11) * P1;
+      h ^= h >> 33;
+      h *= P2;
+      h ^= h >> 29;
+      h *= P3;
+      h ^= h >> 32;
+      return h;
+    }
+
+  private:
+    static const uint64_t P1 = 11400714785074694791ULL;
+    static const uint64_t P2 = 14029467366897019727ULL;
+    static const uint64_t P3 = 1609587929392839161ULL;
+    static const uint64_t P4 = 9650029242287828579ULL;
+    static const uint64_t P5 = 2870177450012600261ULL;
+
+    uint64_t v[4], seed, total;
+    size_t used;
+    unsigned char buffer[32];
+
+    static FORCE_INLINE uint64_t round(uint64_t acc, uint64_t input){
+      return hashing::rotl(acc + input * P2, 31) * P1;
+    }
+
+    FORCE_INLINE void stripe(const unsigned char* p){
+      for(int i = 0; i < 4; ++i)
+        v[i] = round(v[i], hashing::read64(p + 8 * i));
+    }
+
+    // fills the buffer and consumes complete stripes
+    void update(const unsigned char* p, size_t n){
+      total += n;
+      if(used){
+        size_t k = 32 - used;
+        std::memcpy(buffer + used, p, k);
+        stripe(buffer);
+        p += k;
+        n -= k;
+        used = 0;
+      }
+      for(; n >= 32; n -= 32, p += 32)
+        stripe(p);
+      std::memcpy(buffer, p, n);
+      used = n;
     }
   };
 
+  /*
+    Stable hash
+
+    `StableHash<T>` is the XXH64 (seed 0) of the canonical byte
+    representation of the accessed values, which does not depend on
+    the platform, compiler or standard library:
+
+    - integers, enums and `bool`: 8 bytes, little endian, signed values
+      sign extended, i.e. equal values of different types are equal.
+      `char` is treated as `signed char` and `wchar_t` as unsigned on
+      every platform.
+    - floating point values: converted to `double`, -0.0 to 0.0 and
+      NaNs to the quiet NaN 0x7ff8000000000000, whose 8 bytes are
+      appended in little endian
+    - strings: the length (as integer), followed by the bytes
+    - `std::vector`s and `Range` accessors: the elements, followed by
+      their number (as integer)
+    - classes with an `enhance` member: their accessed values
+
+    Other types fail to compile, unless `HashAppend<Canonical<H>, T>`
+    is specialized. The values are pinned by tests and will not change.
+   */
 
-  // factory functions for template argument deduction:
-  template<char delim1, char sep1, char sep2, char delim2, bool Grouping = true, class Target>
-  Insertion<delim1, sep1, sep2, delim2, Grouping, const Target>
-  insertion(const Target& target, std::ostream& os){
-    return Insertion<delim1, sep1, sep2, delim2, Grouping, const Target>(target, os);
+  namespace hashing {
+
+    // appends the 8 bytes of `v` in little endian order
+    template<class StreamHasher>
+    FORCE_INLINE void appendLittleEndian(StreamHasher& h, uint64_t v){
+#ifdef ENHANCE_BIG_ENDIAN
+      v = __builtin_bswap64(v);
+#endif
+      h(&v, 8);
+    }
   }
 
-  template<char delim1, char sep1, char sep2, char delim2, class Target, bool Grouping = true>
-	struct Insertable{
-		FORCE_INLINE friend std::ostream&
-    operator<<(std::ostream& os, const Target& x){
-			insertion<delim1,sep1,sep2,delim2, Grouping>(x, os).callEnhance();
-			return os;
-		}
-	};
+  namespace hashing {
+
+    // the signedness of `char` and `wchar_t` depends on the platform,
+    // so their canonical representation treats `char` as `signed char`
+    // and `wchar_t` as unsigned (like `char16_t` and `char32_t`)
+    template<class Value>
+    struct CanonicalInteger { typedef Value type; };
+
+    template<>
+    struct CanonicalInteger<char> { typedef signed char type; };
+
+    template<>
+    struct CanonicalInteger<wchar_t> {
+      typedef std::make_unsigned<wchar_t>::type type;
+    };
+  }
+
+  template<class StreamHasher, class Value>
+  struct HashAppend<Canonical<StreamHasher>, Value, typename std::enable_if<
+                      std::is_integral<Value>::value>::type> {
+    FORCE_INLINE static void apply(Canonical<StreamHasher>& h, Value v){
+      typedef typename hashing::CanonicalInteger<Value>::type Narrow;
+      typedef typename std::conditional<std::is_signed<Narrow>::value,
+                                        int64_t, uint64_t>::type Wide;
+      hashing::appendLittleEndian(h, uint64_t(Wide(Narrow(v))));
+    }
+  };
+
+  template<class StreamHasher, class Value>
+  struct HashAppend<Canonical<StreamHasher>, Value, typename std::enable_if<
+                      std::is_enum<Value>::value>::type> {
+    FORCE_INLINE static void apply(Canonical<StreamHasher>& h, Value v){
+      hashAppend(h, typename std::underlying_type<Value>::type(v));
+    }
+  };
+
+  template<class StreamHasher, class Value>
+  struct HashAppend<Canonical<StreamHasher>, Value, typename std::enable_if<
+                      std::is_floating_point<Value>::value>::type> {
+    static_assert(std::numeric_limits<double>::is_iec559,
+                  "the canonical representation needs IEEE 754 doubles");
+
+    FORCE_INLINE static void apply(Canonical<StreamHasher>& h, Value v){
+      double d = double(v);
+      uint64_t bits;
+      if(d == 0)
+        bits = 0;
+      else if(d != d)
+        bits = 0x7ff8000000000000ULL;
+      else
+        std::memcpy(&bits, &d, 8);
+      hashing::appendLittleEndian(h, bits);
+    }
+  };
+
+  template<class StreamHasher>
+  struct HashAppend<Canonical<StreamHasher>, std::string> {
+    FORCE_INLINE static void apply(Canonical<StreamHasher>& h, const std::string& v){
+      hashAppend(h, uint64_t(v.size()));
+      h(v.data(), v.size());
+    }
+  };
+
+  template<class StreamHasher, class Value, class Allocator>
+  struct HashAppend<Canonical<StreamHasher>, std::vector<Value, Allocator> > {
+    static void apply(Canonical<StreamHasher>& h,
+                      const std::vector<Value, Allocator>& v){
+      for(const Value& x : v)
+        hashAppend(h, x);
+      hashAppend(h, uint64_t(v.size()));
+    }
+  };
+
+  // Combiner alias
+  template<class Target, class StreamHasher = XXH64>
+  using StableHash = StreamingHash<const Target, Canonical<StreamHasher> >;
+
+  // factory function for template argument deduction:
+  template<class Target>
+  StableHash<Target> stableHash(const Target& x){
+    return StableHash<Target>(x);
+  }
+
+  /*
+    Incremental hash
+
+    The hash is the sum of the `std::hash` values of all accessed
+    values, each mixed with a salt that identifies its position: data
+    members are salted with their offset in the object, all other
+    values with their position in the accessor list. Elements of
+    ranges are followed by their number, so elements cannot move
+    between adjacent ranges unnoticed. As the sum can be updated, a
+    changed data member is rehashed by `updateHash` without walking
+    the other accessors.
+   */
+
+  struct IncrementalHashState {
+    size_t sum;
+    size_t salt;
+  };
+
+  namespace hashing {
+
+    FORCE_INLINE size_t incrementalTerm(size_t salt, size_t hash){
+      return size_t(mum(uint64_t(hash) ^ 0xa0761d6478bd642fULL,
+                        (uint64_t(salt) + 1) * 0xe7037ed1a0b428dbULL));
+    }
+
+    template<class Target, class Value, class T>
+    FORCE_INLINE size_t memberSalt(const Target& target, Value T::* m){
+      return 2 * size_t(reinterpret_cast<const char*>(&access(m, target)) -
+                        reinterpret_cast<const char*>(&target));
+    }
+
+    FORCE_INLINE size_t positionSalt(size_t position){
+      return 2 * position + 1;
+    }
+  }
+
+  struct IncrementalHashOp{
+    typedef IncrementalHashState& result_t;
+
+    template<class Value>
+    static bool apply(result_t r, const Value& v){
+      r.sum += hashing::incrementalTerm(r.salt, std::hash<Value>()(v));
+      return false;
+    }
+  };
+
+  template<class Target>
+  struct IncrementalHasher : UnaryCombiner<IncrementalHashOp, Target,
+                                           IncrementalHasher<Target> > {
+
+    FORCE_INLINE IncrementalHasher(Target& target, IncrementalHashState& state)
+      : IncrementalHasher::UnaryCombiner(target, state){};
+
+    using IncrementalHasher::UnaryCombiner::singleStep;
+
+    FORCE_INLINE void beforeStep(){
+      this->result.salt = hashing::positionSalt(position++);
+    }
+
+    // data members are salted with their offset, so `updateHash` can
+    // find them without walking the accessor list
+    template<class Value, class T>
+    FORCE_INLINE typename std::enable_if<!std::is_function<Value>::value, bool>::type
+    singleStep(Value T::* ac){
+      this->result.salt = hashing::memberSalt(this->target, ac);
+      return IncrementalHashOp::apply(this->result, access(ac, this->target));
+    }
+
+    template<class A, class B>
+    FORCE_INLINE bool singleStep(Range<A, B> ac){
+      IncrementalHasher::UnaryCombiner::singleStep(ac);
+      const size_t n = size_t(std::distance(access(ac.a, this->target),
+                                            access(ac.b, this->target)));
+      beforeStep();
+      return IncrementalHashOp::apply(this->result, n);
+    }
+
+  private:
+    size_t position = 0;
+  };
+
+  template<class Target>
+  struct IncrementalHash {
+    typedef size_t result_t;
+
+    Target& target;
+
+    FORCE_INLINE IncrementalHash(Target& target) : target(target){};
+
+    FORCE_INLINE operator size_t() const{
+      IncrementalHashState state = {0, 0};
+      IncrementalHasher<Target>(target, state).callEnhance();
+      return state.sum;
+    }
+
+    // hash using the given accessors
+    template<class... Accessors>
+    FORCE_INLINE size_t operator()(Accessors... acs) const{
+      IncrementalHashState state = {0, 0};
+      IncrementalHasher<Target>(target, state)(acs...);
+      return state.sum;
+    }
+
+    struct Functor{
+      size_t operator()(Target& target) const{
+        return IncrementalHash(target);
+      }
+    };
+  };
+
+  template<class Target>
+  IncrementalHash<const Target> incrementalHash(const Target& x){
+    return IncrementalHash<const Target>(x);
+  }
+
+  // the incremental hash of `x` after its data member `m` changed from
+  // `oldValue`, given the previous hash. `m` has to be accessed
+  // directly, i.e. not through a range or another modifier.
+  template<class Target, class Value, class T>
+  size_t updateHash(const Target& x, size_t oldHash, Value T::* m,
+                    const Value& oldValue){
+    size_t salt = hashing::memberSalt(x, m);
+    return oldHash
+      - hashing::incrementalTerm(salt, std::hash<Value>()(oldValue))
+      + hashing::incrementalTerm(salt, std::hash<Value>()(access(m, x)));
+  }
+    
+    //#################### 4.5 Serialization functionality ############################
+  /*
+    Archives with a `saveBinary(const void*, size_t)` or
+    `loadBinary(void*, size_t)` member (marked by `IsBinaryArchive`,
+    e.g. `BinaryWriter` and `BinaryReader` below) save and load runs
+    of adjacent trivially serializable members and contiguous `Range`s
+    of them with a single call.
+   */
+
+  // Types, that are saved and loaded as their object representation
+  // by binary archives. Specialize for your own types (e.g. structs of
+  // numbers).
+  template<class Value>
+  struct IsTriviallySerializable : std::integral_constant<bool,
+    std::is_arithmetic<Value>::value || std::is_enum<Value>::value> {};
+
+  // Values, whose `std::vector`s are saved and loaded with a single
+  // copy (`std::vector<bool>` is not contiguous)
+  template<class Value>
+  struct IsBulkSerializable : std::integral_constant<bool,
+    IsTriviallySerializable<Value>::value && !std::is_same<Value, bool>::value> {};
+
+  template<class Archive>
+  struct IsBinaryArchive : std::false_type {};
+
+  template<class Archive, class Operator, class Enable = void>
+  struct SerializeOp : Operator {
+    typedef Archive& result_t;
+  };
+
+  template<class Archive, class Operator>
+  struct SerializeOp<Archive, Operator, typename std::enable_if<
+                                          IsBinaryArchive<Archive>::value>::type>
+    : Operator {
+    typedef Archive& result_t;
+
+    template<class Value>
+    struct blockable : IsTriviallySerializable<Value> {};
+
+    template<class Value>
+    static typename std::enable_if<IsTriviallySerializable<
+                                     typename std::remove_const<Value>::type>::value,
+                                   bool>::type
+    applyRange(result_t a, Value* x, size_t n){
+      return Operator::applyBlock(a, x, n * sizeof(Value));
+    }
+  };
+
+  /*
+    Contiguous ranges of numbers are saved and loaded with a single
+    archive call, `boost::serialization::make_array` for Boost archives
+    (recognized by `get_library_version`, if Boost is available, see
+    the top of this file) and one call per element for other archives.
+    The number of elements is not saved.
+
+    `container(ac)` accessors save the number of elements in front of
+    them (a `uint64_t`, or the size encoding of native archives, see
+    below), which is used to resize the container on load (step by
+    step, see `LoadOp`). Containers without a `resize` member have to
+    have that number of elements.
+    The native archives overload `saveCount`, `loadCount`,
+    `saveContiguous` and `loadContiguous`.
+   */
+
+  template<class It>
+  struct IsBulkRange : std::integral_constant<bool, Contiguous<It>::value &&
+    IsBulkSerializable<typename std::remove_const<typename std::remove_reference<
+                         decltype(*std::declval<It>())>::type>::type>::value> {};
+
+  template<class Archive>
+  void saveCount(Archive& a, size_t n){
+    const uint64_t count = n;
+    a << count;
+  }
+
+  template<class Archive>
+  size_t loadCount(Archive& a){
+    uint64_t count;
+    a >> count;
+    return size_t(count);
+  }
+
+  // Boost archives, which support `make_array`
+  template<class Archive, class Enable = void>
+  struct IsBoostArchive : std::false_type {};
+
+#ifdef ENHANCE_BOOST_SERIALIZATION
+  template<class Archive>
+  struct IsBoostArchive<Archive, typename Void<decltype(
+      std::declval<const Archive&>().get_library_version())>::type> : std::true_type {};
+
+  template<class Archive, class Value>
+  void saveContiguous(Archive& a, const Value* p, size_t n, std::true_type){
+    a << boost::serialization::make_array(p, n);
+  }
+
+  template<class Archive, class Value>
+  void loadContiguous(Archive& a, Value* p, size_t n, std::true_type){
+    a >> boost::serialization::make_array(p, n);
+  }
+#endif
+
+  template<class Archive, class Value>
+  void saveContiguous(Archive& a, const Value* p, size_t n, std::false_type){
+    for(size_t i = 0; i < n; ++i)
+      a << p[i];
+  }
+
+  template<class Archive, class Value>
+  void loadContiguous(Archive& a, Value* p, size_t n, std::false_type){
+    for(size_t i = 0; i < n; ++i)
+      a >> p[i];
+  }
+
+  template<class Archive, class Value>
+  void saveContiguous(Archive& a, const Value* p, size_t n){
+    saveContiguous(a, p, n, IsBoostArchive<Archive>());
+  }
+
+  template<class Archive, class Value>
+  void loadContiguous(Archive& a, Value* p, size_t n){
+    loadContiguous(a, p, n, IsBoostArchive<Archive>());
+  }
+
+  template<class Container>
+  auto resizeContainer(Container& c, size_t n, int) -> decltype(c.resize(n)){
+    return c.resize(n);
+  }
+
+  template<class Container>
+  void resizeContainer(Container& c, size_t n, long){
+    if(size_t(std::distance(std::begin(c), std::end(c))) != n)
+      throw std::runtime_error("Load: the container has another number of elements");
+  }
+
+  struct LoadOp {
+    template<class Archive, class Value>
+    static bool apply(Archive& a, Value& v)
+    {
+      a >> v;
+      return false;
+    }
+
+    template<class Archive>
+    static bool applyBlock(Archive& a, void* x, size_t n){
+      a.loadBinary(x, n);
+      return false;
+    }
+
+    template<class Archive, class Value>
+    static typename std::enable_if<IsBulkSerializable<Value>::value, bool>::type
+    applyRange(Archive& a, Value* x, size_t n){
+      loadContiguous(a, x, n);
+      return false;
+    }
+
+    template<class Archive, class Container>
+    static bool applyContainer(Archive& a, Container& c){
+      loadContainer(a, c, loadCount(a), 0);
+      return false;
+    }
+
+  private:
+    // bytes of elements allocated before any of them are loaded
+    enum { firstStep = 1 << 16 };
+
+    // grows the container step by step, so that a corrupt number of
+    // elements fails on the missing data, before allocating much more
+    // than was loaded
+    template<class Archive, class Container>
+    static auto loadContainer(Archive& a, Container& c, size_t n, int)
+      -> decltype(void(c.resize(n))){
+      typedef typename std::decay<decltype(*std::begin(c))>::type Value;
+      const size_t first = std::max(size_t(1), size_t(firstStep) / sizeof(Value));
+      size_t done = 0;
+      do{
+        const size_t size = done + std::min(n - done, std::max(done, first));
+        c.resize(size);
+        auto b = std::next(std::begin(c), std::ptrdiff_t(done));
+        loadElements(a, b, size - done, IsBulkRange<decltype(b)>());
+        done = size;
+      }while(done < n);
+    }
+
+    // containers without `resize` have to have `n` elements
+    template<class Archive, class Container>
+    static void loadContainer(Archive& a, Container& c, size_t n, long){
+      resizeContainer(c, n, 0);
+      auto b = std::begin(c);
+      loadElements(a, b, n, IsBulkRange<decltype(b)>());
+    }
+
+    template<class Archive, class It>
+    static void loadElements(Archive& a, It b, size_t n, std::true_type){
+      loadContiguous(a, Contiguous<It>::pointer(b), n);
+    }
+
+    template<class Archive, class It>
+    static void loadElements(Archive& a, It b, size_t n, std::false_type){
+      for(size_t i = 0; i < n; ++i, ++b)
+        a >> *b;
+    }
+  };
+
+  struct SaveOp {
+    template<class Archive, class Value>
+    static bool apply(Archive& a, const Value& v)
+    {
+      a << v;
+      return false;
+    }
+
+    template<class Archive>
+    static bool applyBlock(Archive& a, const void* x, size_t n){
+      a.saveBinary(x, n);
+      return false;
+    }
+
+    template<class Archive, class Value>
+    static typename std::enable_if<IsBulkSerializable<
+                                     typename std::remove_const<Value>::type>::value,
+                                   bool>::type
+    applyRange(Archive& a, Value* x, size_t n){
+      saveContiguous(a, x, n);
+      return false;
+    }
+
+    template<class Archive, class Container>
+    static bool applyContainer(Archive& a, const Container& c){
+      const size_t n = size_t(std::distance(std::begin(c), std::end(c)));
+      saveCount(a, n);
+      auto b = std::begin(c);
+      saveElements(a, b, n, IsBulkRange<decltype(b)>());
+      return false;
+    }
+
+  private:
+    template<class Archive, class It>
+    static void saveElements(Archive& a, It b, size_t n, std::true_type){
+      saveContiguous(a, Contiguous<It>::pointer(b), n);
+    }
+
+    template<class Archive, class It>
+    static void saveElements(Archive& a, It b, size_t n, std::false_type){
+      for(size_t i = 0; i < n; ++i, ++b)
+        a << *b;
+    }
+  };
+
+  // Combiner aliases
+  template<class Archive, class Operator, class Target>
+  using Serialize = UnaryCombiner<SerializeOp<Archive, Operator>,Target>;
+
+  template<class Archive, class Target>
+  using Save = Serialize<Archive, SaveOp, Target>;
+
+  template<class Archive, class Target>
+  using Load = Serialize<Archive, LoadOp, Target>;
+
+  template<class Archive, class Target>
+  using SerializeSplit = Serialize
+    <Archive, typename std::conditional<Archive::is_saving::value,
+                                        SaveOp, LoadOp>::type,
+     Target>;
+  
+  // factory functions for template argument deduction:
+  template<class Archive, class Target>
+  SerializeSplit<Archive, Target> serialize
+    (Target& x, Archive& ar){
+    return SerializeSplit<Archive, Target>(x, ar);
+  }
+
+  //base function for `serialize` member function inheritance
+  template<class Derived>
+  struct Serializable {
+    
+    template<class Archive>
+    void serialize(Archive &ar, const unsigned int version){
+      enhance::serialize(static_cast<Derived&>(*this),
+                         ar).callEnhance();
+    }
+  };
+
+  /*
+    Arenas
+
+    `Arena` is a bump allocator: it hands out memory from blocks of
+    growing size and frees all of it at once with `release` (or keeps
+    the largest block for the next batch with `reset`), which avoids
+    one heap allocation per string and vector. Deallocation is a no-op.
+    Objects in the arena have to be destroyed (or abandoned, if their
+    destructors only free arena memory) before it is reset. Not
+    thread-safe, use one arena per thread. Since C++17 it is also a
+    `std::pmr::memory_resource`.
+
+    Containers with an `ArenaAllocator` (e.g. `ArenaString` and
+    `ArenaVector<T>`) allocate from its arena, or from the heap, if it
+    has none. Binary readers with an arena (`useArena`) load them into
+    their arena (see `bindArena`), including the elements of vectors,
+    which are constructed in place.
+   */
+  class Arena
+#ifdef ENHANCE_PMR
+    : public std::pmr::memory_resource
+#endif
+  {
+  public:
+    explicit Arena(size_t blockSize = 1 << 16)
+      : blockSize(std::max(blockSize, size_t(64))), current(nullptr), used(0), capacity(0),
+        handedOut(0){}
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    ~Arena(){
+      release();
+    }
+
+    // `n` bytes aligned to `align` (a power of 2)
+    void* allocate(size_t n, size_t align = alignof(std::max_align_t)){
+      size_t p = padded(align);
+      if(!current || p > capacity || n > capacity - p){
+        addBlock(n + align);
+        p = padded(align);
+      }
+      used = p + n;
+      handedOut += n;
+      return current + p;
+    }
+
+    // frees all memory
+    void release(){
+      for(const Block& b : blocks)
+        ::operator delete(b.first);
+      blocks.clear();
+      current = nullptr;
+      used = capacity = handedOut = 0;
+    }
+
+    // frees all memory but the largest block, which is reused. That is
+    // not always the last one: a smaller block can follow a block of an
+    // oversized request.
+    void reset(){
+      if(blocks.empty())
+        return;
+      size_t largest = 0;
+      for(size_t i = 1; i < blocks.size(); ++i)
+        if(blocks[i].second > blocks[largest].second)
+          largest = i;
+      for(size_t i = 0; i < blocks.size(); ++i)
+        if(i != largest)
+          ::operator delete(blocks[i].first);
+      const Block kept = blocks[largest];
+      blocks.assign(1, kept);
+      current = kept.first;
+      capacity = kept.second;
+      used = handedOut = 0;
+    }
+
+    // the number of bytes handed out since the last `release` or `reset`
+    size_t size() const{ return handedOut; }
+
+  private:
+    // the offset of the next free address aligned to `align`
+    size_t padded(size_t align) const{
+      const uintptr_t address = reinterpret_cast<uintptr_t>(current) + used;
+      return used + size_t(((address + align - 1) & ~uintptr_t(align - 1)) - address);
+    }
+
+    // blocks double in size up to 16 MiB, larger requests get a block
+    // of their own size
+    void addBlock(size_t n){
+      const size_t size = std::max(n, blockSize);
+      blocks.push_back(Block(static_cast<char*>(::operator new(size)), size));
+      current = blocks.back().first;
+      used = 0;
+      capacity = size;
+      blockSize = std::min(blockSize * 2, std::max(blockSize, size_t(1) << 24));
+    }
+
+#ifdef ENHANCE_PMR
+    void* do_allocate(size_t n, size_t align) override{
+      return allocate(n, align);
+    }
+
+    void do_deallocate(void*, size_t, size_t) override{}
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override{
+      return this == &other;
+    }
+#endif
+
+    // the address and size of a block
+    typedef std::pair<char*, size_t> Block;
+
+    size_t blockSize;
+    std::vector<Block> blocks;
+    char* current;
+    size_t used, capacity, handedOut;
+  };
+
+  template<class T>
+  class ArenaAllocator {
+  public:
+    typedef T value_type;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    ArenaAllocator(Arena* arena = nullptr) noexcept : memory(arena){}
+
+    template<class U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept : memory(other.arena()){}
+
+    T* allocate(size_t n){
+      if(n > std::numeric_limits<size_t>::max() / sizeof(T))
+        throw std::bad_alloc();
+      if(memory)
+        return static_cast<T*>(memory->allocate(n * sizeof(T), alignof(T)));
+      return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    // memory of the arena is freed with the arena
+    void deallocate(T* p, size_t){
+      if(!memory)
+        ::operator delete(p);
+    }
+
+    Arena* arena() const{ return memory; }
+
+  private:
+    Arena* memory;
+  };
+
+  template<class T, class U>
+  bool operator==(const ArenaAllocator<T>& x, const ArenaAllocator<U>& y){
+    return x.arena() == y.arena();
+  }
+
+  template<class T, class U>
+  bool operator!=(const ArenaAllocator<T>& x, const ArenaAllocator<U>& y){
+    return !(x == y);
+  }
+
+  typedef std::basic_string<char, std::char_traits<char>, ArenaAllocator<char> > ArenaString;
+
+  template<class T>
+  using ArenaVector = std::vector<T, ArenaAllocator<T> >;
+
+  /*
+    Native binary archives
+
+    `BinaryWriter` appends values to a growable buffer, `BinaryReader`
+    reads them back. Both follow the conventions of Boost archives
+    (`<<`, `>>`, `&`, `is_saving`, `is_loading`) and therefore work
+    with `Serializable` and `serialize`. Values are stored as:
+
+    - trivially serializable values: their bytes in native byte order
+    - strings and `std::vector`s: the number of elements (`uint64_t`),
+      followed by the elements; vectors of trivially serializable
+      values (except `bool`) with a single copy
+    - classes with a `serialize(Archive&, unsigned)` member: whatever
+      it saves, otherwise their accessed values (`enhance` member)
+
+    `CompactWriter` and `CompactReader` store integers and enums as
+    LEB128 varints instead, signed ones zigzag encoded, and the number
+    of elements as varint. The encoding is a policy of
+    `BasicBinaryWriter` and `BasicBinaryReader`, see `FixedEncoding`
+    and `CompactEncoding`.
+
+    Specialize `BinarySave` and `BinaryLoad` for other types. Readers
+    throw `std::runtime_error`, if the data ends prematurely or is
+    corrupt.
+   */
+
+  template<class Encoding> class BasicBinaryWriter;
+  template<class Encoding> class BasicBinaryReader;
+
+  struct FixedEncoding;
+  struct CompactEncoding;
+
+  typedef BasicBinaryWriter<FixedEncoding> BinaryWriter;
+  typedef BasicBinaryReader<FixedEncoding> BinaryReader;
+  typedef BasicBinaryWriter<CompactEncoding> CompactWriter;
+  typedef BasicBinaryReader<CompactEncoding> CompactReader;
+
+  // only the fixed encoding saves runs of members as they are
+  template<>
+  struct IsBinaryArchive<BinaryWriter> : std::true_type {};
+
+  template<>
+  struct IsBinaryArchive<BinaryReader> : std::true_type {};
+
+  template<class Value, class Enable = void>
+  struct BinarySave {
+    template<class Archive>
+    static void apply(Archive& a, const Value& v){
+      Save<Archive, const Value>(v, a).callEnhance();
+    }
+  };
+
+  template<class Value, class Enable = void>
+  struct BinaryLoad {
+    template<class Archive>
+    static void apply(Archive& a, Value& v){
+      Load<Archive, Value>(v, a).callEnhance();
+    }
+  };
+
+  namespace varint {
+
+    // maps small negative and positive numbers to small unsigned ones:
+    // 0, -1, 1, -2, ... to 0, 1, 2, 3, ...
+    FORCE_INLINE uint64_t zigzag(int64_t v){
+      return (uint64_t(v) << 1) ^ (0 - (uint64_t(v) >> 63));
+    }
+
+    FORCE_INLINE int64_t unzigzag(uint64_t u){
+      return int64_t((u >> 1) ^ (0 - (u & 1)));
+    }
+
+    // writes `v` to `out` (at most 10 bytes), returns the number of bytes
+    FORCE_INLINE size_t encode(uint64_t v, char* out){
+      size_t n = 0;
+      for(; v >= 0x80; v >>= 7)
+        out[n++] = char(v | 0x80);
+      out[n++] = char(v);
+      return n;
+    }
+
+    // the number of bytes of the varint of `v`
+    FORCE_INLINE size_t size(uint64_t v){
+#ifdef __GNUC__
+      return (70 - size_t(__builtin_clzll(v | 1))) / 7;
+#else
+      size_t n = 1;
+      for(; v >= 0x80; v >>= 7)
+        ++n;
+      return n;
+#endif
+    }
+
+    // reads a varint from [p, end), returns its number of bytes or 0 if
+    // it is truncated or does not fit 64 bits
+    FORCE_INLINE size_t decode(const char* p, const char* end, uint64_t& v){
+      const unsigned char* u = reinterpret_cast<const unsigned char*>(p);
+      const size_t n = std::min(size_t(end - p), size_t(10));
+      v = 0;
+      for(size_t i = 0; i < n; ++i){
+        v |= uint64_t(u[i] & 0x7f) << (7 * i);
+        if(u[i] < 0x80)
+          return i == 9 && u[i] > 1 ? 0 : i + 1;
+      }
+      return 0;
+    }
+
+    // integers and enums are stored as varints
+    template<class Value>
+    struct IsInteger : std::integral_constant<bool,
+      std::is_integral<Value>::value || std::is_enum<Value>::value> {};
+
+    template<class Value, class Enable = void>
+    struct Underlying {
+      typedef Value type;
+    };
+
+    template<class Value>
+    struct Underlying<Value, typename std::enable_if<std::is_enum<Value>::value>::type> {
+      typedef typename std::underlying_type<Value>::type type;
+    };
+
+    template<class Value>
+    FORCE_INLINE uint64_t toUnsigned(Value v){
+      typedef typename Underlying<Value>::type I;
+      return std::is_signed<I>::value ? zigzag(int64_t(I(v))) : uint64_t(I(v));
+    }
+
+    // false, if `u` is out of the range of `Value`
+    template<class Value>
+    FORCE_INLINE bool fromUnsigned(uint64_t u, Value& v){
+      typedef typename Underlying<Value>::type I;
+      if(std::is_signed<I>::value){
+        const int64_t s = unzigzag(u);
+        if(s < int64_t(std::numeric_limits<I>::min()) ||
+           s > int64_t(std::numeric_limits<I>::max()))
+          return false;
+        v = Value(I(s));
+      }else{
+        if(u > uint64_t(std::numeric_limits<I>::max()))
+          return false;
+        v = Value(I(u));
+      }
+      return true;
+    }
+
+    // the number of leading bytes below 0x80 (i.e. single byte varints)
+    // of the `blockWidth` bytes at `p`
+#if defined(ENHANCE_SIMD_X86) && defined(__SSE2__)
+    enum { blockWidth = 16 };
+
+    FORCE_INLINE size_t smallPrefix(const char* p){
+      typedef char V __attribute__((vector_size(16)));
+      V b;
+      std::memcpy(&b, p, 16);
+      const uint32_t m = uint32_t(__builtin_ia32_pmovmskb128(b));
+      return m ? size_t(__builtin_ctz(m)) : 16;
+    }
+#elif defined(__GNUC__) && !defined(ENHANCE_BIG_ENDIAN)
+    enum { blockWidth = 8 };
+
+    FORCE_INLINE size_t smallPrefix(const char* p){
+      uint64_t w;
+      std::memcpy(&w, p, 8);
+      const uint64_t high = w & 0x8080808080808080ULL;
+      return high ? size_t(__builtin_ctzll(high)) / 8 : 8;
+    }
+#else
+    enum { blockWidth = 1 };
+
+    FORCE_INLINE size_t smallPrefix(const char* p){
+      return size_t(static_cast<unsigned char>(*p) < 0x80);
+    }
+#endif
+
+    // decodes `n` varints from [p, end) into `out`, returns the end of
+    // the last one or `nullptr` on errors. Runs of single byte varints
+    // are found a block at a time.
+    template<class Value>
+    const char* decodeMany(const char* p, const char* end, Value* out, size_t n){
+      for(size_t i = 0; i < n;){
+        if(size_t(end - p) >= blockWidth){
+          const size_t k = std::min(smallPrefix(p), n - i);
+          for(size_t j = 0; j < k; ++j)
+            if(!fromUnsigned(uint64_t(static_cast<unsigned char>(p[j])), out[i + j]))
+              return nullptr;
+          p += k;
+          i += k;
+          if(k == size_t(blockWidth) || i == n)
+            continue;
+        }
+        uint64_t u;
+        const size_t len = decode(p, end, u);
+        if(!len || !fromUnsigned(u, out[i]))
+          return nullptr;
+        p += len;
+        ++i;
+      }
+      return p;
+    }
+  }
+
+  // stores trivially serializable values as their bytes and numbers
+  // of elements as `uint64_t`
+  struct FixedEncoding {
+    template<class Writer, class Value>
+    FORCE_INLINE static void save(Writer& a, const Value& v){
+      a.saveBinary(std::addressof(v), sizeof(Value));
+    }
+
+    template<class Reader, class Value>
+    FORCE_INLINE static void load(Reader& a, Value& v){
+      a.loadBinary(std::addressof(v), sizeof(Value));
+    }
+
+    template<class Writer>
+    FORCE_INLINE static void saveSize(Writer& a, size_t n){
+      save(a, uint64_t(n));
+    }
+
+    template<class Reader>
+    FORCE_INLINE static size_t loadSize(Reader& a){
+      uint64_t n;
+      load(a, n);
+      return size_t(n);
+    }
+
+    template<class Writer, class Value>
+    static void saveArray(Writer& a, const Value* p, size_t n){
+      a.saveBinary(p, n * sizeof(Value));
+    }
+
+    template<class Reader, class Value>
+    static void loadArray(Reader& a, Value* p, size_t n){
+      a.loadBinary(p, n * sizeof(Value));
+    }
+
+    // the number of bytes saved by the functions above
+    template<class Value>
+    static constexpr size_t size(const Value&){
+      return sizeof(Value);
+    }
+
+    static constexpr size_t sizeOfSize(size_t){
+      return sizeof(uint64_t);
+    }
+
+    template<class Value>
+    static size_t arraySize(const Value*, size_t n){
+      return n * sizeof(Value);
+    }
+  };
+
+  // stores integers and enums as LEB128 varints (zigzag encoded if
+  // signed), numbers of elements as varints and all other trivially
+  // serializable values as their bytes
+  struct CompactEncoding {
+    template<class Writer, class Value>
+    FORCE_INLINE static void save(Writer& a, const Value& v){
+      save(a, v, varint::IsInteger<Value>());
+    }
+
+    template<class Reader, class Value>
+    FORCE_INLINE static void load(Reader& a, Value& v){
+      load(a, v, varint::IsInteger<Value>());
+    }
+
+    template<class Writer>
+    FORCE_INLINE static void saveSize(Writer& a, size_t n){
+      save(a, uint64_t(n));
+    }
+
+    template<class Reader>
+    FORCE_INLINE static size_t loadSize(Reader& a){
+      uint64_t n;
+      load(a, n);
+      if(n > std::numeric_limits<size_t>::max())
+        throw std::runtime_error("CompactReader: invalid size");
+      return size_t(n);
+    }
+
+    template<class Writer, class Value>
+    static void saveArray(Writer& a, const Value* p, size_t n){
+      saveArray(a, p, n, varint::IsInteger<Value>());
+    }
+
+    template<class Reader, class Value>
+    static void loadArray(Reader& a, Value* p, size_t n){
+      loadArray(a, p, n, varint::IsInteger<Value>());
+    }
+
+    // the number of bytes saved by the functions above
+    template<class Value>
+    FORCE_INLINE static size_t size(const Value& v){
+      return size(v, varint::IsInteger<Value>());
+    }
+
+    FORCE_INLINE static size_t sizeOfSize(size_t n){
+      return varint::size(n);
+    }
+
+    template<class Value>
+    static size_t arraySize(const Value* p, size_t n){
+      return arraySize(p, n, varint::IsInteger<Value>());
+    }
+
+  private:
+    template<class Value>
+    FORCE_INLINE static size_t size(const Value& v, std::true_type){
+      return varint::size(varint::toUnsigned(v));
+    }
+
+    template<class Value>
+    FORCE_INLINE static size_t size(const Value&, std::false_type){
+      return sizeof(Value);
+    }
+
+    template<class Value>
+    static size_t arraySize(const Value* p, size_t n, std::true_type){
+      size_t bytes = 0;
+      for(size_t i = 0; i < n; ++i)
+        bytes += varint::size(varint::toUnsigned(p[i]));
+      return bytes;
+    }
+
+    template<class Value>
+    static size_t arraySize(const Value*, size_t n, std::false_type){
+      return n * sizeof(Value);
+    }
+
+    template<class Writer, class Value>
+    FORCE_INLINE static void save(Writer& a, const Value& v, std::true_type){
+      char buffer[10];
+      a.saveBinary(buffer, varint::encode(varint::toUnsigned(v), buffer));
+    }
+
+    template<class Writer, class Value>
+    FORCE_INLINE static void save(Writer& a, const Value& v, std::false_type){
+      FixedEncoding::save(a, v);
+    }
+
+    template<class Reader, class Value>
+    FORCE_INLINE static void load(Reader& a, Value& v, std::true_type){
+      uint64_t u;
+      const size_t len = varint::decode(a.current(), a.current() + a.remaining(), u);
+      if(!len || !varint::fromUnsigned(u, v))
+        throw std::runtime_error("CompactReader: invalid varint");
+      a.take(len);
+    }
+
+    template<class Reader, class Value>
+    FORCE_INLINE static void load(Reader& a, Value& v, std::false_type){
+      FixedEncoding::load(a, v);
+    }
+
+    // encodes into a buffer on the stack, to append in chunks
+    template<class Writer, class Value>
+    static void saveArray(Writer& a, const Value* p, size_t n, std::true_type){
+      char buffer[1024];
+      size_t used = 0;
+      for(size_t i = 0; i < n; ++i){
+        if(used > sizeof(buffer) - 10){
+          a.saveBinary(buffer, used);
+          used = 0;
+        }
+        used += varint::encode(varint::toUnsigned(p[i]), buffer + used);
+      }
+      a.saveBinary(buffer, used);
+    }
+
+    template<class Writer, class Value>
+    static void saveArray(Writer& a, const Value* p, size_t n, std::false_type){
+      FixedEncoding::saveArray(a, p, n);
+    }
+
+    template<class Reader, class Value>
+    static void loadArray(Reader& a, Value* p, size_t n, std::true_type){
+      const char* end = varint::decodeMany(a.current(), a.current() + a.remaining(), p, n);
+      if(!end)
+        throw std::runtime_error("CompactReader: invalid varint");
+      a.take(size_t(end - a.current()));
+    }
+
+    template<class Reader, class Value>
+    static void loadArray(Reader& a, Value* p, size_t n, std::false_type){
+      FixedEncoding::loadArray(a, p, n);
+    }
+  };
+
+  template<class Encoding>
+  class BasicBinaryWriter {
+  public:
+    typedef std::true_type is_saving;
+    typedef std::false_type is_loading;
+    typedef Encoding encoding_t;
+
+    BasicBinaryWriter() : fixed(false), first(nullptr), last(nullptr), end(nullptr){}
+
+    // saves into the `n` bytes at `data` (e.g. a part of a larger
+    // buffer) instead of a buffer of its own, so `buffer()` stays empty
+    // and `data()` is `data`. Saving more throws `std::length_error`.
+    BasicBinaryWriter(char* data, size_t n)
+      : fixed(true), first(data), last(data), end(data + n){}
+
+    // copies have a buffer of their own
+    BasicBinaryWriter(const BasicBinaryWriter& w) : BasicBinaryWriter(){
+      *this = w;
+    }
+
+    BasicBinaryWriter(BasicBinaryWriter&& w) : BasicBinaryWriter(){
+      *this = std::move(w);
+    }
+
+    BasicBinaryWriter& operator=(const BasicBinaryWriter& w){
+      if(this != &w){
+        bytes.assign(w.data(), w.data() + w.size());
+        fixed = false;
+        first = bytes.data();
+        last = end = first + bytes.size();
+      }
+      return *this;
+    }
+
+    BasicBinaryWriter& operator=(BasicBinaryWriter&& w){
+      if(this != &w){
+        // the moved vector keeps its elements in place
+        bytes = std::move(w.bytes);
+        fixed = w.fixed;
+        first = w.first;
+        last = w.last;
+        end = w.end;
+        w.bytes.clear();
+        w.fixed = false;
+        w.first = w.last = w.end = nullptr;
+      }
+      return *this;
+    }
+
+    template<class Value>
+    FORCE_INLINE BasicBinaryWriter& operator<<(const Value& v){
+      BinarySave<Value>::apply(*this, v);
+      return *this;
+    }
+
+    template<class Value>
+    FORCE_INLINE BasicBinaryWriter& operator&(const Value& v){
+      return *this << v;
+    }
+
+    FORCE_INLINE void saveBinary(const void* x, size_t n){
+      if(size_t(end - last) < n)
+        grow(n);
+      if(n)
+        std::memcpy(last, x, n);
+      last += n;
+    }
+
+    // the saved bytes (empty for external buffers)
+    const std::vector<char>& buffer() const{
+      if(!fixed){
+        bytes.resize(size());
+        end = last;
+      }
+      return bytes;
+    }
+
+    const char* data() const{ return first; }
+    size_t size() const{ return size_t(last - first); }
+
+    void reserve(size_t n){
+      if(size_t(end - first) < n)
+        grow(n - size());
+    }
+
+    void clear(){ last = first; }
+
+    // replaces the `n` bytes at position `pos` of the buffer with the
+    // `m` bytes at `x`, e.g. a placeholder with a length prefix, once
+    // the length is known
+    void replaceBinary(size_t pos, size_t n, const void* x, size_t m){
+      if(m > n && size_t(end - last) < m - n)
+        grow(m - n);
+      std::memmove(first + pos + m, first + pos + n, size() - pos - n);
+      std::memcpy(first + pos, x, m);
+      last += m;
+      last -= n;
+    }
+
+  private:
+    // bytes made available at once, zero filled by `resize`
+    enum { window = 1 << 12 };
+
+    // room for `n` more bytes. The capacity grows geometrically
+    // without initializing it, the size a window at a time.
+    void grow(size_t n){
+      if(fixed)
+        throw std::length_error("BinaryWriter: the buffer is full");
+      const size_t used = size(), size = used + std::max(n, size_t(window));
+      bytes.resize(used);
+      if(bytes.capacity() < size)
+        bytes.reserve(std::max(2 * bytes.capacity(), size));
+      bytes.resize(size);
+      first = bytes.data();
+      last = first + used;
+      end = first + size;
+    }
+
+    // [first, end) is the external buffer, if `fixed`, and `bytes`
+    // otherwise, which is trimmed to the saved bytes by `buffer()`
+    mutable std::vector<char> bytes;
+    bool fixed;
+    char* first;
+    char* last;
+    mutable char* end;
+  };
+
+  template<class Encoding>
+  class BasicBinaryReader {
+  public:
+    typedef std::false_type is_saving;
+    typedef std::true_type is_loading;
+    typedef Encoding encoding_t;
+
+    BasicBinaryReader(const char* data, size_t n) : pos(data), end(data + n){}
+
+    explicit BasicBinaryReader(const std::vector<char>& v)
+      : BasicBinaryReader(v.data(), v.size()){}
+
+    template<class Value>
+    FORCE_INLINE BasicBinaryReader& operator>>(Value& v){
+      BinaryLoad<Value>::apply(*this, v);
+      return *this;
+    }
+
+    template<class Value>
+    FORCE_INLINE BasicBinaryReader& operator&(Value& v){
+      return *this >> v;
+    }
+
+    FORCE_INLINE void loadBinary(void* x, size_t n){
+      // `x` may be null for empty ranges
+      if(n)
+        std::memcpy(x, take(n), n);
+    }
+
+    // the next `n` bytes
+    FORCE_INLINE const char* take(size_t n){
+      if(size_t(end - pos) < n)
+        throw std::runtime_error("BinaryReader: unexpected end of data");
+      const char* p = pos;
+      pos += n;
+      return p;
+    }
+
+    // the next byte
+    const char* current() const{ return pos; }
+    size_t remaining() const{ return size_t(end - pos); }
+
+    // containers with an `ArenaAllocator` are loaded into `arena`
+    void useArena(Arena* arena){ memory = arena; }
+    Arena* arena() const{ return memory; }
+
+  private:
+    const char* pos;
+    const char* end;
+    Arena* memory = nullptr;
+  };
+
+  // gives containers with an `ArenaAllocator` the arena of the reader
+  // (if any) before they are loaded
+  template<class Reader, class Container>
+  FORCE_INLINE void bindArena(Reader&, Container&){}
+
+  template<class Encoding, class Value>
+  void bindArena(BasicBinaryReader<Encoding>& a, std::vector<Value, ArenaAllocator<Value> >& v){
+    if(a.arena() && v.get_allocator().arena() != a.arena())
+      v = std::vector<Value, ArenaAllocator<Value> >(ArenaAllocator<Value>(a.arena()));
+  }
+
+  template<class Encoding, class Traits>
+  void bindArena(BasicBinaryReader<Encoding>& a,
+                 std::basic_string<char, Traits, ArenaAllocator<char> >& s){
+    if(a.arena() && s.get_allocator().arena() != a.arena())
+      s = std::basic_string<char, Traits, ArenaAllocator<char> >(ArenaAllocator<char>(a.arena()));
+  }
+
+  template<class Value>
+  struct BinarySave<Value, typename std::enable_if<
+                             IsTriviallySerializable<Value>::value>::type> {
+    template<class Encoding>
+    FORCE_INLINE static void apply(BasicBinaryWriter<Encoding>& a, const Value& v){
+      Encoding::save(a, v);
+    }
+  };
+
+  template<class Value>
+  struct BinaryLoad<Value, typename std::enable_if<
+                             IsTriviallySerializable<Value>::value>::type> {
+    template<class Encoding>
+    FORCE_INLINE static void apply(BasicBinaryReader<Encoding>& a, Value& v){
+      Encoding::load(a, v);
+    }
+  };
+
+  template<class Value>
+  struct BinarySave<Value, typename Void<decltype(
+      std::declval<Value&>().serialize(std::declval<BinaryWriter&>(), 0u))>::type> {
+    template<class Archive>
+    static void apply(Archive& a, const Value& v){
+      const_cast<Value&>(v).serialize(a, 0u);
+    }
+  };
+
+  template<class Value>
+  struct BinaryLoad<Value, typename Void<decltype(
+      std::declval<Value&>().serialize(std::declval<BinaryReader&>(), 0u))>::type> {
+    template<class Archive>
+    static void apply(Archive& a, Value& v){
+      v.serialize(a, 0u);
+    }
+  };
+
+  template<class Traits, class Allocator>
+  struct BinarySave<std::basic_string<char, Traits, Allocator> > {
+    template<class Encoding>
+    static void apply(BasicBinaryWriter<Encoding>& a,
+                      const std::basic_string<char, Traits, Allocator>& v){
+      Encoding::saveSize(a, v.size());
+      a.saveBinary(v.data(), v.size());
+    }
+  };
+
+  template<class Traits, class Allocator>
+  struct BinaryLoad<std::basic_string<char, Traits, Allocator> > {
+    template<class Encoding>
+    static void apply(BasicBinaryReader<Encoding>& a,
+                      std::basic_string<char, Traits, Allocator>& v){
+      const size_t n = Encoding::loadSize(a);
+      const char* p = a.take(n);
+      bindArena(a, v);
+      v.assign(p, n);
+    }
+  };
+
+  template<class Value, class Allocator>
+  struct BinarySave<std::vector<Value, Allocator> > {
+    template<class Encoding>
+    static void apply(BasicBinaryWriter<Encoding>& a, const std::vector<Value, Allocator>& v){
+      Encoding::saveSize(a, v.size());
+      saveElements(a, v, IsBulkSerializable<Value>());
+    }
+
+  private:
+    template<class Encoding>
+    static void saveElements(BasicBinaryWriter<Encoding>& a,
+                             const std::vector<Value, Allocator>& v, std::true_type){
+      Encoding::saveArray(a, v.data(), v.size());
+    }
+
+    template<class Encoding>
+    static void saveElements(BasicBinaryWriter<Encoding>& a,
+                             const std::vector<Value, Allocator>& v, std::false_type){
+      for(const Value& x : v)
+        a << x;
+    }
+  };
+
+  // every element takes at least one byte, which limits the
+  // allocation for corrupt sizes
+  template<class Value, class Allocator>
+  struct BinaryLoad<std::vector<Value, Allocator> > {
+    template<class Encoding>
+    static void apply(BasicBinaryReader<Encoding>& a, std::vector<Value, Allocator>& v){
+      const size_t n = Encoding::loadSize(a);
+      if(n > a.remaining())
+        throw std::runtime_error("BinaryReader: unexpected end of data");
+      bindArena(a, v);
+      loadElements(a, v, n, IsBulkSerializable<Value>());
+    }
+
+  private:
+    template<class Encoding>
+    static void loadElements(BasicBinaryReader<Encoding>& a, std::vector<Value, Allocator>& v,
+                             size_t n, std::true_type){
+      v.resize(n);
+      Encoding::loadArray(a, v.data(), n);
+    }
+
+    template<class Encoding>
+    static void loadElements(BasicBinaryReader<Encoding>& a, std::vector<Value, Allocator>& v,
+                             size_t n, std::false_type){
+      v.clear();
+      v.reserve(n);
+      for(size_t i = 0; i < n; ++i)
+        loadBack(a, v);
+    }
+
+    template<class Encoding, class Element>
+    static void loadBack(BasicBinaryReader<Encoding>& a, std::vector<Element, Allocator>& v){
+      v.emplace_back();
+      a >> v.back();
+    }
+
+    // `std::vector<bool>::back()` is a proxy
+    template<class Encoding>
+    static void loadBack(BasicBinaryReader<Encoding>& a, std::vector<bool, Allocator>& v){
+      bool x;
+      a >> x;
+      v.push_back(x);
+    }
+  };
+
+  // numbers of elements and ranges of numbers (see `SaveOp`) in
+  // native archives
+  template<class Encoding>
+  FORCE_INLINE void saveCount(BasicBinaryWriter<Encoding>& a, size_t n){
+    Encoding::saveSize(a, n);
+  }
+
+  template<class Encoding>
+  FORCE_INLINE size_t loadCount(BasicBinaryReader<Encoding>& a){
+    return Encoding::loadSize(a);
+  }
+
+  template<class Encoding, class Value>
+  FORCE_INLINE void saveContiguous(BasicBinaryWriter<Encoding>& a, const Value* p, size_t n){
+    Encoding::saveArray(a, p, n);
+  }
+
+  template<class Encoding, class Value>
+  FORCE_INLINE void loadContiguous(BasicBinaryReader<Encoding>& a, Value* p, size_t n){
+    Encoding::loadArray(a, p, n);
+  }
+
+  /*
+    Serialized size
+
+    `serializedSize<Archive>(x)` returns the exact number of bytes,
+    which `a << x` saves into an archive `a` of type `Archive` (e.g.
+    `BinaryWriter` or `CompactWriter`), without saving anything, so
+    the buffer can be allocated once. `SerializedSize<Archive, T>`
+    walks the accessor list of `T` like `Save` (including runs of
+    adjacent members and the contents of ranges and containers).
+    `serializedSize<Archive>(first, last)` sums up the sizes of a
+    range of objects; if they have a fixed size (see
+    `FixedSerializedSize`), it multiplies.
+
+    Specialize `BinarySize` along with `BinarySave` for other types.
+   */
+
+  template<class Value, class Enable = void>
+  struct BinarySize;
+
+  template<class Encoding>
+  struct SizeOp {
+    typedef size_t result_t;
+
+    template<class A>
+    static result_t init(A&){ return 0; }
+
+    // like `Save`, runs of members are only formed for the fixed encoding
+    template<class Value>
+    struct blockable : std::integral_constant<bool,
+      std::is_same<Encoding, FixedEncoding>::value &&
+      IsTriviallySerializable<Value>::value> {};
+
+    template<class Value>
+    FORCE_INLINE static bool apply(result_t& r, const Value& v){
+      r += BinarySize<Value>::template apply<Encoding>(v);
+      return false;
+    }
+
+    static bool applyBlock(result_t& r, const void*, size_t n){
+      r += n;
+      return false;
+    }
+
+    template<class Value>
+    static typename std::enable_if<IsTriviallySerializable<
+                                     typename std::remove_const<Value>::type>::value,
+                                   bool>::type
+    applyRange(result_t& r, Value* x, size_t n){
+      r += Encoding::arraySize(x, n);
+      return false;
+    }
+
+    // `container(ac)` accessors, see `SaveOp`
+    template<class Container>
+    static bool applyContainer(result_t& r, const Container& c){
+      const size_t n = size_t(std::distance(std::begin(c), std::end(c)));
+      r += Encoding::sizeOfSize(n);
+      auto b = std::begin(c);
+      elements(r, b, n, IsBulkRange<decltype(b)>());
+      return false;
+    }
+
+  private:
+    template<class It>
+    static void elements(result_t& r, It b, size_t n, std::true_type){
+      r += Encoding::arraySize(Contiguous<It>::pointer(b), n);
+    }
+
+    template<class It>
+    static void elements(result_t& r, It b, size_t n, std::false_type){
+      typedef typename std::decay<decltype(*b)>::type Value;
+      for(size_t i = 0; i < n; ++i, ++b)
+        r += BinarySize<Value>::template apply<Encoding>(*b);
+    }
+  };
+
+  // Combiner alias
+  template<class Archive, class Target>
+  using SerializedSize = UnaryCombiner<SizeOp<typename Archive::encoding_t>, Target>;
+
+  template<class Value, class Enable = void>
+  struct HasSerializeMember : std::false_type {};
+
+  template<class Value>
+  struct HasSerializeMember<Value, typename Void<decltype(
+      std::declval<Value&>().serialize(std::declval<BinaryWriter&>(), 0u))>::type>
+    : std::true_type {};
+
+  // classes with an `enhance` member (or derived from `Serializable`)
+  template<class Value, class Enable>
+  struct BinarySize {
+    static_assert(!HasSerializeMember<Value>::value ||
+                  std::is_base_of<Serializable<Value>, Value>::value,
+                  "the size of a custom `serialize` member is unknown, specialize `BinarySize`");
+
+    template<class Encoding>
+    static size_t apply(const Value& v){
+      return UnaryCombiner<SizeOp<Encoding>, const Value>(v).callEnhance();
+    }
+  };
+
+  template<class Value>
+  struct BinarySize<Value, typename std::enable_if<
+                             IsTriviallySerializable<Value>::value>::type> {
+    template<class Encoding>
+    FORCE_INLINE static size_t apply(const Value& v){
+      return Encoding::size(v);
+    }
+  };
+
+  template<class Traits, class Allocator>
+  struct BinarySize<std::basic_string<char, Traits, Allocator> > {
+    template<class Encoding>
+    static size_t apply(const std::basic_string<char, Traits, Allocator>& v){
+      return Encoding::sizeOfSize(v.size()) + v.size();
+    }
+  };
+
+  template<class Value, class Allocator>
+  struct BinarySize<std::vector<Value, Allocator> > {
+    template<class Encoding>
+    static size_t apply(const std::vector<Value, Allocator>& v){
+      return Encoding::sizeOfSize(v.size()) +
+        elements<Encoding>(v, IsBulkSerializable<Value>());
+    }
+
+  private:
+    template<class Encoding>
+    static size_t elements(const std::vector<Value, Allocator>& v, std::true_type){
+      return Encoding::arraySize(v.data(), v.size());
+    }
+
+    template<class Encoding>
+    static size_t elements(const std::vector<Value, Allocator>& v, std::false_type){
+      size_t bytes = 0;
+      for(const Value& x : v)
+        bytes += BinarySize<Value>::template apply<Encoding>(x);
+      return bytes;
+    }
+  };
+
+  template<class Archive, class Value>
+  FORCE_INLINE size_t serializedSize(const Value& x){
+    return BinarySize<Value>::template apply<typename Archive::encoding_t>(x);
+  }
+
+  /*
+    The size of the objects of class `Target`, if all accessed values
+    have a fixed size in the encoding of `Archive` (e.g. numbers with
+    the fixed encoding, no strings, vectors or ranges), 0 otherwise.
+    C++11 cannot evaluate accessor lists at compile time, so the size
+    is found with the first object passed to `get` and reused.
+    Classes with a `serialize` member of their own (e.g. tagged
+    messages, which add keys and a length) are never fixed.
+   */
+  template<class Archive, class Target>
+  class FixedSerializedSize {
+    typedef typename Archive::encoding_t Encoding;
+
+    struct Probe {
+      size_t size;
+      bool fixed;
+    };
+
+    template<class Value, class Enable = void>
+    struct Fixed : std::false_type {};
+
+    template<class Value>
+    struct Fixed<Value, typename std::enable_if<
+                          IsTriviallySerializable<Value>::value>::type>
+      : std::integral_constant<bool, std::is_same<Encoding, FixedEncoding>::value ||
+                               !varint::IsInteger<Value>::value> {};
+
+    struct ProbeOp {
+      typedef Probe& result_t;
+
+      template<class Value>
+      static bool apply(result_t p, const Value& v){
+        p.fixed = p.fixed && Fixed<Value>::value;
+        p.size += BinarySize<Value>::template apply<Encoding>(v);
+        return !p.fixed;
+      }
+    };
+
+    struct Prober : UnaryCombiner<ProbeOp, const Target, Prober> {
+      Prober(const Target& target, Probe& p) : Prober::UnaryCombiner(target, p){}
+
+      using Prober::UnaryCombiner::singleStep;
+
+      // the length of ranges may differ between objects
+      template<class A, class B>
+      bool singleStep(Range<A, B>){
+        this->result.fixed = false;
+        return true;
+      }
+    };
+
+    // whether `Target` saves its accessed values, see `BinarySize`
+    typedef std::integral_constant<bool, !HasSerializeMember<Target>::value ||
+                                   std::is_base_of<Serializable<Target>, Target>::value> Accessed;
+
+    static size_t probe(const Target& x, std::true_type){
+      Probe p = {0, true};
+      Prober(x, p).callEnhance();
+      return p.fixed ? p.size : 0;
+    }
+
+    static size_t probe(const Target&, std::false_type){
+      return 0;
+    }
+
+  public:
+    static size_t get(const Target& x){
+      static const size_t size = probe(x, Accessed());
+      return size;
+    }
+  };
+
+  // the sum of the sizes of the objects in [first, last)
+  template<class Archive, class It>
+  size_t serializedSize(It first, It last){
+    typedef typename std::iterator_traits<It>::value_type Value;
+    if(first == last)
+      return 0;
+    const size_t fixed = FixedSerializedSize<Archive, Value>::get(*first);
+    if(fixed)
+      return fixed * size_t(std::distance(first, last));
+    size_t bytes = 0;
+    for(; first != last; ++first)
+      bytes += serializedSize<Archive>(*first);
+    return bytes;
+  }
+
+  /*
+    Parallel chunked serialization
+
+    `saveChunked<Writer>(v, threads, records)` splits the vector `v` into
+    chunks of `records` objects and saves each chunk on one of
+    `threads` worker threads into a frame of its own, which can be
+    decoded independently. The result is a header, an index of the
+    frames and the frames:
+
+    - header: magic "ENHCHK1", number of objects and of frames
+      (`uint64_t`s)
+    - index: offset (from the start), number of bytes, first object and
+      number of objects of every frame (`uint64_t`s)
+    - frames: the objects saved with `Writer` back to back
+
+    The frames are sized with `serializedSize` and saved in place, by
+    writers constructed with `Writer(data, n)` on their part of the
+    result.
+    `loadChunked<Reader>(data, n, v, threads)` decodes the frames in
+    parallel into `v`, which is resized to the number of objects
+    (`Target` has to be default constructible). The index is checked
+    before: its frames have to cover the objects in order and lie within
+    the data. `v` grows at most by `max(n, v.size())` objects at once,
+    so corrupt numbers of objects fail on missing data before they
+    exhaust the memory. Throws `std::runtime_error` for invalid data.
+    Exceptions of worker threads are rethrown by the calling thread.
+   */
+
+  namespace parallel {
+
+    // the number of hardware threads, at least 1
+    inline size_t threads(){
+      const unsigned n = std::thread::hardware_concurrency();
+      return n ? size_t(n) : 1;
+    }
+
+    // calls `f(i)` for all `i` in [0, n) on at most `threads` threads
+    // (including the calling one), which take the next `i` when done.
+    // Rethrows the first exception.
+    template<class F>
+    void forEach(size_t n, size_t threads, F f){
+      std::atomic<size_t> next(0);
+      std::exception_ptr error;
+      std::mutex errorMutex;
+      auto work = [&]{
+        for(size_t i; (i = next++) < n;){
+          try{
+            f(i);
+          }catch(...){
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if(!error)
+              error = std::current_exception();
+            next = n;
+          }
+        }
+      };
+      std::vector<std::thread> workers;
+      for(size_t t = 1; t < std::min(threads, n); ++t)
+        workers.emplace_back(work);
+      work();
+      for(std::thread& t : workers)
+        t.join();
+      if(error)
+        std::rethrow_exception(error);
+    }
+  }
+
+  namespace chunked {
+
+    struct Header {
+      char magic[8];
+      uint64_t count;
+      uint64_t frames;
+    };
+
+    struct Frame {
+      uint64_t offset;
+      uint64_t length;
+      uint64_t first;
+      uint64_t count;
+    };
+
+    inline const char* magic(){ return "ENHCHK1"; }
+
+    // objects per frame, if not given
+    const size_t defaultRecords = 1 << 16;
+
+    // loads a frame of more objects than a wave of `loadChunked`
+    // allows at once, growing `v` step by step
+    template<class Reader, class Target>
+    void loadFrame(const char* data, const Frame& f, std::vector<Target>& v, size_t n){
+      Reader r(data + f.offset, size_t(f.length));
+      for(size_t done = 0; done < f.count;){
+        const size_t step = std::min(size_t(f.count) - done, std::max(n, v.size()));
+        const size_t size = v.size() + step;
+        v.resize(size);
+        for(size_t m = size - step; m < size; ++m)
+          r >> v[m];
+        done += step;
+      }
+      if(r.remaining())
+        throw std::runtime_error("loadChunked: invalid frame");
+    }
+  }
+
+  template<class Writer = BinaryWriter, class Target>
+  std::vector<char> saveChunked(const std::vector<Target>& v, size_t threads = 0,
+                                size_t records = chunked::defaultRecords){
+    if(!threads)
+      threads = parallel::threads();
+    records = std::max(records, size_t(1));
+    const size_t k = (v.size() + records - 1) / records;
+    std::vector<chunked::Frame> index(k);
+    parallel::forEach(k, threads, [&](size_t i){
+        const size_t first = i * records, last = std::min(v.size(), first + records);
+        index[i].length = serializedSize<Writer>(v.begin() + first, v.begin() + last);
+        index[i].first = first;
+        index[i].count = last - first;
+      });
+
+    chunked::Header h;
+    std::memcpy(h.magic, chunked::magic(), sizeof(h.magic));
+    h.count = v.size();
+    h.frames = k;
+    size_t pos = sizeof(h) + k * sizeof(chunked::Frame);
+    for(chunked::Frame& f : index){
+      f.offset = pos;
+      pos += size_t(f.length);
+    }
+
+    // the frames are saved in place
+    std::vector<char> bytes(pos);
+    std::memcpy(bytes.data(), &h, sizeof(h));
+    if(k)
+      std::memcpy(&bytes[sizeof(h)], index.data(), k * sizeof(chunked::Frame));
+    parallel::forEach(k, threads, [&](size_t i){
+        const chunked::Frame& f = index[i];
+        Writer w(bytes.data() + f.offset, size_t(f.length));
+        for(size_t j = 0; j < f.count; ++j)
+          w << v[size_t(f.first) + j];
+        if(w.size() != f.length)
+          throw std::logic_error("saveChunked: serializedSize is not exact");
+      });
+    return bytes;
+  }
+
+  template<class Reader = BinaryReader, class Target>
+  void loadChunked(const char* data, size_t n, std::vector<Target>& v, size_t threads = 0){
+    chunked::Header h;
+    if(n < sizeof(h))
+      throw std::runtime_error("loadChunked: invalid data");
+    std::memcpy(&h, data, sizeof(h));
+    if(std::memcmp(h.magic, chunked::magic(), sizeof(h.magic)) != 0 ||
+       h.frames > (n - sizeof(h)) / sizeof(chunked::Frame))
+      throw std::runtime_error("loadChunked: invalid data");
+    const size_t k = size_t(h.frames);
+    std::vector<chunked::Frame> index(k);
+    if(k)
+      std::memcpy(index.data(), data + sizeof(h), k * sizeof(chunked::Frame));
+    // the frames have to cover the objects in order and lie within the data
+    uint64_t next = 0;
+    for(const chunked::Frame& f : index){
+      if(f.first != next || f.count > h.count - next ||
+         f.offset > n || f.length > n - f.offset)
+        throw std::runtime_error("loadChunked: invalid data");
+      next += f.count;
+    }
+    if(next != h.count)
+      throw std::runtime_error("loadChunked: invalid data");
+
+    if(!threads)
+      threads = parallel::threads();
+    v.clear();
+    // The objects are allocated in waves of frames: at first as many
+    // as the data has bytes, which covers objects of at least one byte,
+    // then as many as were loaded. Objects without bytes are valid,
+    // corrupt numbers fail on the missing data of a wave.
+    for(size_t i = 0; i < k;){
+      const size_t wave = std::max(n, v.size());
+      size_t j = i, objects = 0;
+      for(; j < k && index[j].count <= wave - objects; ++j)
+        objects += size_t(index[j].count);
+      if(j == i){
+        chunked::loadFrame<Reader>(data, index[i], v, n);
+        ++i;
+        continue;
+      }
+      v.resize(v.size() + objects);
+      parallel::forEach(j - i, threads, [&](size_t t){
+          const chunked::Frame& f = index[i + t];
+          Reader r(data + f.offset, size_t(f.length));
+          for(size_t m = 0; m < f.count; ++m)
+            r >> v[size_t(f.first) + m];
+          if(r.remaining())
+            throw std::runtime_error("loadChunked: invalid frame");
+        });
+      i = j;
+    }
+  }
+
+  template<class Reader = BinaryReader, class Target>
+  void loadChunked(const std::vector<char>& bytes, std::vector<Target>& v, size_t threads = 0){
+    loadChunked<Reader>(bytes.data(), bytes.size(), v, threads);
+  }
+
+  /*
+    Delta serialization
+
+    `saveDelta(prev, cur, a)` saves, which of the accessed values of
+    `cur` differ from those of `prev` (compared with `==`), as a
+    bitmap (`std::vector<uint8_t>`) with one bit per value, followed by
+    the changed values. Ranges have a bit for their length, followed
+    by bits for their elements, if the length did not change. A range
+    of another length is saved as a whole, prefixed with its number of
+    elements.
+    `applyDelta(x, a)` loads the changed values into `x`, which turns
+    a copy of `prev` into a copy of `cur`. Containers of `container(ac)`
+    accessors are resized, other ranges of another length throw
+    `std::runtime_error`. Works with all archives.
+   */
+
+  struct DeltaMask {
+    std::vector<uint8_t>& bitmap;
+    size_t count;
+  };
+
+  template<class Archive>
+  struct DeltaState {
+    Archive& archive;
+    const std::vector<uint8_t>& bitmap;
+    size_t index;
+
+    // whether the next value changed
+    FORCE_INLINE bool changed(){
+      if(index / 8 >= bitmap.size())
+        throw std::runtime_error("applyDelta: the delta is of another object");
+      const bool c = (bitmap[index / 8] >> (index % 8)) & 1;
+      ++index;
+      return c;
+    }
+
+    // calls `f(i)` for the changed ones of the next `n` values,
+    // skipping unchanged bytes of the bitmap
+    template<class F>
+    FORCE_INLINE void forChanged(size_t n, F f){
+      if((index + n + 7) / 8 > bitmap.size())
+        throw std::runtime_error("applyDelta: the delta is of another object");
+      for(size_t i = 0; i < n;){
+        const size_t bit = index + i;
+        if(bit % 8 == 0 && n - i >= 8 && bitmap[bit / 8] == 0){
+          i += 8;
+          continue;
+        }
+        if((bitmap[bit / 8] >> (bit % 8)) & 1)
+          f(i);
+        ++i;
+      }
+      index += n;
+    }
+  };
+
+  struct DeltaMaskOp {
+    typedef DeltaMask& result_t;
+
+    template<class Value, class Value2>
+    FORCE_INLINE static bool apply(result_t m, const Value& x, const Value2& y){
+      if(m.count % 8 == 0)
+        m.bitmap.push_back(0);
+      if(!(x == y))
+        m.bitmap.back() |= uint8_t(1u << (m.count % 8));
+      ++m.count;
+      return false;
+    }
+
+    // contiguous ranges (see 3.3)
+    template<class Value>
+    static bool applyRange(result_t m, const Value* x, const Value* y, size_t n){
+      m.bitmap.resize((m.count + n + 7) / 8);
+      uint8_t* bits = m.bitmap.data();
+      size_t i = 0, count = m.count;
+      for(; i < n && count % 8; ++i, ++count)
+        bits[count / 8] |= uint8_t(!(x[i] == y[i])) << (count % 8);
+      // whole bytes of the bitmap; bitwise equal runs of 64 or 8
+      // values (the common case) are skipped with one `memcmp`
+      const bool trivial = std::is_trivially_copyable<Value>::value;
+      for(; i + 8 <= n; i += 8, count += 8){
+        if(trivial && i + 64 <= n &&
+           std::memcmp(x + i, y + i, 64 * sizeof(Value)) == 0){
+          std::memset(bits + count / 8, 0, 8);
+          i += 56, count += 56;
+          continue;
+        }
+        if(trivial && std::memcmp(x + i, y + i, 8 * sizeof(Value)) == 0){
+          bits[count / 8] = 0;
+          continue;
+        }
+        unsigned byte = 0;
+        for(unsigned k = 0; k < 8; ++k)
+          byte |= unsigned(!(x[i + k] == y[i + k])) << k;
+        bits[count / 8] = uint8_t(byte);
+      }
+      for(; i < n; ++i, ++count)
+        bits[count / 8] |= uint8_t(!(x[i] == y[i])) << (count % 8);
+      m.count = count;
+      return false;
+    }
+  };
+
+  template<class Archive>
+  struct DeltaSaveOp {
+    typedef DeltaState<Archive>& result_t;
+
+    template<class Value, class Value2>
+    FORCE_INLINE static bool apply(result_t s, const Value&, const Value2& y){
+      if(s.changed())
+        s.archive << y;
+      return false;
+    }
+
+    template<class Value>
+    static bool applyRange(result_t s, const Value*, const Value* y, size_t n){
+      s.forChanged(n, [&](size_t i){ s.archive << y[i]; });
+      return false;
+    }
+  };
+
+  template<class Archive>
+  struct DeltaLoadOp {
+    typedef DeltaState<Archive>& result_t;
+
+    template<class Value>
+    FORCE_INLINE static bool apply(result_t s, Value& v){
+      if(s.changed())
+        s.archive >> v;
+      return false;
+    }
+
+    template<class Value>
+    static bool applyRange(result_t s, Value* v, size_t n){
+      s.forChanged(n, [&](size_t i){ s.archive >> v[i]; });
+      return false;
+    }
+  };
+
+  namespace delta {
+
+    // the elements of ranges of the same length, with
+    // `Operator::applyRange` if possible (see 3.3)
+    template<class Operator, class Result, class It, class It2>
+    FORCE_INLINE bool elements(Result& r, It x, It2 y, size_t n, std::true_type){
+      return n && Operator::applyRange(r, Contiguous<It>::pointer(x),
+                                       Contiguous<It2>::pointer(y), n);
+    }
+
+    template<class Operator, class Result, class It, class It2>
+    FORCE_INLINE bool elements(Result& r, It x, It2 y, size_t n, std::false_type){
+      for(size_t i = 0; i < n; ++i, ++x, ++y)
+        if(Operator::apply(r, *x, *y))
+          return true;
+      return false;
+    }
+
+    template<class Operator, class Result, class It>
+    FORCE_INLINE bool elements(Result& r, It x, size_t n, std::true_type){
+      return n && Operator::applyRange(r, Contiguous<It>::pointer(x), n);
+    }
+
+    template<class Operator, class Result, class It>
+    FORCE_INLINE bool elements(Result& r, It x, size_t n, std::false_type){
+      for(size_t i = 0; i < n; ++i, ++x)
+        if(Operator::apply(r, *x))
+          return true;
+      return false;
+    }
+  }
+
+  // Combiners, that handle the lengths of ranges
+  template<class Target>
+  struct DeltaMasker : BinaryCombiner<DeltaMaskOp, Target, Target, DeltaMasker<Target> > {
+    FORCE_INLINE DeltaMasker(Target& prev, Target& cur, DeltaMask& m)
+      : DeltaMasker::BinaryCombiner(prev, cur, m){}
+
+    using DeltaMasker::BinaryCombiner::singleStep;
+
+    template<class A, class B>
+    FORCE_INLINE bool singleStep(Range<A, B> ac){
+      auto x = access(ac.a, this->target);
+      auto y = access(ac.a, this->target2);
+      const size_t n = size_t(std::distance(x, access(ac.b, this->target)));
+      const size_t m = size_t(std::distance(y, access(ac.b, this->target2)));
+      DeltaMaskOp::apply(this->result, n, m);
+      return n == m && delta::elements<DeltaMaskOp>(
+        this->result, x, y, n,
+        HasBinaryRangeKernel<DeltaMaskOp, DeltaMask&, decltype(x), decltype(y)>());
+    }
+  };
+
+  template<class Archive, class Target>
+  struct DeltaSave : BinaryCombiner<DeltaSaveOp<Archive>, Target, Target,
+                                    DeltaSave<Archive, Target> > {
+    FORCE_INLINE DeltaSave(Target& prev, Target& cur, DeltaState<Archive>& s)
+      : DeltaSave::BinaryCombiner(prev, cur, s){}
+
+    using DeltaSave::BinaryCombiner::singleStep;
+
+    template<class A, class B>
+    FORCE_INLINE bool singleStep(Range<A, B> ac){
+      if(this->result.changed())
+        return saveResized(ac);
+      auto x = access(ac.a, this->target);
+      auto y = access(ac.a, this->target2);
+      const size_t n = size_t(std::distance(x, access(ac.b, this->target)));
+      return delta::elements<DeltaSaveOp<Archive> >(
+        this->result, x, y, n,
+        HasBinaryRangeKernel<DeltaSaveOp<Archive>, DeltaState<Archive>&,
+                             decltype(x), decltype(y)>());
+    }
+
+  private:
+    template<class Accessor>
+    bool saveResized(Range<Begin<Accessor>, End<Accessor> > ac){
+      return SaveOp::applyContainer(this->result.archive, access(ac.a.m, this->target2));
+    }
+
+    template<class A, class B>
+    bool saveResized(Range<A, B> ac){
+      auto y = access(ac.a, this->target2);
+      const size_t m = size_t(std::distance(y, access(ac.b, this->target2)));
+      saveCount(this->result.archive, m);
+      for(size_t i = 0; i < m; ++i, ++y)
+        this->result.archive << *y;
+      return false;
+    }
+  };
+
+  template<class Archive, class Target>
+  struct DeltaLoad : UnaryCombiner<DeltaLoadOp<Archive>, Target, DeltaLoad<Archive, Target> > {
+    FORCE_INLINE DeltaLoad(Target& x, DeltaState<Archive>& s)
+      : DeltaLoad::UnaryCombiner(x, s){}
+
+    using DeltaLoad::UnaryCombiner::singleStep;
+
+    template<class A, class B>
+    FORCE_INLINE bool singleStep(Range<A, B> ac){
+      if(this->result.changed())
+        return loadResized(ac);
+      auto x = access(ac.a, this->target);
+      const size_t n = size_t(std::distance(x, access(ac.b, this->target)));
+      return delta::elements<DeltaLoadOp<Archive> >(
+        this->result, x, n,
+        HasUnaryRangeKernel<DeltaLoadOp<Archive>, DeltaState<Archive>&, decltype(x)>());
+    }
+
+  private:
+    template<class Accessor>
+    bool loadResized(Range<Begin<Accessor>, End<Accessor> > ac){
+      return LoadOp::applyContainer(this->result.archive, access(ac.a.m, this->target));
+    }
+
+    template<class A, class B>
+    bool loadResized(Range<A, B> ac){
+      auto x = access(ac.a, this->target);
+      const size_t n = size_t(std::distance(x, access(ac.b, this->target)));
+      if(loadCount(this->result.archive) != n)
+        throw std::runtime_error("applyDelta: a range has another length");
+      for(size_t i = 0; i < n; ++i, ++x)
+        this->result.archive >> *x;
+      return false;
+    }
+  };
+
+  template<class Target, class Archive>
+  void saveDelta(const Target& prev, const Target& cur, Archive& a){
+    std::vector<uint8_t> bitmap;
+    DeltaMask mask = {bitmap, 0};
+    DeltaMasker<const Target>(prev, cur, mask).callEnhance();
+    const std::vector<uint8_t>& saved = bitmap;
+    a << saved;
+    DeltaState<Archive> s = {a, bitmap, 0};
+    DeltaSave<Archive, const Target>(prev, cur, s).callEnhance();
+  }
+
+  // throws `std::runtime_error`, if the delta was saved for an object
+  // with another number of values
+  template<class Target, class Archive>
+  void applyDelta(Target& x, Archive& a){
+    std::vector<uint8_t> bitmap;
+    a >> bitmap;
+    DeltaState<Archive> s = {a, bitmap, 0};
+    DeltaLoad<Archive, Target>(x, s).callEnhance();
+    if((s.index + 7) / 8 != bitmap.size())
+      throw std::runtime_error("applyDelta: the delta is of another object");
+  }
+
+  /*
+    Tagged serialization
+
+    `saveTagged(x, a)` saves the values of `x` accessed through
+    `tag<N>(ac)` accessors (see 2.7) as fields, which readers of other
+    versions of `x` can skip or miss:
+
+    - a message is the varint number of bytes of its fields, followed
+      by the fields
+    - a field is the varint key `N << 3 | wire type`, followed by its
+      value in the encoding of the archive
+
+    The wire type tells readers how to skip the value:
+
+    - 0 varint: integers, `bool`s and enums of the compact encoding
+    - 1 fixed64, 5 fixed32: other trivially serializable values of 8
+      or 4 bytes
+    - 2 delimited: everything else, the varint number of bytes
+      followed by the value
+
+    Values of classes deriving from `TaggedSerializable` are saved as
+    messages (without another length). `loadTagged(x, a)` loads the
+    fields in one pass over the accessor list, as long as they come
+    in its order, then looks up the tags of the remaining fields.
+    Fields with unknown tags are skipped by their wire type, fields
+    missing from the data keep the values of `x`. Throws
+    `std::runtime_error`, if a known field has another wire type or
+    the data is corrupt. Works with the native binary archives.
+   */
+
+  template<class Derived> struct TaggedSerializable;
+
+  template<class Value>
+  struct IsTaggedMessage : std::is_base_of<TaggedSerializable<Value>, Value> {};
+
+  namespace tagged {
+
+    enum Wire { varint = 0, fixed64 = 1, delimited = 2, fixed32 = 5 };
+
+    template<class Encoding, class Value>
+    struct WireOf : std::integral_constant<Wire,
+      !IsTriviallySerializable<Value>::value ? delimited :
+      std::is_same<Encoding, CompactEncoding>::value &&
+      varint::IsInteger<Value>::value ? varint :
+      sizeof(Value) == 8 ? fixed64 :
+      sizeof(Value) == 4 ? fixed32 : delimited> {};
+
+    template<class Encoding>
+    FORCE_INLINE void saveVarint(BasicBinaryWriter<Encoding>& a, uint64_t v){
+      char buffer[10];
+      a.saveBinary(buffer, varint::encode(v, buffer));
+    }
+
+    template<class Encoding>
+    FORCE_INLINE uint64_t loadVarint(BasicBinaryReader<Encoding>& a){
+      uint64_t v;
+      const size_t len = varint::decode(a.current(), a.current() + a.remaining(), v);
+      if(!len)
+        throw std::runtime_error("loadTagged: invalid varint");
+      a.take(len);
+      return v;
+    }
+
+    // the bytes of a delimited value, which is removed from `a`
+    template<class Encoding>
+    BasicBinaryReader<Encoding> loadDelimited(BasicBinaryReader<Encoding>& a){
+      const uint64_t n = loadVarint(a);
+      if(n > a.remaining())
+        throw std::runtime_error("BinaryReader: unexpected end of data");
+      return BasicBinaryReader<Encoding>(a.take(size_t(n)), size_t(n));
+    }
+
+    // the key of the next field, if any, without removing it from `a`
+    template<class Encoding>
+    FORCE_INLINE bool peekKey(const BasicBinaryReader<Encoding>& a, uint64_t& key){
+      return varint::decode(a.current(), a.current() + a.remaining(), key) != 0;
+    }
+
+    template<class Encoding>
+    void skip(BasicBinaryReader<Encoding>& a, uint64_t wire){
+      switch(wire){
+      case varint: loadVarint(a); break;
+      case fixed64: a.take(8); break;
+      case fixed32: a.take(4); break;
+      case delimited: loadDelimited(a); break;
+      default: throw std::runtime_error("loadTagged: unknown wire type");
+      }
+    }
+
+    template<class Encoding, class Target>
+    void saveFields(const Target& x, BasicBinaryWriter<Encoding>& a);
+
+    template<class Encoding, class Target>
+    void loadFields(Target& x, BasicBinaryReader<Encoding>& a);
+
+    template<class Encoding, class Target>
+    size_t fieldsSize(const Target& x);
+
+    FORCE_INLINE size_t delimitedSize(size_t n){
+      return varint::size(n) + n;
+    }
+
+    template<class Encoding, class Value>
+    FORCE_INLINE size_t payloadSize(const Value& v, std::true_type){
+      return fieldsSize<Encoding>(v);
+    }
+
+    template<class Encoding, class Value>
+    FORCE_INLINE size_t payloadSize(const Value& v, std::false_type){
+      return BinarySize<Value>::template apply<Encoding>(v);
+    }
+
+    // the number of bytes saved by `saveField`
+    template<class Encoding, class Value>
+    size_t fieldSize(unsigned tag, const Value& v){
+      const Wire wire = WireOf<Encoding, Value>::value;
+      return varint::size(uint64_t(tag) << 3 | wire) +
+        (wire == delimited ? delimitedSize(payloadSize<Encoding>(v, IsTaggedMessage<Value>()))
+                           : BinarySize<Value>::template apply<Encoding>(v));
+    }
+
+    template<class Encoding, class Value>
+    FORCE_INLINE void savePayload(BasicBinaryWriter<Encoding>& a, const Value& v, std::true_type){
+      saveFields(v, a);
+    }
+
+    template<class Encoding, class Value>
+    FORCE_INLINE void savePayload(BasicBinaryWriter<Encoding>& a, const Value& v, std::false_type){
+      a << v;
+    }
+
+    template<class Encoding, class Value>
+    FORCE_INLINE void loadPayload(BasicBinaryReader<Encoding>& a, Value& v, std::true_type){
+      loadFields(v, a);
+    }
+
+    template<class Encoding, class Value>
+    FORCE_INLINE void loadPayload(BasicBinaryReader<Encoding>& a, Value& v, std::false_type){
+      a >> v;
+      if(a.remaining())
+        throw std::runtime_error("loadTagged: invalid field");
+    }
+
+    // saves the payload written by `f` with its length in front. A
+    // placeholder of one byte avoids moving payloads below 128 bytes.
+    template<class Encoding, class F>
+    void saveDelimited(BasicBinaryWriter<Encoding>& a, F f){
+      const size_t start = a.size();
+      a.saveBinary("", 1);
+      f();
+      char buffer[10];
+      a.replaceBinary(start, 1, buffer, varint::encode(a.size() - start - 1, buffer));
+    }
+
+    // key and value of fields, that are not delimited, are saved with
+    // a single call
+    template<class Encoding, class Value>
+    FORCE_INLINE void saveField(BasicBinaryWriter<Encoding>& a, unsigned tag, const Value& v,
+                                std::integral_constant<Wire, varint>){
+      char buffer[20];
+      size_t n = varint::encode(uint64_t(tag) << 3 | varint, buffer);
+      n += varint::encode(varint::toUnsigned(v), buffer + n);
+      a.saveBinary(buffer, n);
+    }
+
+    template<class Encoding, class Value, Wire wire>
+    FORCE_INLINE void saveField(BasicBinaryWriter<Encoding>& a, unsigned tag, const Value& v,
+                                std::integral_constant<Wire, wire>){
+      char buffer[10 + sizeof(Value)];
+      const size_t n = varint::encode(uint64_t(tag) << 3 | wire, buffer);
+      std::memcpy(buffer + n, std::addressof(v), sizeof(Value));
+      a.saveBinary(buffer, n + sizeof(Value));
+    }
+
+    template<class Encoding, class Value>
+    void saveField(BasicBinaryWriter<Encoding>& a, unsigned tag, const Value& v,
+                   std::integral_constant<Wire, delimited>){
+      saveVarint(a, uint64_t(tag) << 3 | delimited);
+      saveDelimited(a, [&]{ savePayload(a, v, IsTaggedMessage<Value>()); });
+    }
+
+    template<class Encoding, class Value>
+    FORCE_INLINE void saveField(BasicBinaryWriter<Encoding>& a, unsigned tag, const Value& v){
+      saveField(a, tag, v, WireOf<Encoding, Value>());
+    }
+
+    template<class Encoding, class Value>
+    void loadField(BasicBinaryReader<Encoding>& a, uint64_t wire, Value& v){
+      if(wire != uint64_t(WireOf<Encoding, Value>::value))
+        throw std::runtime_error("loadTagged: field has another wire type");
+      if(wire != delimited){
+        a >> v;
+        return;
+      }
+      BasicBinaryReader<Encoding> payload = loadDelimited(a);
+      loadPayload(payload, v, IsTaggedMessage<Value>());
+    }
+  }
+
+  // tagged serialization only handles `tag<N>` accessors (see
+  // `TaggedSaver` etc. below), other accessors end up here
+  template<class Result>
+  struct TaggedOnlyOp {
+    typedef Result& result_t;
+
+    template<class Value>
+    static bool apply(result_t, const Value&){
+      static_assert(sizeof(Value) == 0, "tagged serialization needs `tag<N>(ac)` accessors");
+      return false;
+    }
+  };
+
+  template<class Encoding>
+  struct TaggedSearch {
+    BasicBinaryReader<Encoding>& archive;
+    uint64_t key;
+    bool found;
+  };
+
+  // saves all fields
+  template<class Encoding, class Target>
+  struct TaggedSaver : UnaryCombiner<TaggedOnlyOp<BasicBinaryWriter<Encoding> >, Target,
+                                     TaggedSaver<Encoding, Target> > {
+
+    FORCE_INLINE TaggedSaver(Target& target, BasicBinaryWriter<Encoding>& a)
+      : TaggedSaver::UnaryCombiner(target, a){};
+
+    using TaggedSaver::UnaryCombiner::singleStep;
+
+    template<unsigned Tag, class Accessor>
+    FORCE_INLINE bool singleStep(Tagged<Tag, Accessor> ac){
+      tagged::saveField(this->result, Tag, access(ac.m, this->target));
+      return false;
+    }
+  };
+
+  // loads the fields, that come in the order of the accessor list
+  template<class Encoding, class Target>
+  struct TaggedLoader : UnaryCombiner<TaggedOnlyOp<BasicBinaryReader<Encoding> >, Target,
+                                      TaggedLoader<Encoding, Target> > {
+
+    FORCE_INLINE TaggedLoader(Target& target, BasicBinaryReader<Encoding>& a)
+      : TaggedLoader::UnaryCombiner(target, a){};
+
+    using TaggedLoader::UnaryCombiner::singleStep;
+
+    template<unsigned Tag, class Accessor>
+    FORCE_INLINE bool singleStep(Tagged<Tag, Accessor> ac){
+      uint64_t key;
+      if(!tagged::peekKey(this->result, key) || key >> 3 != Tag)
+        return false;
+      tagged::loadVarint(this->result);
+      tagged::loadField(this->result, key & 7, access(ac.m, this->target));
+      return false;
+    }
+  };
+
+  // loads the field with the searched key, if its tag is known
+  template<class Encoding, class Target>
+  struct TaggedFinder : UnaryCombiner<TaggedOnlyOp<TaggedSearch<Encoding> >, Target,
+                                      TaggedFinder<Encoding, Target> > {
+
+    FORCE_INLINE TaggedFinder(Target& target, TaggedSearch<Encoding>& search)
+      : TaggedFinder::UnaryCombiner(target, search){};
+
+    using TaggedFinder::UnaryCombiner::singleStep;
+
+    template<unsigned Tag, class Accessor>
+    FORCE_INLINE bool singleStep(Tagged<Tag, Accessor> ac){
+      if(this->result.key >> 3 != Tag)
+        return false;
+      tagged::loadField(this->result.archive, this->result.key & 7,
+                        access(ac.m, this->target));
+      this->result.found = true;
+      return true;
+    }
+  };
+
+  // sums up the sizes of the fields
+  template<class Encoding, class Target>
+  struct TaggedSizer : UnaryCombiner<TaggedOnlyOp<size_t>, Target,
+                                     TaggedSizer<Encoding, Target> > {
+
+    FORCE_INLINE TaggedSizer(Target& target, size_t& bytes)
+      : TaggedSizer::UnaryCombiner(target, bytes){};
+
+    using TaggedSizer::UnaryCombiner::singleStep;
+
+    template<unsigned Tag, class Accessor>
+    FORCE_INLINE bool singleStep(Tagged<Tag, Accessor> ac){
+      this->result += tagged::fieldSize<Encoding>(Tag, access(ac.m, this->target));
+      return false;
+    }
+  };
+
+  namespace tagged {
+
+    template<class Encoding, class Target>
+    size_t fieldsSize(const Target& x){
+      size_t bytes = 0;
+      TaggedSizer<Encoding, const Target>(x, bytes).callEnhance();
+      return bytes;
+    }
+
+    template<class Encoding, class Target>
+    void saveFields(const Target& x, BasicBinaryWriter<Encoding>& a){
+      TaggedSaver<Encoding, const Target>(x, a).callEnhance();
+    }
+
+    template<class Encoding, class Target>
+    void loadFields(Target& x, BasicBinaryReader<Encoding>& a){
+      TaggedLoader<Encoding, Target>(x, a).callEnhance();
+      while(a.remaining()){
+        TaggedSearch<Encoding> search = {a, loadVarint(a), false};
+        TaggedFinder<Encoding, Target>(x, search).callEnhance();
+        if(!search.found)
+          skip(a, search.key & 7);
+      }
+    }
+  }
+
+  template<class Target, class Encoding>
+  void saveTagged(const Target& x, BasicBinaryWriter<Encoding>& a){
+    tagged::saveDelimited(a, [&]{ tagged::saveFields(x, a); });
+  }
+
+  template<class Target, class Encoding>
+  void loadTagged(Target& x, BasicBinaryReader<Encoding>& a){
+    BasicBinaryReader<Encoding> fields = tagged::loadDelimited(a);
+    tagged::loadFields(x, fields);
+  }
+
+  template<class Value>
+  struct BinarySize<Value, typename std::enable_if<IsTaggedMessage<Value>::value>::type> {
+    template<class Encoding>
+    static size_t apply(const Value& v){
+      return tagged::delimitedSize(tagged::fieldsSize<Encoding>(v));
+    }
+  };
+
+  //base function for tagged `serialize` member function inheritance
+  template<class Derived>
+  struct TaggedSerializable {
+
+    // the version is not needed, the tags tell the fields apart
+    template<class Archive>
+    void serialize(Archive& ar, const unsigned int){
+      split(ar, typename Archive::is_saving());
+    }
+
+  private:
+    template<class Archive>
+    void split(Archive& ar, std::true_type){
+      saveTagged(static_cast<const Derived&>(*this), ar);
+    }
+
+    template<class Archive>
+    void split(Archive& ar, std::false_type){
+      loadTagged(static_cast<Derived&>(*this), ar);
+    }
+  };
+
+  /*
+    Flat buffers
+
+    `toFlat(x)` lays out the accessed data members of `x` in a byte
+    buffer, from which `View<T>` reads single members in place,
+    without deserializing the object:
+
+    - the fixed part holds one slot per data member in the order of
+      the accessor list, without padding: arithmetic and enum values
+      as their bytes, classes with an `enhance` member as their own
+      fixed part, strings and `std::vector`s of trivially serializable
+      values as offset (from the start of the buffer) and number of
+      elements, two `uint32_t`s
+    - the variable part holds the contents of the strings and vectors
+
+    Values are stored in native byte order and read with `memcpy`, so
+    the buffer needs no alignment. Only data member accessors are
+    supported and `T` has to be default constructible. Specialize
+    `FlatField` for other member types.
+   */
+
+  // a string in a flat buffer
+  class FlatString {
+  public:
+    FlatString(const char* p, size_t n) : p(p), n(n){}
+
+    const char* data() const{ return p; }
+    size_t size() const{ return n; }
+    bool empty() const{ return n == 0; }
+    char operator[](size_t i) const{ return p[i]; }
+    std::string str() const{ return std::string(p, n); }
+
+    bool operator==(const std::string& y) const{
+      return n == y.size() && std::memcmp(p, y.data(), n) == 0;
+    }
+
+    bool operator!=(const std::string& y) const{
+      return !(*this == y);
+    }
+
+  private:
+    const char* p;
+    size_t n;
+  };
+
+  // a vector in a flat buffer, its elements are possibly unaligned
+  template<class Value>
+  class FlatArray {
+  public:
+    FlatArray(const char* p, size_t n) : p(p), n(n){}
+
+    const char* data() const{ return p; }
+    size_t size() const{ return n; }
+    bool empty() const{ return n == 0; }
+
+    FORCE_INLINE Value operator[](size_t i) const{
+      Value v;
+      std::memcpy(&v, p + i * sizeof(Value), sizeof(Value));
+      return v;
+    }
+
+    std::vector<Value> vector() const{
+      std::vector<Value> v(n);
+      std::memcpy(v.data(), p, n * sizeof(Value));
+      return v;
+    }
+
+  private:
+    const char* p;
+    size_t n;
+  };
+
+  // a string or vector in the fixed part of a flat layout
+  struct FlatVariable {
+    size_t slot;
+    size_t elementSize;
+  };
+
+  struct FlatSlots {
+    enum : uint32_t { npos = uint32_t(-1) };
+
+    // size of the fixed part
+    size_t fixedSize;
+    // all strings and vectors, including those of nested classes
+    std::vector<FlatVariable> variables;
+    // the slot of the data member at each offset of the object
+    std::vector<uint32_t> slots;
+  };
+
+  struct FlatWriterState {
+    std::vector<char>& bytes;
+    // the next slot
+    size_t pos;
+  };
+
+  struct FlatReaderState {
+    const char* base;
+    // the next slot
+    const char* pos;
+  };
+
+  template<class Target> class View;
+
+  template<class Value, class Enable = void>
+  struct FlatField {
+    static_assert(sizeof(Value) == 0, "no flat layout, specialize `FlatField`");
+  };
+
+  namespace flatbuffer {
+
+    // the offset of data member `m` in `x`
+    template<class Target, class Value, class T>
+    FORCE_INLINE size_t memberOffset(const Target& x, Value T::* m){
+      return size_t(reinterpret_cast<const char*>(&access(m, x)) -
+                    reinterpret_cast<const char*>(&x));
+    }
+
+    // writes offset and number of the `n` elements at `p` into the
+    // next slot and appends them to the variable part
+    inline void writeVariable(FlatWriterState& w, const void* p, size_t n,
+                              size_t elementSize){
+      const size_t offset = w.bytes.size();
+      if(n * elementSize > FlatSlots::npos - offset)
+        throw std::length_error("flat buffers are limited to 4 GiB");
+      const uint32_t slot[2] = {uint32_t(offset), uint32_t(n)};
+      std::memcpy(&w.bytes[w.pos], slot, sizeof(slot));
+      w.pos += sizeof(slot);
+      const char* c = static_cast<const char*>(p);
+      w.bytes.insert(w.bytes.end(), c, c + n * elementSize);
+    }
+
+    FORCE_INLINE void readVariable(const char* slot, uint32_t& offset, uint32_t& n){
+      uint32_t s[2];
+      std::memcpy(s, slot, sizeof(s));
+      offset = s[0];
+      n = s[1];
+    }
+
+    inline void addVariable(FlatSlots& l, size_t elementSize){
+      l.variables.push_back(FlatVariable{l.fixedSize, elementSize});
+      l.fixedSize += 2 * sizeof(uint32_t);
+    }
+  }
+
+  struct FlatWriteOp {
+    typedef FlatWriterState& result_t;
+
+    template<class Value>
+    FORCE_INLINE static bool apply(result_t w, const Value& v){
+      FlatField<Value>::write(w, v);
+      return false;
+    }
+  };
+
+  struct FlatReadOp {
+    typedef FlatReaderState& result_t;
+
+    template<class Value>
+    FORCE_INLINE static bool apply(result_t r, Value& v){
+      FlatField<Value>::load(r, v);
+      return false;
+    }
+  };
+
+  // layouts are built from data member accessors only, other
+  // accessors end up here
+  template<class Layout>
+  struct LayoutOp {
+    typedef Layout& result_t;
+
+    template<class Value>
+    static bool apply(result_t, const Value&){
+      static_assert(sizeof(Value) == 0, "flat buffers only support data member accessors");
+      return false;
+    }
+  };
+
+  // Combiner aliases
+  template<class Target>
+  using FlatWriter = UnaryCombiner<FlatWriteOp, Target>;
+
+  template<class Target>
+  using FlatReader = UnaryCombiner<FlatReadOp, Target>;
+
+  // assigns the slots of the data members of `Target`
+  template<class Target>
+  struct FlatLayouter : UnaryCombiner<LayoutOp<FlatSlots>, Target, FlatLayouter<Target> > {
+
+    FORCE_INLINE FlatLayouter(Target& target, FlatSlots& slots)
+      : FlatLayouter::UnaryCombiner(target, slots){};
+
+    using FlatLayouter::UnaryCombiner::singleStep;
+
+    template<class Value, class T>
+    typename std::enable_if<!std::is_function<Value>::value, bool>::type
+    singleStep(Value T::* ac){
+      const size_t offset = flatbuffer::memberOffset(this->target, ac);
+      this->result.slots[offset] = uint32_t(this->result.fixedSize);
+      FlatField<typename std::remove_const<Value>::type>::layout(this->result);
+      return false;
+    }
+  };
+
+  // the flat layout of `Target`, computed once
+  template<class Target>
+  class FlatLayout : public FlatSlots {
+  public:
+    static const FlatLayout& get(){
+      static const FlatLayout layout;
+      return layout;
+    }
+
+    // the offset of the slot of data member `m` in the fixed part
+    template<class Value, class T>
+    FORCE_INLINE size_t slot(Value T::* m) const{
+      const uint32_t s = slots[flatbuffer::memberOffset(probe, m)];
+      if(s == npos)
+        throw std::invalid_argument("member is not in the accessor list");
+      return s;
+    }
+
+  private:
+    FlatLayout() : FlatSlots{0, {}, std::vector<uint32_t>(sizeof(Target), npos)}{
+      FlatLayouter<const Target>(probe, *this).callEnhance();
+    }
+
+    // a default constructed object to find the offsets of members
+    const Target probe{};
+  };
+
+  template<class Value>
+  struct FlatField<Value, typename std::enable_if<
+                            IsTriviallySerializable<Value>::value>::type> {
+    typedef Value view_t;
+
+    static void layout(FlatSlots& l){
+      l.fixedSize += sizeof(Value);
+    }
+
+    FORCE_INLINE static void write(FlatWriterState& w, const Value& v){
+      std::memcpy(&w.bytes[w.pos], std::addressof(v), sizeof(Value));
+      w.pos += sizeof(Value);
+    }
+
+    FORCE_INLINE static view_t read(const char*, const char*, const char* slot){
+      Value v;
+      std::memcpy(std::addressof(v), slot, sizeof(Value));
+      return v;
+    }
+
+    FORCE_INLINE static void load(FlatReaderState& r, Value& v){
+      std::memcpy(std::addressof(v), r.pos, sizeof(Value));
+      r.pos += sizeof(Value);
+    }
+  };
+
+  template<>
+  struct FlatField<std::string> {
+    typedef FlatString view_t;
+
+    static void layout(FlatSlots& l){
+      flatbuffer::addVariable(l, 1);
+    }
+
+    static void write(FlatWriterState& w, const std::string& v){
+      flatbuffer::writeVariable(w, v.data(), v.size(), 1);
+    }
+
+    FORCE_INLINE static view_t read(const char* base, const char*, const char* slot){
+      uint32_t offset, n;
+      flatbuffer::readVariable(slot, offset, n);
+      return FlatString(base + offset, n);
+    }
+
+    static void load(FlatReaderState& r, std::string& v){
+      uint32_t offset, n;
+      flatbuffer::readVariable(r.pos, offset, n);
+      r.pos += 2 * sizeof(uint32_t);
+      v.assign(r.base + offset, n);
+    }
+  };
+
+  template<class Value, class Allocator>
+  struct FlatField<std::vector<Value, Allocator>, typename std::enable_if<
+                                                    IsBulkSerializable<Value>::value>::type> {
+    typedef FlatArray<Value> view_t;
+
+    static void layout(FlatSlots& l){
+      flatbuffer::addVariable(l, sizeof(Value));
+    }
+
+    static void write(FlatWriterState& w, const std::vector<Value, Allocator>& v){
+      flatbuffer::writeVariable(w, v.data(), v.size(), sizeof(Value));
+    }
+
+    FORCE_INLINE static view_t read(const char* base, const char*, const char* slot){
+      uint32_t offset, n;
+      flatbuffer::readVariable(slot, offset, n);
+      return FlatArray<Value>(base + offset, n);
+    }
+
+    static void load(FlatReaderState& r, std::vector<Value, Allocator>& v){
+      uint32_t offset, n;
+      flatbuffer::readVariable(r.pos, offset, n);
+      r.pos += 2 * sizeof(uint32_t);
+      v.resize(n);
+      if(n)
+        std::memcpy(v.data(), r.base + offset, n * sizeof(Value));
+    }
+  };
+
+  // classes with an `enhance` member are nested in the fixed part
+  template<class Value>
+  struct FlatField<Value, typename Void<decltype(
+      std::declval<const Value&>().enhance(
+        std::declval<FlatWriter<const Value>&>()))>::type> {
+    typedef View<Value> view_t;
+
+    static void layout(FlatSlots& l){
+      const FlatLayout<Value>& nested = FlatLayout<Value>::get();
+      for(const FlatVariable& v : nested.variables)
+        l.variables.push_back(FlatVariable{l.fixedSize + v.slot, v.elementSize});
+      l.fixedSize += nested.fixedSize;
+    }
+
+    static void write(FlatWriterState& w, const Value& v){
+      FlatWriter<const Value>(v, w).callEnhance();
+    }
+
+    FORCE_INLINE static view_t read(const char* base, const char* end, const char* slot){
+      return View<Value>(base, end, slot);
+    }
+
+    static void load(FlatReaderState& r, Value& v){
+      FlatReader<Value>(v, r).callEnhance();
+    }
+  };
+
+  // the flat buffer of the accessed data members of `x`
+  template<class Target>
+  std::vector<char> toFlat(const Target& x){
+    std::vector<char> bytes(FlatLayout<Target>::get().fixedSize);
+    FlatWriterState w = {bytes, 0};
+    FlatWriter<const Target>(x, w).callEnhance();
+    return bytes;
+  }
+
+  // reads the members of a `Target` from a flat buffer, without
+  // copying it. The buffer has to outlive the view and all strings,
+  // arrays and views obtained from it.
+  template<class Target>
+  class View {
+  public:
+    // does not check the buffer, see `valid` and `flatView`
+    View(const char* data, size_t n) : base(data), fixed(data), end(data + n){}
+
+    explicit View(const std::vector<char>& bytes)
+      : View(bytes.data(), bytes.size()){}
+
+    // the member `m`, e.g. `view.get(&T::name)`
+    template<class Value, class T>
+    FORCE_INLINE typename FlatField<typename std::remove_const<Value>::type>::view_t
+    get(Value T::* m) const{
+      return FlatField<typename std::remove_const<Value>::type>::read(
+        base, end, fixed + FlatLayout<Target>::get().slot(m));
+    }
+
+    // whether the fixed part and all strings and vectors (also those of
+    // nested classes) lie within the buffer. Afterwards all members
+    // can be read without checks.
+    bool valid() const{
+      const FlatLayout<Target>& l = FlatLayout<Target>::get();
+      if(size_t(end - fixed) < l.fixedSize)
+        return false;
+      const size_t n = size_t(end - base);
+      for(const FlatVariable& v : l.variables){
+        uint32_t offset, count;
+        flatbuffer::readVariable(fixed + v.slot, offset, count);
+        if(offset > n || uint64_t(count) * v.elementSize > n - offset)
+          return false;
+      }
+      return true;
+    }
+
+    // the object, with all accessed data members read from the buffer
+    Target decode() const{
+      Target x{};
+      FlatReaderState r = {base, fixed};
+      FlatReader<Target>(x, r).callEnhance();
+      return x;
+    }
+
+  private:
+    template<class, class> friend struct FlatField;
+
+    // a nested object, whose fixed part starts at `fixed`
+    View(const char* base, const char* end, const char* fixed)
+      : base(base), fixed(fixed), end(end){}
+
+    const char* base;
+    const char* fixed;
+    const char* end;
+  };
+
+  // a view of a flat buffer, that throws `std::runtime_error` if it
+  // is not `valid`
+  template<class Target>
+  View<Target> flatView(const char* data, size_t n){
+    View<Target> v(data, n);
+    if(!v.valid())
+      throw std::runtime_error("flatView: invalid flat buffer");
+    return v;
+  }
+
+  template<class Target>
+  View<Target> flatView(const std::vector<char>& bytes){
+    return flatView<Target>(bytes.data(), bytes.size());
+  }
+
+  // a read only file in memory: mapped on POSIX systems, read
+  // elsewhere. Throws `std::runtime_error`, if it cannot be opened.
+  class MappedFile {
+  public:
+    explicit MappedFile(const std::string& path){
+#ifdef ENHANCE_MMAP
+      const int fd = ::open(path.c_str(), O_RDONLY);
+      if(fd < 0)
+        throw std::runtime_error("cannot open " + path);
+      struct stat st;
+      if(fstat(fd, &st) != 0){
+        ::close(fd);
+        throw std::runtime_error("cannot open " + path);
+      }
+      n = size_t(st.st_size);
+      void* p = n ? mmap(nullptr, n, PROT_READ, MAP_SHARED, fd, 0) : nullptr;
+      ::close(fd);
+      if(p == MAP_FAILED)
+        throw std::runtime_error("cannot map " + path);
+      bytes = static_cast<const char*>(p);
+#else
+      std::ifstream in(path, std::ios::binary);
+      if(!in)
+        throw std::runtime_error("cannot open " + path);
+      content.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+      bytes = content.data();
+      n = content.size();
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile(){
+#ifdef ENHANCE_MMAP
+      if(n)
+        munmap(const_cast<char*>(bytes), n);
+#endif
+    }
+
+    const char* data() const{ return bytes; }
+    size_t length() const{ return n; }
+
+  private:
+#ifndef ENHANCE_MMAP
+    std::vector<char> content;
+#endif
+    const char* bytes;
+    size_t n;
+  };
+
+  /*
+    Memory mapped record files
+
+    `MappedRecordFile<T>::write` stores objects as flat buffers one
+    after another. Types without strings and vectors have records of
+    equal size (their fixed part), otherwise the records are preceded
+    by an index of their offsets. Opening a file maps it into memory
+    (on POSIX systems, otherwise it is read), after which record `i`
+    is available in O(1), as a `View<T>` or decoded.
+
+    File format (native byte order):
+
+      header   "ENHREC1\0", count, size of the fixed part, stride (0 if
+               indexed), all `uint64_t`
+      index    count + 1 offsets relative to the records (if indexed)
+      records  flat buffers
+   */
+
+  template<class Target>
+  class MappedRecordFile {
+  public:
+    // maps the file, throws `std::runtime_error` if it cannot be
+    // opened or was not written for `Target`. The index and the
+    // records are not checked, see `valid`.
+    explicit MappedRecordFile(const std::string& path) : file(path){
+      readHeader(path);
+    }
+
+    size_t size() const{ return count; }
+
+    // record `i` in place
+    FORCE_INLINE View<Target> view(size_t i) const{
+      if(stride)
+        return View<Target>(records + i * stride, stride);
+      return View<Target>(records + index[i], size_t(index[i + 1] - index[i]));
+    }
+
+    // record `i` decoded
+    Target operator[](size_t i) const{
+      return view(i).decode();
+    }
+
+    // whether the index and all records are valid
+    bool valid() const{
+      for(size_t i = 0; !stride && i < count; ++i)
+        if(index[i] > index[i + 1])
+          return false;
+      for(size_t i = 0; i < count; ++i)
+        if(!view(i).valid())
+          return false;
+      return true;
+    }
+
+    template<class It>
+    static void write(const std::string& path, It first, It last){
+      std::ofstream out(path, std::ios::binary | std::ios::trunc);
+      const size_t fixedSize = FlatLayout<Target>::get().fixedSize;
+      const bool indexed = fixedSize == 0 || !FlatLayout<Target>::get().variables.empty();
+      Header h;
+      std::memcpy(h.magic, magic(), sizeof(h.magic));
+      h.count = uint64_t(std::distance(first, last));
+      h.fixedSize = fixedSize;
+      h.stride = indexed ? 0 : fixedSize;
+      out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+
+      std::vector<uint64_t> offsets(1, 0);
+      if(indexed){
+        // the index is written after the records are known
+        offsets.reserve(size_t(h.count) + 1);
+        out.seekp(std::streamoff((h.count + 1) * sizeof(uint64_t)), std::ios::cur);
+      }
+      for(; first != last; ++first){
+        const std::vector<char> flat = toFlat(*first);
+        out.write(flat.data(), std::streamsize(flat.size()));
+        if(indexed)
+          offsets.push_back(offsets.back() + flat.size());
+      }
+      if(indexed){
+        out.seekp(std::streamoff(sizeof(h)));
+        out.write(reinterpret_cast<const char*>(offsets.data()),
+                  std::streamsize(offsets.size() * sizeof(uint64_t)));
+      }
+      if(!out)
+        throw std::runtime_error("MappedRecordFile: cannot write " + path);
+    }
+
+    static void write(const std::string& path, const std::vector<Target>& records){
+      write(path, records.begin(), records.end());
+    }
+
+  private:
+    struct Header {
+      char magic[8];
+      uint64_t count;
+      uint64_t fixedSize;
+      uint64_t stride;
+    };
+
+    static const char* magic(){ return "ENHREC1"; }
+
+    void readHeader(const std::string& path){
+      const char* bytes = file.data();
+      const size_t length = file.length();
+      if(length < sizeof(Header))
+        throw std::runtime_error("MappedRecordFile: " + path + " is no record file");
+      Header h;
+      std::memcpy(&h, bytes, sizeof(h));
+      const size_t fixedSize = FlatLayout<Target>::get().fixedSize;
+      if(std::memcmp(h.magic, magic(), sizeof(h.magic)) != 0 || h.fixedSize != fixedSize ||
+         (h.stride != 0 && h.stride != fixedSize))
+        throw std::runtime_error("MappedRecordFile: " + path + " has another format");
+      count = size_t(h.count);
+      stride = size_t(h.stride);
+      const size_t available = length - sizeof(Header);
+      if(stride != 0){
+        records = bytes + sizeof(Header);
+        if(count > available / stride)
+          throw std::runtime_error("MappedRecordFile: " + path + " is truncated");
+      }else{
+        if(count >= available / sizeof(uint64_t))
+          throw std::runtime_error("MappedRecordFile: " + path + " is truncated");
+        index = reinterpret_cast<const uint64_t*>(bytes + sizeof(Header));
+        records = bytes + sizeof(Header) + (count + 1) * sizeof(uint64_t);
+        if(index[count] > size_t(bytes + length - records))
+          throw std::runtime_error("MappedRecordFile: " + path + " is truncated");
+      }
+    }
+
+    MappedFile file;
+    size_t count = 0;
+    size_t stride = 0;
+    const uint64_t* index = nullptr;
+    const char* records = nullptr;
+  };
+
+  /*
+    Columnar serialization
+
+    `toColumns(rows)` stores a vector of objects column by column: each
+    accessed data member becomes a contiguous column, so a scan of one
+    member reads only its column and equal values end up next to each
+    other. `ColumnReader<T>` reads single columns in place from such a
+    buffer, `ColumnFile<T>` from a mapped file.
+
+    Format (native byte order, all sections aligned to 8 bytes):
+
+      header     "ENHCOL1\0", number of rows, number of columns
+      directory  per column: offset, length and width (see below)
+      columns    fixed width (arithmetic types and enums): the values;
+                 otherwise (strings, vectors, classes with an `enhance`
+                 member as flat buffers): rows + 1 offsets relative to
+                 the end of the offsets, followed by the contents
+
+    Fixed width columns of mapped files can be used as arrays. Only
+    data member accessors are supported and `T` has to be default
+    constructible.
+   */
+
+  // fixed width columns have the `width` of their values, all others 0
+  template<class Value, class Enable = void>
+  struct ColumnField {
+    static_assert(sizeof(Value) == 0, "no column layout, specialize `ColumnField`");
+  };
+
+  template<class Value>
+  struct ColumnField<Value, typename std::enable_if<
+                             IsTriviallySerializable<Value>::value>::type> {
+    enum : size_t { width = sizeof(Value) };
+    typedef Value view_t;
+
+    FORCE_INLINE static void append(std::vector<char>& d, const Value& v){
+      const char* p = reinterpret_cast<const char*>(std::addressof(v));
+      d.insert(d.end(), p, p + sizeof(Value));
+    }
+
+    FORCE_INLINE static view_t view(const char* p, size_t){
+      Value v;
+      std::memcpy(std::addressof(v), p, sizeof(Value));
+      return v;
+    }
+
+    FORCE_INLINE static void load(const char* p, size_t, Value& v){
+      std::memcpy(std::addressof(v), p, sizeof(Value));
+    }
+
+    static bool valid(const char*, size_t){
+      return true;
+    }
+  };
+
+  template<>
+  struct ColumnField<std::string> {
+    enum : size_t { width = 0 };
+    typedef FlatString view_t;
+
+    static void append(std::vector<char>& d, const std::string& v){
+      d.insert(d.end(), v.begin(), v.end());
+    }
+
+    FORCE_INLINE static view_t view(const char* p, size_t n){
+      return FlatString(p, n);
+    }
+
+    static void load(const char* p, size_t n, std::string& v){
+      v.assign(p, n);
+    }
+
+    static bool valid(const char*, size_t){
+      return true;
+    }
+  };
+
+  template<class Value, class Allocator>
+  struct ColumnField<std::vector<Value, Allocator>, typename std::enable_if<
+                                                     IsBulkSerializable<Value>::value>::type> {
+    enum : size_t { width = 0 };
+    typedef FlatArray<Value> view_t;
+
+    static void append(std::vector<char>& d, const std::vector<Value, Allocator>& v){
+      const char* p = reinterpret_cast<const char*>(v.data());
+      d.insert(d.end(), p, p + v.size() * sizeof(Value));
+    }
+
+    FORCE_INLINE static view_t view(const char* p, size_t n){
+      return FlatArray<Value>(p, n / sizeof(Value));
+    }
+
+    static void load(const char* p, size_t n, std::vector<Value, Allocator>& v){
+      v.resize(n / sizeof(Value));
+      if(n)
+        std::memcpy(v.data(), p, n);
+    }
+
+    static bool valid(const char*, size_t n){
+      return n % sizeof(Value) == 0;
+    }
+  };
+
+  // classes with an `enhance` member are stored as flat buffers
+  template<class Value>
+  struct ColumnField<Value, typename Void<decltype(
+      std::declval<const Value&>().enhance(
+        std::declval<FlatWriter<const Value>&>()))>::type> {
+    enum : size_t { width = 0 };
+    typedef View<Value> view_t;
+
+    static void append(std::vector<char>& d, const Value& v){
+      const std::vector<char> flat = toFlat(v);
+      d.insert(d.end(), flat.begin(), flat.end());
+    }
+
+    FORCE_INLINE static view_t view(const char* p, size_t n){
+      return View<Value>(p, n);
+    }
+
+    static void load(const char* p, size_t n, Value& v){
+      v = View<Value>(p, n).decode();
+    }
+
+    static bool valid(const char* p, size_t n){
+      return View<Value>(p, n).valid();
+    }
+  };
+
+  // a column of `ColumnReader`
+  template<class Value>
+  class ColumnView {
+  public:
+    typedef ColumnField<Value> field_t;
+    typedef typename field_t::view_t view_t;
+
+    ColumnView(const char* column, size_t rows)
+      : offsets(column), values(field_t::width != 0 ? column : column + (rows + 1) * 8), rows(rows){}
+
+    size_t size() const{ return rows; }
+
+    // the values of fixed width columns, the contents otherwise
+    const char* data() const{ return values; }
+
+    FORCE_INLINE view_t operator[](size_t i) const{
+      const char* p;
+      size_t n;
+      locate(i, p, n);
+      return field_t::view(p, n);
+    }
+
+    FORCE_INLINE void load(size_t i, Value& v) const{
+      const char* p;
+      size_t n;
+      locate(i, p, n);
+      field_t::load(p, n, v);
+    }
+
+    // whether the offsets are ascending and lie within the `length`
+    // bytes of the column and all values are valid
+    bool valid(size_t length) const{
+      if(field_t::width != 0)
+        return length / field_t::width >= rows;
+      if(length / 8 <= rows)
+        return false;
+      const size_t contents = length - (rows + 1) * 8;
+      uint64_t previous = 0;
+      for(size_t i = 0; i <= rows; ++i){
+        uint64_t o;
+        std::memcpy(&o, offsets + i * 8, 8);
+        if(o < previous || o > contents)
+          return false;
+        if(i > 0 && !field_t::valid(values + previous, size_t(o - previous)))
+          return false;
+        previous = o;
+      }
+      return true;
+    }
+
+  private:
+    FORCE_INLINE void locate(size_t i, const char*& p, size_t& n) const{
+      if(field_t::width != 0){
+        p = values + i * field_t::width;
+        n = field_t::width;
+      }else{
+        uint64_t o[2];
+        std::memcpy(o, offsets + i * 8, sizeof(o));
+        p = values + o[0];
+        n = size_t(o[1] - o[0]);
+      }
+    }
+
+    const char* offsets;
+    const char* values;
+    size_t rows;
+  };
+
+  struct ColumnSlots {
+    // per column, 0 if not fixed width
+    std::vector<uint64_t> widths;
+    // the column of the data member at each offset of the object
+    std::vector<uint32_t> columns;
+  };
+
+  // assigns the columns of the data members of `Target`
+  template<class Target>
+  struct ColumnLayouter : UnaryCombiner<LayoutOp<ColumnSlots>, Target, ColumnLayouter<Target> > {
+
+    FORCE_INLINE ColumnLayouter(Target& target, ColumnSlots& slots)
+      : ColumnLayouter::UnaryCombiner(target, slots){};
+
+    using ColumnLayouter::UnaryCombiner::singleStep;
+
+    template<class Value, class T>
+    typename std::enable_if<!std::is_function<Value>::value, bool>::type
+    singleStep(Value T::* ac){
+      this->result.columns[flatbuffer::memberOffset(this->target, ac)] =
+        uint32_t(this->result.widths.size());
+      this->result.widths.push_back(ColumnField<typename std::remove_const<Value>::type>::width);
+      return false;
+    }
+  };
+
+  // the columns of `Target`, computed once
+  template<class Target>
+  class ColumnLayout : public ColumnSlots {
+  public:
+    static const ColumnLayout& get(){
+      static const ColumnLayout layout;
+      return layout;
+    }
+
+    // the column of data member `m`
+    template<class Value, class T>
+    size_t column(Value T::* m) const{
+      const uint32_t c = columns[flatbuffer::memberOffset(probe, m)];
+      if(c == uint32_t(-1))
+        throw std::invalid_argument("member is not in the accessor list");
+      return c;
+    }
+
+  private:
+    ColumnLayout() : ColumnSlots{{}, std::vector<uint32_t>(sizeof(Target), uint32_t(-1))}{
+      ColumnLayouter<const Target>(probe, *this).callEnhance();
+    }
+
+    const Target probe{};
+  };
+
+  struct ColumnWriterState {
+    std::vector<std::vector<char> >& contents;
+    std::vector<std::vector<uint64_t> >& offsets;
+    size_t column;
+  };
+
+  struct ColumnWriteOp {
+    typedef ColumnWriterState& result_t;
+
+    template<class Value>
+    FORCE_INLINE static bool apply(result_t w, const Value& v){
+      std::vector<char>& d = w.contents[w.column];
+      ColumnField<Value>::append(d, v);
+      if(ColumnField<Value>::width == 0)
+        w.offsets[w.column].push_back(d.size());
+      ++w.column;
+      return false;
+    }
+  };
+
+  struct ColumnReaderState {
+    // the start of each column
+    const std::vector<const char*>& columns;
+    size_t rows;
+    size_t row;
+    size_t column;
+  };
+
+  struct ColumnReadOp {
+    typedef ColumnReaderState& result_t;
+
+    template<class Value>
+    FORCE_INLINE static bool apply(result_t r, Value& v){
+      ColumnView<Value>(r.columns[r.column++], r.rows).load(r.row, v);
+      return false;
+    }
+  };
+
+  struct ColumnCheckState {
+    const std::vector<const char*>& columns;
+    const std::vector<uint64_t>& lengths;
+    size_t rows;
+    size_t column;
+    bool valid;
+  };
+
+  struct ColumnCheckOp {
+    typedef ColumnCheckState& result_t;
+
+    template<class Value>
+    static bool apply(result_t c, const Value&){
+      c.valid = ColumnView<Value>(c.columns[c.column], c.rows).valid(size_t(c.lengths[c.column]));
+      ++c.column;
+      return !c.valid;
+    }
+  };
+
+  // Combiner aliases
+  template<class Target>
+  using ColumnWriter = UnaryCombiner<ColumnWriteOp, Target>;
+
+  template<class Target>
+  using ColumnLoader = UnaryCombiner<ColumnReadOp, Target>;
+
+  template<class Target>
+  using ColumnChecker = UnaryCombiner<ColumnCheckOp, Target>;
+
+  namespace columns {
+
+    struct Header {
+      char magic[8];
+      uint64_t rows;
+      uint64_t columns;
+    };
+
+    struct Entry {
+      uint64_t offset;
+      uint64_t length;
+      uint64_t width;
+    };
+
+    inline const char* magic(){ return "ENHCOL1"; }
+
+    inline size_t aligned(size_t n){
+      return (n + 7) & ~size_t(7);
+    }
+  }
+
+  // the columnar representation of `rows`
+  template<class Target>
+  std::vector<char> toColumns(const std::vector<Target>& rows){
+    const ColumnLayout<Target>& l = ColumnLayout<Target>::get();
+    const size_t k = l.widths.size();
+    std::vector<std::vector<char> > contents(k);
+    std::vector<std::vector<uint64_t> > offsets(k);
+    for(size_t c = 0; c < k; ++c)
+      if(l.widths[c])
+        contents[c].reserve(rows.size() * size_t(l.widths[c]));
+      else
+        offsets[c].assign(1, 0);
+    for(const Target& x : rows){
+      ColumnWriterState w = {contents, offsets, 0};
+      ColumnWriter<const Target>(x, w).callEnhance();
+    }
+
+    columns::Header h;
+    std::memcpy(h.magic, columns::magic(), sizeof(h.magic));
+    h.rows = rows.size();
+    h.columns = k;
+    std::vector<columns::Entry> directory(k);
+    size_t pos = sizeof(h) + k * sizeof(columns::Entry);
+    for(size_t c = 0; c < k; ++c){
+      directory[c].offset = pos;
+      directory[c].length = offsets[c].size() * 8 + contents[c].size();
+      directory[c].width = l.widths[c];
+      pos = columns::aligned(pos + size_t(directory[c].length));
+    }
+
+    std::vector<char> bytes(pos);
+    std::memcpy(bytes.data(), &h, sizeof(h));
+    if(k)
+      std::memcpy(&bytes[sizeof(h)], directory.data(), k * sizeof(columns::Entry));
+    for(size_t c = 0; c < k; ++c){
+      char* p = &bytes[size_t(directory[c].offset)];
+      if(!offsets[c].empty())
+        std::memcpy(p, offsets[c].data(), offsets[c].size() * 8);
+      if(!contents[c].empty())
+        std::memcpy(p + offsets[c].size() * 8, contents[c].data(), contents[c].size());
+    }
+    return bytes;
+  }
+
+  template<class Target>
+  void writeColumns(const std::string& path, const std::vector<Target>& rows){
+    const std::vector<char> bytes = toColumns(rows);
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), std::streamsize(bytes.size()));
+    if(!out)
+      throw std::runtime_error("writeColumns: cannot write " + path);
+  }
+
+  // reads the columns of `toColumns` in place. The buffer has to
+  // outlive the reader and all views obtained from it.
+  template<class Target>
+  class ColumnReader {
+  public:
+    // checks the header and directory, throws `std::runtime_error`
+    ColumnReader(const char* data, size_t n){
+      const ColumnLayout<Target>& l = ColumnLayout<Target>::get();
+      columns::Header h;
+      if(n < sizeof(h))
+        throw std::runtime_error("ColumnReader: no columns");
+      std::memcpy(&h, data, sizeof(h));
+      if(std::memcmp(h.magic, columns::magic(), sizeof(h.magic)) != 0 ||
+         h.columns != l.widths.size())
+        throw std::runtime_error("ColumnReader: columns of another type");
+      rows = size_t(h.rows);
+      const size_t k = l.widths.size();
+      if((n - sizeof(h)) / sizeof(columns::Entry) < k)
+        throw std::runtime_error("ColumnReader: truncated columns");
+      for(size_t c = 0; c < k; ++c){
+        columns::Entry e;
+        std::memcpy(&e, data + sizeof(h) + c * sizeof(e), sizeof(e));
+        if(e.width != l.widths[c])
+          throw std::runtime_error("ColumnReader: columns of another type");
+        if(e.offset > n || e.length > n - e.offset ||
+           (e.width && e.length / e.width < rows))
+          throw std::runtime_error("ColumnReader: truncated columns");
+        starts.push_back(data + e.offset);
+        lengths.push_back(e.length);
+      }
+    }
+
+    explicit ColumnReader(const std::vector<char>& bytes)
+      : ColumnReader(bytes.data(), bytes.size()){}
+
+    // the number of rows
+    size_t size() const{ return rows; }
+
+    // the column of data member `m`. Throws `std::runtime_error` if it
+    // is not valid, which takes one pass over the column, unless it has
+    // a fixed width.
+    template<class Value, class T>
+    ColumnView<typename std::remove_const<Value>::type> column(Value T::* m) const{
+      const size_t c = ColumnLayout<Target>::get().column(m);
+      ColumnView<typename std::remove_const<Value>::type> v(starts[c], rows);
+      if(!v.valid(size_t(lengths[c])))
+        throw std::runtime_error("ColumnReader: invalid column");
+      return v;
+    }
+
+    // the values of data member `m`
+    template<class Value, class T>
+    std::vector<typename std::remove_const<Value>::type> loadColumn(Value T::* m) const{
+      ColumnView<typename std::remove_const<Value>::type> c = column(m);
+      std::vector<typename std::remove_const<Value>::type> values(rows);
+      for(size_t i = 0; i < rows; ++i)
+        c.load(i, values[i]);
+      return values;
+    }
+
+    // the objects with only the given data members loaded, all others
+    // are default constructed
+    template<class... Members>
+    std::vector<Target> load(Members... ms) const{
+      std::vector<Target> out(rows);
+      int expand[] = {0, (loadInto(out, ms), 0)...};
+      (void)expand;
+      return out;
+    }
+
+    // the objects with all columns loaded
+    std::vector<Target> loadAll() const{
+      static const Target probe{};
+      ColumnCheckState check = {starts, lengths, rows, 0, true};
+      ColumnChecker<const Target>(probe, check).callEnhance();
+      if(!check.valid)
+        throw std::runtime_error("ColumnReader: invalid column");
+      std::vector<Target> out(rows);
+      for(size_t i = 0; i < rows; ++i){
+        ColumnReaderState r = {starts, rows, i, 0};
+        ColumnLoader<Target>(out[i], r).callEnhance();
+      }
+      return out;
+    }
+
+  private:
+    template<class Value, class T>
+    void loadInto(std::vector<Target>& out, Value T::* m) const{
+      ColumnView<typename std::remove_const<Value>::type> c = column(m);
+      for(size_t i = 0; i < rows; ++i)
+        c.load(i, access(m, out[i]));
+    }
+
+    size_t rows;
+    std::vector<const char*> starts;
+    std::vector<uint64_t> lengths;
+  };
+
+  // the columns of a file written by `writeColumns`, mapped into memory
+  template<class Target>
+  class ColumnFile : private MappedFile, public ColumnReader<Target> {
+  public:
+    explicit ColumnFile(const std::string& path)
+      : MappedFile(path), ColumnReader<Target>(data(), length()){}
+  };
+
+    //############ 4.6 string conversion / pretty printing  functionality ###############
+  struct InsertionOp {
+    typedef std::ostream& result_t;
+    
+    template<class Value>
+    static bool apply(result_t& r, Value&& a){
+      r << a;
+      return false;
+    }
+  };
+
+  template<char delim1, char sep1, char sep2, char delim2, bool Grouping, class Target>
+  struct Insertion : UnaryCombiner<InsertionOp,Target,
+                                   Insertion<delim1, sep1, sep2, delim2, Grouping, Target>> {
+
+    bool first;
+    
+    FORCE_INLINE Insertion(Target& target,
+                           std::ostream& result)
+      : Insertion::UnaryCombiner(target, result)
+      , first(true){
+      result << delim1;
+    };
+
+    void beforeStep(){
+      if(!first)
+        this->result << sep1 << sep2;
+      else
+        first = false;
+    }
+
+    using Insertion::UnaryCombiner::singleStep;
+    
+    //specialization for `Range` accessors
+			template<int begin, int end, class Accessor>
+      FORCE_INLINE bool singleStep(FromTo<begin, end, Accessor> ac){
+        return wrap(ac);
+    }
+
+    //specialization for `Range` accessors
+    template<class A,class B>
+    FORCE_INLINE bool singleStep(Range<A,B> ac) {
+      return wrap(ac);
+    }
+    
+    template<class Accessor> bool wrap(Accessor ac)
+    {
+      if(Grouping){
+        beforeStep();
+        Insertion<delim1, sep1, sep2, delim2, false, Target>
+          (this->target, this->result)(ac);
+        return false;
+      }
+      return Insertion::UnaryCombiner::singleStep(ac);
+    }
+
+    void finalize()
+    {
+      this->result << delim2;
+    }
+  };
+
+
+  // factory functions for template argument deduction:
+  template<char delim1, char sep1, char sep2, char delim2, bool Grouping = true, class Target>
+  Insertion<delim1, sep1, sep2, delim2, Grouping, const Target>
+  insertion(const Target& target, std::ostream& os){
+    return Insertion<delim1, sep1, sep2, delim2, Grouping, const Target>(target, os);
+  }
+
+  template<char delim1, char sep1, char sep2, char delim2, class Target, bool Grouping = true>
+	struct Insertable{
+		FORCE_INLINE friend std::ostream&
+    operator<<(std::ostream& os, const Target& x){
+			insertion<delim1,sep1,sep2,delim2, Grouping>(x, os).callEnhance();
+			return os;
+		}
+	};
+
+    //############ 4.7 order-preserving sort keys ###############
+  /*
+    `sortKey(x)` encodes the accessed values into a string of bytes,
+    such that comparing two keys with `memcmp` (or `std::string`'s
+    `operator<`) gives the same order as `less`:
+
+    - unsigned integers: big-endian
+    - signed integers: big-endian with flipped sign bit
+    - floating point values: big-endian with flipped sign bit (positive
+      values) or all bits flipped (negative values), -0.0 is encoded
+      as 0.0
+    - strings: every 0x00 byte escaped as 0x00 0xFF, terminated by
+      0x00 0x01
+    - `Range` accessors: every element preceded by 0x01, terminated by
+      0x00
+    - classes with an `enhance` member: their sort key
+
+    Values accessed through `descending(accessor)` are encoded with
+    all bytes flipped, which reverses their order.
+
+    `sortKey(x, prefixLength)` gives a key of exactly `prefixLength`
+    bytes (truncated or padded with 0x00), which orders weakly, i.e.
+    equal prefix keys need to be compared by other means.
+
+    Specialize `KeyEncoder` to support other types.
+   */
+
+  struct SortKeyOp;
+
+  template<class Target, class Operator = SortKeyOp> struct SortKey;
+
+  template<class Target>
+  SortKey<const Target> sortKey(const Target& x, size_t prefixLength = 0);
+
+  // appends `v` as `sizeof(Unsigned)` big-endian bytes
+  template<class Unsigned>
+  FORCE_INLINE void appendBigEndian(std::string& out, Unsigned v){
+    char bytes[sizeof(Unsigned)];
+    uint64_t w = v;
+    for(size_t i = sizeof(Unsigned); i-- > 0; w >>= 8)
+      bytes[i] = char(w & 0xff);
+    out.append(bytes, sizeof(Unsigned));
+  }
+
+  // enhanced classes are encoded using their own sort key
+  template<class Value, class Enable = void>
+  struct KeyEncoder {
+    static void encode(std::string& out, const Value& v){
+      out += sortKey(v);
+    }
+  };
+
+  template<class Value>
+  struct KeyEncoder<Value, typename std::enable_if<
+                             std::is_integral<Value>::value &&
+                             std::is_unsigned<Value>::value>::type> {
+    FORCE_INLINE static void encode(std::string& out, Value v){
+      appendBigEndian(out, v);
+    }
+  };
+
+  template<class Value>
+  struct KeyEncoder<Value, typename std::enable_if<
+                             std::is_integral<Value>::value &&
+                             std::is_signed<Value>::value>::type> {
+    typedef typename std::make_unsigned<Value>::type unsigned_t;
+
+    FORCE_INLINE static void encode(std::string& out, Value v){
+      appendBigEndian(out, unsigned_t(unsigned_t(v) ^
+                                      (unsigned_t(1) << (8 * sizeof(Value) - 1))));
+    }
+  };
+
+  template<class Value>
+  struct KeyEncoder<Value, typename std::enable_if<
+                             std::is_enum<Value>::value>::type> {
+    typedef typename std::underlying_type<Value>::type underlying_t;
+
+    FORCE_INLINE static void encode(std::string& out, Value v){
+      KeyEncoder<underlying_t>::encode(out, underlying_t(v));
+    }
+  };
+
+  template<class Value>
+  struct KeyEncoder<Value, typename std::enable_if<
+                             std::is_floating_point<Value>::value>::type> {
+    typedef typename std::conditional<sizeof(Value) == 4, uint32_t,
+                                      uint64_t>::type bits_t;
+    static_assert(sizeof(Value) == sizeof(bits_t),
+                  "only 32 and 64 bit floating point values are supported");
+
+    FORCE_INLINE static void encode(std::string& out, Value v){
+      bits_t bits = 0;
+      if(v != 0)
+        std::memcpy(&bits, &v, sizeof(v));
+      const bits_t sign = bits_t(1) << (8 * sizeof(Value) - 1);
+      appendBigEndian(out, bits_t(bits & sign ? ~bits : bits | sign));
+    }
+  };
+
+  template<>
+  struct KeyEncoder<std::string> {
+    static void encode(std::string& out, const std::string& v){
+      out.reserve(out.size() + v.size() + 2);
+      for(char c : v){
+        out += c;
+        if(c == '\0')
+          out += '\xff';
+      }
+      out += '\0';
+      out += '\x01';
+    }
+  };
+
+  struct SortKeyOp {
+    typedef std::string result_t;
+
+    template<class A>
+    static result_t init(A&){ return result_t(); }
+
+    static std::string& buffer(result_t& r){ return r; }
+
+    template<class Value>
+    static bool apply(result_t& r, const Value& v){
+      KeyEncoder<Value>::encode(r, v);
+      return false;
+    }
+  };
+
+  // encodes into an existing buffer, which is passed around as a
+  // pointer instead of copies of the key
+  struct AppendSortKeyOp {
+    typedef std::string* result_t;
+
+    static std::string& buffer(result_t r){ return *r; }
+
+    template<class Value>
+    static bool apply(result_t r, const Value& v){
+      KeyEncoder<Value>::encode(*r, v);
+      return false;
+    }
+  };
+
+  template<class Target, class Operator>
+  struct SortKey : UnaryCombiner<Operator, Target, SortKey<Target, Operator>> {
+
+    // 0 for complete keys
+    size_t prefixLength;
+
+    FORCE_INLINE SortKey(Target& target, size_t prefixLength = 0)
+      : SortKey::UnaryCombiner(target)
+      , prefixLength(prefixLength){
+    };
+
+    FORCE_INLINE SortKey(Target& target, typename Operator::result_t&& result)
+      : SortKey::UnaryCombiner(target, std::move(result))
+      , prefixLength(0){
+    };
+
+    // stop, as soon as the prefix is complete
+    template<class Accessor>
+    FORCE_INLINE bool singleStep(Accessor ac){
+      SortKey::UnaryCombiner::singleStep(ac);
+      return complete();
+    }
+
+    template<class A,class B>
+    FORCE_INLINE bool singleStep(Range<A,B> ac){
+      auto   b = access(ac.a,this->target);
+      auto&& e = access(ac.b,this->target);
+      for(; b<e; ++b){
+        out() += '\x01';
+        Operator::apply(this->result, *b);
+        if(complete())
+          return true;
+      }
+      out() += '\0';
+      return complete();
+    }
+
+    template<class Accessor>
+    FORCE_INLINE bool singleStep(Descending<Accessor> ac){
+      std::string& o = out();
+      size_t from = o.size();
+      bool stop = singleStep(ac.m);
+      for(size_t i = from; i < o.size(); ++i)
+        o[i] = char(~o[i]);
+      return stop;
+    }
+
+    void finalize(){
+      if(prefixLength)
+        out().resize(prefixLength, '\0');
+    }
+
+  private:
+    std::string& out(){
+      return Operator::buffer(this->result);
+    }
+
+    bool complete(){
+      return prefixLength && out().size() >= prefixLength;
+    }
+  };
+
+  // factory function for template argument deduction:
+  template<class Target>
+  SortKey<const Target> sortKey(const Target& x, size_t prefixLength){
+    return SortKey<const Target>(x, prefixLength);
+  }
+
+  // appends the sort key of `x` to `out`. This avoids an allocation
+  // per key when encoding many keys.
+  template<class Target>
+  void appendSortKey(std::string& out, const Target& x){
+    SortKey<const Target, AppendSortKeyOp>(x, &out).callEnhance();
+  }
+
+    //############ 4.8 radix sort ###############
+  /*
+    `enhance::sort(first, last)` sorts a range of enhanced objects by
+    their sort keys (see 4.7), i.e. in the order given by `compare`
+    (or `less`), but with the values of `descending` accessors
+    reversed. The sort is stable.
+
+    The keys are encoded once and sorted in chunks of 16 bytes, that
+    are kept next to the index of their object: an MSD radix sort on
+    the bytes of the first chunk (skipping bytes, that are equal in
+    all keys of a bucket), then the same on the next chunk of every
+    group of keys, that are still equal, and so on. Small buckets are
+    sorted by comparison. Buckets are kept on an explicit stack, so
+    long common prefixes do not recurse. Fewer than
+    `radix::arithmeticCutoff` objects of classes of numbers (without
+    `descending` accessors, which `compare` ignores) are sorted with
+    `std::stable_sort` and `compare`, which wins there.
+
+    Objects are only moved once at the very end, so the value type
+    needs to be move constructible and move assignable.
+  */
+  namespace radix {
+
+    // buckets smaller than this are sorted by comparison
+    const size_t cutoff = 64;
+
+    // the sort keys of a range, stored back to back
+    struct Keys {
+      std::string bytes;
+      std::vector<size_t> offsets;
+
+      template<class RandomIt>
+      Keys(RandomIt first, size_t n) : offsets(n + 1){
+        appendSortKey(bytes, first[0]);
+        // most keys have the same length
+        bytes.reserve(n * bytes.size() + bytes.size());
+        for(size_t i = 1; i < n; ++i){
+          offsets[i] = bytes.size();
+          appendSortKey(bytes, first[i]);
+        }
+        offsets[n] = bytes.size();
+      }
+
+      const unsigned char* key(size_t i) const{
+        return reinterpret_cast<const unsigned char*>(bytes.data()) + offsets[i];
+      }
+
+      size_t length(size_t i) const{
+        return offsets[i + 1] - offsets[i];
+      }
+    };
+
+    // number of digits of an `Item`
+    const size_t digits = 17;
+
+    /* a chunk of 16 key bytes (padded with zeros) and the number of
+       remaining key bytes (at most 17, i.e. more than this chunk),
+       which orders keys ending in this chunk before longer ones.
+       These are the 17 digits of an item.
+    */
+    template<class Index>
+    struct Item {
+      uint64_t hi, lo;
+      Index index;
+      uint8_t rest;
+
+      bool operator<(const Item& o) const{
+        if(hi != o.hi)
+          return hi < o.hi;
+        if(lo != o.lo)
+          return lo < o.lo;
+        if(rest != o.rest)
+          return rest < o.rest;
+        return index < o.index;
+      }
+
+      bool sameChunk(const Item& o) const{
+        return hi == o.hi && lo == o.lo && rest == o.rest;
+      }
+
+      unsigned digit(size_t p) const{
+        return p < 8 ? unsigned(hi >> (56 - 8 * p)) & 0xff
+          : p < 16 ? unsigned(lo >> (120 - 8 * p)) & 0xff
+          : rest;
+      }
+    };
+
+    // big-endian reads, so chunks compare like their bytes
+    FORCE_INLINE uint64_t read64BigEndian(const unsigned char* p){
+      uint64_t v;
+#if defined(ENHANCE_BIG_ENDIAN)
+      std::memcpy(&v, p, 8);
+#elif defined(__GNUC__)
+      std::memcpy(&v, p, 8);
+      v = __builtin_bswap64(v);
+#else
+      v = 0;
+      for(size_t i = 0; i < 8; ++i)
+        v = v << 8 | p[i];
+#endif
+      return v;
+    }
+
+    // loads the chunk of key bytes starting at `depth`
+    template<class Index>
+    FORCE_INLINE void load(const Keys& keys, Item<Index>& item, size_t depth){
+      const size_t length = keys.length(item.index);
+      const size_t rest = length > depth ? length - depth : 0;
+      const unsigned char* k = keys.key(item.index) + depth;
+      uint64_t hi = 0, lo = 0;
+      if(rest >= 16){
+        hi = read64BigEndian(k);
+        lo = read64BigEndian(k + 8);
+      }else{
+        for(size_t j = 0; j < 8; ++j)
+          hi = hi << 8 | (j < rest ? k[j] : 0);
+        for(size_t j = 8; j < 16; ++j)
+          lo = lo << 8 | (j < rest ? k[j] : 0);
+      }
+      item.hi = hi;
+      item.lo = lo;
+      item.rest = uint8_t(std::min<size_t>(rest, digits));
+    }
+
+    // the first digit from `p` on, that is not equal in all items
+    // (or `digits`)
+    template<class Index>
+    size_t firstVarying(const Item<Index>* items, size_t n, size_t p){
+      uint64_t hiAnd = ~uint64_t(0), hiOr = 0, loAnd = ~uint64_t(0), loOr = 0;
+      unsigned restAnd = 0xff, restOr = 0;
+      for(size_t i = 0; i < n; ++i){
+        hiAnd &= items[i].hi; hiOr |= items[i].hi;
+        loAnd &= items[i].lo; loOr |= items[i].lo;
+        restAnd &= items[i].rest; restOr |= items[i].rest;
+      }
+      const uint64_t hi = hiAnd ^ hiOr, lo = loAnd ^ loOr;
+      for(; p < 8; ++p)
+        if((hi >> (56 - 8 * p)) & 0xff)
+          return p;
+      for(; p < 16; ++p)
+        if((lo >> (120 - 8 * p)) & 0xff)
+          return p;
+      return p == 16 && restAnd != restOr ? 16 : digits;
+    }
+
+    // a bucket of items, whose keys are equal before chunk `depth`
+    // and before digit `p` of that chunk
+    template<class Index>
+    struct Bucket {
+      Item<Index>* items;
+      Item<Index>* tmp;
+      size_t n, depth, p;
+    };
+
+    /* sorts the items of bucket `b`. The chunks at `b.depth` need to
+       be loaded and the items ordered by index (i.e. stable so far).
+       `b.tmp` is scratch space of `b.n` items. Buckets, that still
+       need to be sorted, are pushed to `stack` instead of recursing,
+       as keys can share arbitrarily long prefixes.
+     */
+    template<class Index>
+    void sortBucket(const Keys& keys, Bucket<Index> b, std::vector<Bucket<Index>>& stack){
+      Item<Index>* items = b.items;
+      const size_t n = b.n;
+      if(n < cutoff){
+        std::sort(items, items + n);
+        // groups of keys, that are equal so far and continue
+        for(size_t i = 0; i < n;){
+          size_t j = i + 1;
+          while(j < n && items[j].sameChunk(items[i]))
+            ++j;
+          if(j - i > 1 && items[i].rest == digits){
+            for(size_t k = i; k < j; ++k)
+              load(keys, items[k], b.depth + 16);
+            stack.push_back(Bucket<Index>{items + i, b.tmp + i, j - i, b.depth + 16, 0});
+          }
+          i = j;
+        }
+        return;
+      }
+
+      size_t p = firstVarying(items, n, b.p);
+      while(p == digits){
+        // all keys are equal
+        if(items[0].rest < digits)
+          return;
+        b.depth += 16;
+        for(size_t i = 0; i < n; ++i)
+          load(keys, items[i], b.depth);
+        p = firstVarying(items, n, 0);
+      }
+
+      size_t count[256] = {0};
+      for(size_t i = 0; i < n; ++i)
+        ++count[items[i].digit(p)];
+      size_t offset[256], o = 0;
+      for(size_t d = 0; d < 256; ++d){
+        offset[d] = o;
+        o += count[d];
+      }
+      for(size_t i = 0; i < n; ++i)
+        b.tmp[offset[items[i].digit(p)]++] = items[i];
+      std::copy(b.tmp, b.tmp + n, items);
+      for(size_t d = 0, from = 0; d < 256; from += count[d++])
+        if(count[d] > 1)
+          stack.push_back(Bucket<Index>{items + from, b.tmp + from, count[d], b.depth, p + 1});
+    }
+
+    // MSD radix sort of `n` items with the first chunk loaded
+    template<class Index>
+    void sortMSD(const Keys& keys, Item<Index>* items, Item<Index>* tmp, size_t n){
+      std::vector<Bucket<Index>> stack(1, Bucket<Index>{items, tmp, n, 0, 0});
+      while(!stack.empty()){
+        const Bucket<Index> b = stack.back();
+        stack.pop_back();
+        sortBucket(keys, b, stack);
+      }
+    }
+
+    /* whether all accessed values of the objects of class `Target`
+       are numbers or enums (no strings, ranges or nested classes) and
+       none is `descending`, i.e. `compare` orders like the sort keys.
+       Found with the first object passed to `get` and reused (see
+       `FixedSerializedSize`).
+     */
+    template<class Target>
+    class AllArithmetic {
+      struct ProbeOp {
+        typedef bool& result_t;
+
+        template<class Value>
+        static bool apply(result_t r, const Value&){
+          r = r && (std::is_arithmetic<Value>::value || std::is_enum<Value>::value);
+          return !r;
+        }
+      };
+
+      struct Prober : UnaryCombiner<ProbeOp, const Target, Prober> {
+        Prober(const Target& target, bool& r) : Prober::UnaryCombiner(target, r){}
+
+        using Prober::UnaryCombiner::singleStep;
+
+        template<class A, class B>
+        bool singleStep(Range<A, B>){
+          this->result = false;
+          return true;
+        }
+
+        template<class Accessor>
+        bool singleStep(Descending<Accessor>){
+          this->result = false;
+          return true;
+        }
+      };
+
+      static bool probe(const Target& x){
+        bool r = true;
+        Prober(x, r).callEnhance();
+        return r;
+      }
+
+    public:
+      static bool get(const Target& x){
+        static const bool value = probe(x);
+        return value;
+      }
+    };
+
+    // below this number of objects of a class of numbers, a stable
+    // comparison sort is faster than encoding and sorting the keys
+    const size_t arithmeticCutoff = 1 << 15;
+
+    // moves `first[order[i]]` to `first[i]`
+    template<class RandomIt, class Index>
+    void permute(RandomIt first, const std::vector<Item<Index>>& order){
+      typedef typename std::iterator_traits<RandomIt>::value_type value_t;
+      std::vector<value_t> sorted;
+      sorted.reserve(order.size());
+      for(size_t i = 0; i < order.size(); ++i)
+        sorted.push_back(std::move(first[order[i].index]));
+      std::move(sorted.begin(), sorted.end(), first);
+    }
+
+    template<class RandomIt, class Index>
+    void sort(RandomIt first, size_t n){
+      const Keys keys(first, n);
+      std::vector<Item<Index>> items(n), tmp(n);
+      for(size_t i = 0; i < n; ++i){
+        items[i].index = Index(i);
+        load(keys, items[i], 0);
+      }
+      sortMSD(keys, items.data(), tmp.data(), n);
+      permute(first, items);
+    }
+  }
+
+  template<class RandomIt>
+  void sort(RandomIt first, RandomIt last){
+    typedef typename std::iterator_traits<RandomIt>::value_type value_t;
+    const size_t n = last - first;
+    if(n < 2)
+      return;
+    if(n < radix::arithmeticCutoff && radix::AllArithmetic<value_t>::get(first[0]))
+      std::stable_sort(first, last, [](const value_t& a, const value_t& b){
+          return compare(a, b) < 0;
+        });
+    else if(n <= 0xffffffffu)
+      radix::sort<RandomIt, uint32_t>(first, n);
+    else
+      radix::sort<RandomIt, uint64_t>(first, n);
+  }
+
+    //############ 4.9 Heterogeneous lookup ###############
+  /*
+    Transparent functors (with `is_transparent`), that compare and
+    hash an object of type `T` with a key, without constructing a
+    temporary `T`:
+
+      std::set<T, TransparentLess<T>> s;
+      s.find(std::make_tuple("abc", 42));     // C++14
+
+    The values of a key correspond to the values of T's accessor list
+    in order. A key can be
+
+    - a `std::tuple` or `std::pair`, e.g. `std::tie(name, id)`,
+    - a class with a templated `enhance` member, whose accessor list
+      gives the values, or
+    - any other single value.
+
+    Strings (`std::string`, `const char*` and `std::string_view`) are
+    interchangeable, they are compared and hashed by their bytes.
+
+    `TransparentLess` also accepts prefix keys, i.e. keys with fewer
+    values than T's accessor list, which are equivalent to all objects
+    starting with these values. `TransparentEqual` and
+    `TransparentHash` need complete keys.
+
+    The order is the one of `compare`. `Range` accessors are not
+    supported. T's accessor list is given by its templated `enhance`
+    member.
+
+    The hash values differ from `Hash<T>`, which hashes runs of
+    adjacent members as blocks (see 3.0).
+  */
+  namespace lookup {
+
+    // strings are compared and hashed by their bytes
+    template<class Value>
+    struct StringLike : std::false_type {};
+
+    template<>
+    struct StringLike<std::string> : std::true_type {
+      static const char* data(const std::string& s){ return s.data(); }
+      static size_t size(const std::string& s){ return s.size(); }
+    };
+
+    template<>
+    struct StringLike<const char*> : std::true_type {
+      static const char* data(const char* s){ return s; }
+      static size_t size(const char* s){ return std::strlen(s); }
+    };
+
+    template<>
+    struct StringLike<char*> : StringLike<const char*> {};
+
+#if __cplusplus >= 201703L
+    template<>
+    struct StringLike<std::string_view> : std::true_type {
+      static const char* data(std::string_view s){ return s.data(); }
+      static size_t size(std::string_view s){ return s.size(); }
+    };
+#endif
+
+    // three-way comparison of a value of T with a value of a key
+    template<class A, class B, class Enable = void>
+    struct CompareValues {
+      static int apply(const A& a, const B& b){
+        return (b < a) - (a < b);
+      }
+    };
+
+    template<class Value>
+    struct CompareValues<Value, Value, typename std::enable_if<
+                                         !StringLike<Value>::value>::type> {
+      FORCE_INLINE static int apply(const Value& a, const Value& b){
+        return threeWay(a, b);
+      }
+    };
+
+    template<class A, class B>
+    struct CompareValues<A, B, typename std::enable_if<
+                                 StringLike<A>::value &&
+                                 StringLike<B>::value>::type> {
+      FORCE_INLINE static int apply(const A& a, const B& b){
+        const size_t na = StringLike<A>::size(a), nb = StringLike<B>::size(b);
+        int c = std::char_traits<char>::compare(StringLike<A>::data(a),
+                                                StringLike<B>::data(b),
+                                                std::min(na, nb));
+        return c ? c : (nb < na) - (na < nb);
+      }
+    };
+
+    /* Numbers of different types are compared by their exact values,
+       e.g. `-1` is less than `1u` and `2` is less than `2.5`, so that
+       keys do not need the types of the accessed values.
+     */
+    template<class Value>
+    FORCE_INLINE bool isNegative(Value v, std::true_type){ return v < 0; }
+
+    template<class Value>
+    FORCE_INLINE bool isNegative(Value, std::false_type){ return false; }
+
+    template<class Value>
+    FORCE_INLINE bool isNegative(Value v){
+      return isNegative(v, std::is_signed<Value>());
+    }
+
+    template<class A, class B>
+    int compareNumbers(A a, B b, std::true_type, std::true_type){
+      const bool na = isNegative(a), nb = isNegative(b);
+      if(na != nb)
+        return na ? -1 : 1;
+      if(na)
+        return threeWay((long long)a, (long long)b);
+      return threeWay((unsigned long long)a, (unsigned long long)b);
+    }
+
+    template<class A, class B>
+    int compareNumbers(A a, B b, std::false_type, std::false_type){
+      typedef typename std::common_type<A, B>::type value_t;
+      return threeWay(value_t(a), value_t(b));
+    }
+
+    // an integer with a floating point value
+    template<class A, class B>
+    int compareNumbers(A a, B b, std::true_type, std::false_type){
+      if(b != b)
+        return 0;
+      const B limit = B(9223372036854775808.0);  // 2^63
+      if(b < -limit)
+        return 1;
+      if(b >= 2 * limit)
+        return -1;
+      const B whole = std::floor(b);
+      const int c = whole < 0
+        ? compareNumbers(a, (long long)whole, std::true_type(), std::true_type())
+        : compareNumbers(a, (unsigned long long)whole, std::true_type(), std::true_type());
+      return c ? c : (whole < b ? -1 : 0);
+    }
+
+    template<class A, class B>
+    int compareNumbers(A a, B b, std::false_type, std::true_type){
+      return -compareNumbers(b, a, std::true_type(), std::false_type());
+    }
+
+    template<class A, class B>
+    struct CompareValues<A, B, typename std::enable_if<
+                                 std::is_arithmetic<A>::value &&
+                                 std::is_arithmetic<B>::value &&
+                                 !std::is_same<A, B>::value>::type> {
+      FORCE_INLINE static int apply(A a, B b){
+        return compareNumbers(a, b, std::is_integral<A>(), std::is_integral<B>());
+      }
+    };
+
+    template<class A, class B>
+    FORCE_INLINE int compareValues(const A& a, const B& b){
+      return CompareValues<typename std::decay<const A>::type,
+                           typename std::decay<const B>::type>::apply(a, b);
+    }
+
+    // hash of a single value. Numbers of different types with the
+    // same value (see `compareNumbers`) have the same hash.
+    template<class Value, class Enable = void>
+    struct HashValue {
+      size_t operator()(const Value& v) const{
+        return std::hash<Value>()(v);
+      }
+    };
+
+    template<class Value>
+    struct HashValue<Value, typename std::enable_if<
+                              StringLike<Value>::value>::type> {
+      size_t operator()(const Value& v) const{
+        return hashBytes(StringLike<Value>::data(v), StringLike<Value>::size(v));
+      }
+    };
+
+    template<class Value>
+    struct HashValue<Value, typename std::enable_if<
+                              std::is_integral<Value>::value ||
+                              std::is_enum<Value>::value>::type> {
+      size_t operator()(const Value& v) const{
+        return std::hash<unsigned long long>()((unsigned long long)(v));
+      }
+    };
+
+    // whole numbers are hashed like integers
+    template<class Value>
+    struct HashValue<Value, typename std::enable_if<
+                              std::is_floating_point<Value>::value>::type> {
+      size_t operator()(const Value& v) const{
+        const Value limit = Value(9223372036854775808.0);  // 2^63
+        if(v >= -limit && v < 2 * limit && v == std::floor(v))
+          return v < 0 ? HashValue<long long>()((long long)v)
+            : HashValue<unsigned long long>()((unsigned long long)v);
+        return std::hash<double>()(double(v));
+      }
+    };
+
+    template<class Value>
+    FORCE_INLINE size_t hashValue(const Value& v){
+      typedef typename std::decay<const Value>::type value_t;
+      return HashValue<value_t>()(v);
+    }
+
+    // the values of a single value key
+    template<class Key, class Enable = void>
+    struct Values {
+      static const size_t size = 1;
+      const Key& key;
+
+      template<size_t I>
+      const Key& get() const{ return key; }
+    };
+
+    template<class Key>
+    struct IsTuple : std::false_type {};
+
+    template<class... Ks>
+    struct IsTuple<std::tuple<Ks...> > : std::true_type {};
+
+    template<class A, class B>
+    struct IsTuple<std::pair<A, B> > : std::true_type {};
+
+    // the values of a tuple key
+    template<class Key>
+    struct Values<Key, typename std::enable_if<IsTuple<Key>::value>::type> {
+      static const size_t size = std::tuple_size<Key>::value;
+      const Key& key;
+
+      template<size_t I>
+      const typename std::tuple_element<I, Key>::type& get() const{
+        return std::get<I>(key);
+      }
+    };
+
+    // the values of an enhanced key, given by its accessor list
+    template<class Key, class Accessors>
+    struct AccessorValues {
+      static const size_t size = std::tuple_size<Accessors>::value;
+      const Key& key;
+      const Accessors& accessors;
+
+      template<size_t I>
+      auto get() const
+        -> decltype(access(std::get<I>(std::declval<const Accessors&>()),
+                           std::declval<const Key&>())){
+        return access(std::get<I>(accessors), key);
+      }
+    };
+
+    // an `enhance` visitor, that calls `f` with the accessor list as
+    // a tuple
+    template<class F>
+    struct Collect {
+      F& f;
+
+      template<class... Accessors>
+      void operator()(Accessors... acs){
+        f(std::tuple<Accessors...>(acs...));
+      }
+    };
+
+    struct Ignore {
+      template<class T> void operator()(const T&){}
+    };
+
+    template<class Key, class Enable = void>
+    struct IsEnhanced : std::false_type {};
+
+    template<class Key>
+    struct IsEnhanced<Key, typename Void<decltype(
+        std::declval<const Key&>().enhance(std::declval<Collect<Ignore>&>()))>::type>
+      : std::true_type {};
+
+    template<class Key, class F>
+    struct WithAccessors {
+      const Key& key;
+      F& f;
+
+      template<class Accessors>
+      void operator()(const Accessors& acs){
+        f(AccessorValues<Key, Accessors>{key, acs});
+      }
+    };
+
+    // calls `f` with the values of `key`
+    template<class Key, class F>
+    FORCE_INLINE void withValues(const Key& key, F& f, std::false_type){
+      f(Values<Key>{key});
+    }
+
+    template<class Key, class F>
+    FORCE_INLINE void withValues(const Key& key, F& f, std::true_type){
+      WithAccessors<Key, F> w{key, f};
+      Collect<WithAccessors<Key, F> > c{w};
+      key.enhance(c);
+    }
+
+    template<class Key, class F>
+    FORCE_INLINE void withValues(const Key& key, F& f){
+      withValues(key, f, IsEnhanced<Key>());
+    }
+
+    template<size_t I, size_t End, bool = (I < End)>
+    struct Walk {
+      // three-way comparison of the first `End` values of `x` and `k`
+      template<class Accessors, class Target, class KeyValues>
+      FORCE_INLINE static int compare(const Accessors& acs, const Target& x,
+                                      const KeyValues& k){
+        int c = compareValues(access(std::get<I>(acs), x), k.template get<I>());
+        if(c)
+          return c;
+        return Walk<I + 1, End>::compare(acs, x, k);
+      }
+
+      template<class KeyValues>
+      FORCE_INLINE static void hash(size_t& h, const KeyValues& k){
+        DefaultHashCombiner()(h, hashValue(k.template get<I>()));
+        Walk<I + 1, End>::hash(h, k);
+      }
+    };
+
+    template<size_t I, size_t End>
+    struct Walk<I, End, false> {
+      template<class Accessors, class Target, class KeyValues>
+      FORCE_INLINE static int compare(const Accessors&, const Target&,
+                                      const KeyValues&){
+        return 0;
+      }
+
+      template<class KeyValues>
+      FORCE_INLINE static void hash(size_t&, const KeyValues&){}
+    };
+
+    template<class Target, class Key, bool complete>
+    struct Comparison {
+      const Target& x;
+      const Key& key;
+      int result;
+
+      template<class Accessors>
+      struct WithKey {
+        Comparison& c;
+        const Accessors& acs;
+
+        template<class KeyValues>
+        void operator()(const KeyValues& k){
+          static_assert(KeyValues::size <= std::tuple_size<Accessors>::value,
+                        "the key has more values than the accessor list");
+          static_assert(!complete ||
+                        KeyValues::size == std::tuple_size<Accessors>::value,
+                        "the key needs a value for every accessor");
+          c.result = Walk<0, KeyValues::size>::compare(acs, c.x, k);
+        }
+      };
+
+      template<class Accessors>
+      void operator()(const Accessors& acs){
+        WithKey<Accessors> w{*this, acs};
+        withValues(key, w);
+      }
+    };
+
+    // three-way comparison of `x` with (a prefix of) its values `key`
+    template<bool complete, class Target, class Key>
+    FORCE_INLINE int compareKey(const Target& x, const Key& key){
+      Comparison<Target, Key, complete> c{x, key, 0};
+      Collect<Comparison<Target, Key, complete> > collect{c};
+      x.enhance(collect);
+      return c.result;
+    }
+
+    struct Hashing {
+      size_t result;
+
+      template<class KeyValues>
+      void operator()(const KeyValues& k){
+        Walk<0, KeyValues::size>::hash(result, k);
+      }
+    };
+
+    template<class Key>
+    FORCE_INLINE size_t hashKey(const Key& key){
+      Hashing h{0};
+      withValues(key, h);
+      return h.result;
+    }
+  }
+
+  template<class Target>
+  struct TransparentLess {
+    typedef void is_transparent;
+
+    bool operator()(const Target& a, const Target& b) const{
+      return lookup::compareKey<true>(a, b) < 0;
+    }
+
+    template<class Key>
+    bool operator()(const Target& a, const Key& b) const{
+      return lookup::compareKey<false>(a, b) < 0;
+    }
+
+    template<class Key>
+    bool operator()(const Key& a, const Target& b) const{
+      return lookup::compareKey<false>(b, a) > 0;
+    }
+  };
+
+  template<class Target>
+  struct TransparentEqual {
+    typedef void is_transparent;
+
+    bool operator()(const Target& a, const Target& b) const{
+      return lookup::compareKey<true>(a, b) == 0;
+    }
+
+    template<class Key>
+    bool operator()(const Target& a, const Key& b) const{
+      return lookup::compareKey<true>(a, b) == 0;
+    }
+
+    template<class Key>
+    bool operator()(const Key& a, const Target& b) const{
+      return lookup::compareKey<true>(b, a) == 0;
+    }
+  };
+
+  template<class Target>
+  struct TransparentHash {
+    typedef void is_transparent;
+
+    size_t operator()(const Target& x) const{
+      return lookup::hashKey(x);
+    }
+
+    template<class Key>
+    size_t operator()(const Key& k) const{
+      return lookup::hashKey(k);
+    }
+  };
+
+    //############ 4.10 Flat hash tables ###############
+  /*
+    Open addressing hash tables in the style of Abseil's Swiss tables.
+
+    Every slot has a control byte, which is `empty`, `deleted` or the
+    lower 7 bits of the hash of its element (`H2`). The remaining bits
+    (`H1`) select the start of the probe sequence, which visits groups
+    of 16 consecutive slots. The control bytes of a whole group are
+    compared with the key's H2 at once (a single SSE2 comparison), so
+    `KeyEqual` is almost only called for the element, that is found.
+
+    The control bytes of the first group are cloned behind the last
+    slot, so a group can start at any slot. At most 7/8 of the slots
+    are used (including deleted slots), i.e. every probe sequence
+    ends at an empty slot.
+   */
+
+  namespace flat {
+
+    typedef signed char ctrl_t;
+
+    const ctrl_t empty   = -128;
+    const ctrl_t deleted = -2;
+
+    enum { groupWidth = 16 };
+
+    // index of the lowest set bit of a non-zero mask
+    FORCE_INLINE unsigned lowestBit(uint32_t m){
+#ifdef __GNUC__
+      return unsigned(__builtin_ctz(m));
+#else
+      unsigned i = 0;
+      for(; !(m & 1); m >>= 1) ++i;
+      return i;
+#endif
+    }
+
+    // the control bytes of 16 consecutive slots; the `match`
+    // functions return a bit mask with one bit per slot
+#if defined(ENHANCE_SIMD_X86) && defined(__SSE2__)
+    struct Group {
+      typedef char V __attribute__((vector_size(16)));
+      V ctrl;
+
+      FORCE_INLINE explicit Group(const ctrl_t* p){
+        std::memcpy(&ctrl, p, 16);
+      }
+
+      FORCE_INLINE uint32_t match(ctrl_t h2) const{
+        V m = ctrl == V() + char(h2);
+        return uint32_t(__builtin_ia32_pmovmskb128(m));
+      }
+
+      FORCE_INLINE uint32_t matchEmpty() const{
+        return match(empty);
+      }
+
+      // control bytes of empty and deleted slots are negative
+      FORCE_INLINE uint32_t matchEmptyOrDeleted() const{
+        return uint32_t(__builtin_ia32_pmovmskb128(ctrl));
+      }
+    };
+#else
+    struct Group {
+      ctrl_t ctrl[groupWidth];
+
+      FORCE_INLINE explicit Group(const ctrl_t* p){
+        std::memcpy(ctrl, p, groupWidth);
+      }
+
+      FORCE_INLINE uint32_t match(ctrl_t h2) const{
+        uint32_t m = 0;
+        for(int i = 0; i < groupWidth; ++i)
+          m |= uint32_t(ctrl[i] == h2) << i;
+        return m;
+      }
+
+      FORCE_INLINE uint32_t matchEmpty() const{
+        return match(empty);
+      }
+
+      FORCE_INLINE uint32_t matchEmptyOrDeleted() const{
+        uint32_t m = 0;
+        for(int i = 0; i < groupWidth; ++i)
+          m |= uint32_t(ctrl[i] < 0) << i;
+        return m;
+      }
+    };
+#endif
+
+    // spreads the bits of weak hashes (e.g. `std::hash<int>`) over H1
+    // and H2
+    FORCE_INLINE size_t mix(size_t hash){
+      return size_t(hashing::mum(uint64_t(hash), 0x9e3779b97f4a7c15ULL));
+    }
+
+    FORCE_INLINE size_t h1(size_t hash){ return hash >> 7; }
+    FORCE_INLINE ctrl_t h2(size_t hash){ return ctrl_t(hash & 0x7f); }
+
+    // the key of a set element
+    struct Identity {
+      template<class Value>
+      const Value& operator()(const Value& v) const{ return v; }
+    };
+
+    // the key of a map element
+    struct First {
+      template<class Value>
+      const typename Value::first_type& operator()(const Value& v) const{
+        return v.first;
+      }
+    };
+  }
+
+  // the table underlying `FlatHashSet` and `FlatHashMap`
+  template<class Value, class Key, class KeyOf, class Hasher, class KeyEqual>
+  class FlatHashTable {
+    // elements of sets must not be modified through iterators
+    static const bool constElements = std::is_same<KeyOf, flat::Identity>::value;
+
+  public:
+    typedef Key      key_type;
+    typedef Value    value_type;
+    typedef size_t   size_type;
+    typedef Hasher   hasher;
+    typedef KeyEqual key_equal;
+
+    template<bool Const>
+    class Iterator {
+      friend class FlatHashTable;
+
+      const flat::ctrl_t* ctrl;
+      const flat::ctrl_t* end;
+      Value* slot;
+
+      Iterator(const flat::ctrl_t* ctrl, const flat::ctrl_t* end, Value* slot)
+        : ctrl(ctrl), end(end), slot(slot){
+        skipFree();
+      }
+
+      void skipFree(){
+        for(; ctrl != end && *ctrl < 0; ++ctrl, ++slot);
+      }
+
+    public:
+      typedef std::forward_iterator_tag iterator_category;
+      typedef typename FlatHashTable::value_type value_type;
+      typedef std::ptrdiff_t difference_type;
+      typedef typename std::conditional<Const, const Value, Value>::type& reference;
+      typedef typename std::conditional<Const, const Value, Value>::type* pointer;
+
+      Iterator() : ctrl(nullptr), end(nullptr), slot(nullptr){}
+
+      // iterator to const_iterator
+      template<bool C, class = typename std::enable_if<Const && !C>::type>
+      Iterator(const Iterator<C>& i) : ctrl(i.ctrl), end(i.end), slot(i.slot){}
+
+      reference operator*() const{ return *slot; }
+      pointer operator->() const{ return slot; }
+
+      Iterator& operator++(){
+        ++ctrl;
+        ++slot;
+        skipFree();
+        return *this;
+      }
+
+      Iterator operator++(int){
+        Iterator i = *this;
+        ++*this;
+        return i;
+      }
+
+      bool operator==(const Iterator& i) const{ return ctrl == i.ctrl; }
+      bool operator!=(const Iterator& i) const{ return ctrl != i.ctrl; }
+
+      template<bool> friend class Iterator;
+    };
+
+    typedef Iterator<constElements> iterator;
+    typedef Iterator<true> const_iterator;
+
+    explicit FlatHashTable(const Hasher& hash = Hasher(),
+                           const KeyEqual& eq = KeyEqual())
+      : ctrl(nullptr), slots(nullptr), capacity(0), elements(0), growthLeft(0),
+        hashFn(hash), keyEq(eq){}
+
+    FlatHashTable(std::initializer_list<Value> values)
+      : FlatHashTable(){
+      for(const Value& v : values)
+        insert(v);
+    }
+
+    FlatHashTable(const FlatHashTable& x)
+      : FlatHashTable(x.hashFn, x.keyEq){
+      reserve(x.elements);
+      for(const Value& v : x)
+        insertUnique(v, hashOf(KeyOf()(v)));
+    }
+
+    FlatHashTable(FlatHashTable&& x)
+      : FlatHashTable(x.hashFn, x.keyEq){
+      swap(x);
+    }
+
+    FlatHashTable& operator=(FlatHashTable x){
+      swap(x);
+      return *this;
+    }
+
+    ~FlatHashTable(){
+      destroy();
+    }
+
+    void swap(FlatHashTable& x){
+      std::swap(ctrl, x.ctrl);
+      std::swap(slots, x.slots);
+      std::swap(capacity, x.capacity);
+      std::swap(elements, x.elements);
+      std::swap(growthLeft, x.growthLeft);
+      std::swap(hashFn, x.hashFn);
+      std::swap(keyEq, x.keyEq);
+    }
+
+    iterator begin(){ return iteratorAt(0); }
+    iterator end(){ return iteratorAt(capacity); }
+    const_iterator begin() const{ return iteratorAt(0); }
+    const_iterator end() const{ return iteratorAt(capacity); }
+
+    size_t size() const{ return elements; }
+    bool empty() const{ return elements == 0; }
+
+    void clear(){
+      destroy();
+      ctrl = nullptr;
+      slots = nullptr;
+      capacity = elements = growthLeft = 0;
+    }
+
+    // makes room for `n` elements without rehashing
+    void reserve(size_t n){
+      size_t c = flat::groupWidth;
+      while(maxLoad(c) < n)
+        c *= 2;
+      if(c > capacity)
+        rehash(c);
+    }
+
+    std::pair<iterator, bool> insert(const Value& v){
+      return emplaceValue(v);
+    }
+
+    std::pair<iterator, bool> insert(Value&& v){
+      return emplaceValue(std::move(v));
+    }
+
+    iterator find(const Key& k){
+      return iteratorAt(findIndex(k, hashOf(k)));
+    }
+
+    const_iterator find(const Key& k) const{
+      return iteratorAt(findIndex(k, hashOf(k)));
+    }
+
+    size_t count(const Key& k) const{
+      return findIndex(k, hashOf(k)) != capacity;
+    }
+
+    bool contains(const Key& k) const{
+      return count(k) != 0;
+    }
+
+    // looks up `n` keys, storing the results in `out`. The hashes of a
+    // batch of keys are computed first and their groups are prefetched
+    // before probing.
+    template<class OutputIt>
+    void find_many(const Key* keys, size_t n, OutputIt out) const{
+      const size_t batch = 8;
+      size_t hashes[batch];
+      for(size_t i = 0; i < n; i += batch){
+        const size_t m = std::min(batch, n - i);
+        for(size_t j = 0; j < m; ++j){
+          hashes[j] = hashOf(keys[i + j]);
+          if(capacity){
+            const size_t p = flat::h1(hashes[j]) & (capacity - 1);
+            ENHANCE_PREFETCH(ctrl + p);
+            ENHANCE_PREFETCH(slots + p);
+          }
+        }
+        for(size_t j = 0; j < m; ++j, ++out)
+          *out = iteratorAt(findIndex(keys[i + j], hashes[j]));
+      }
+    }
+
+    size_t erase(const Key& k){
+      size_t i = findIndex(k, hashOf(k));
+      if(i == capacity)
+        return 0;
+      slots[i].~Value();
+      setCtrl(i, flat::deleted);
+      --elements;
+      return 1;
+    }
+
+    hasher hash_function() const{ return hashFn; }
+    key_equal key_eq() const{ return keyEq; }
+
+  protected:
+    flat::ctrl_t* ctrl;
+    Value* slots;
+    size_t capacity, elements, growthLeft;
+    Hasher hashFn;
+    KeyEqual keyEq;
+
+    static size_t maxLoad(size_t c){
+      return c - c / 8;
+    }
+
+    size_t hashOf(const Key& k) const{
+      return flat::mix(hashFn(k));
+    }
+
+    iterator iteratorAt(size_t i){
+      return iterator(ctrl + i, ctrl + capacity, slots + i);
+    }
+
+    const_iterator iteratorAt(size_t i) const{
+      return const_iterator(ctrl + i, ctrl + capacity, slots + i);
+    }
+
+    // the index of the element with key `k`, or `capacity`
+    size_t findIndex(const Key& k, size_t h) const{
+      if(!capacity)
+        return 0;
+      const size_t mask = capacity - 1;
+      const flat::ctrl_t tag = flat::h2(h);
+      size_t pos = flat::h1(h) & mask, step = 0;
+      for(;;){
+        flat::Group g(ctrl + pos);
+        for(uint32_t m = g.match(tag); m; m &= m - 1){
+          size_t i = (pos + flat::lowestBit(m)) & mask;
+          if(keyEq(KeyOf()(slots[i]), k))
+            return i;
+        }
+        if(g.matchEmpty())
+          return capacity;
+        step += flat::groupWidth;
+        pos = (pos + step) & mask;
+      }
+    }
+
+    // the first empty or deleted slot of the probe sequence of `h`
+    size_t findFree(size_t h) const{
+      const size_t mask = capacity - 1;
+      size_t pos = flat::h1(h) & mask, step = 0;
+      for(;;){
+        uint32_t m = flat::Group(ctrl + pos).matchEmptyOrDeleted();
+        if(m)
+          return (pos + flat::lowestBit(m)) & mask;
+        step += flat::groupWidth;
+        pos = (pos + step) & mask;
+      }
+    }
+
+    void setCtrl(size_t i, flat::ctrl_t c){
+      ctrl[i] = c;
+      if(i < flat::groupWidth)
+        ctrl[capacity + i] = c;
+    }
+
+    template<class V>
+    std::pair<iterator, bool> emplaceValue(V&& v){
+      const Key& k = KeyOf()(v);
+      const size_t h = hashOf(k);
+      size_t i = findIndex(k, h);
+      if(i != capacity)
+        return std::make_pair(iteratorAt(i), false);
+      return std::make_pair(iteratorAt(insertUnique(std::forward<V>(v), h)), true);
+    }
+
+    // inserts an element, whose key is not in the table
+    template<class V>
+    size_t insertUnique(V&& v, size_t h){
+      size_t i = capacity ? findFree(h) : 0;
+      if(!capacity || (ctrl[i] == flat::empty && !growthLeft)){
+        // drop the deleted slots, if there are many of them
+        rehash(capacity && elements < maxLoad(capacity) / 2 ? capacity
+               : std::max<size_t>(2 * capacity, flat::groupWidth));
+        i = findFree(h);
+      }
+      new (slots + i) Value(std::forward<V>(v));
+      growthLeft -= ctrl[i] == flat::empty;
+      setCtrl(i, flat::h2(h));
+      ++elements;
+      return i;
+    }
+
+    void rehash(size_t c){
+      FlatHashTable t(hashFn, keyEq);
+      t.ctrl = new flat::ctrl_t[c + flat::groupWidth];
+      std::memset(t.ctrl, flat::empty, c + flat::groupWidth);
+      t.slots = std::allocator<Value>().allocate(c);
+      t.capacity = c;
+      t.growthLeft = maxLoad(c);
+      for(size_t i = 0; i < capacity; ++i)
+        if(ctrl[i] >= 0){
+          const size_t h = hashOf(KeyOf()(slots[i]));
+          const size_t j = t.findFree(h);
+          new (t.slots + j) Value(std::move(slots[i]));
+          t.setCtrl(j, flat::h2(h));
+          --t.growthLeft;
+          ++t.elements;
+        }
+      swap(t);
+    }
+
+    void destroy(){
+      if(!capacity)
+        return;
+      for(size_t i = 0; i < capacity; ++i)
+        if(ctrl[i] >= 0)
+          slots[i].~Value();
+      std::allocator<Value>().deallocate(slots, capacity);
+      delete[] ctrl;
+    }
+  };
+
+  // hash set of enhanced classes, hashed by `Hash` and compared by
+  // `Equal` by default
+  template<class T, class Hasher = typename Hash<T>::Functor,
+           class KeyEqual = typename Equal<T>::Functor>
+  class FlatHashSet : public FlatHashTable<T, T, flat::Identity, Hasher, KeyEqual> {
+  public:
+    using FlatHashSet::FlatHashTable::FlatHashTable;
+  };
+
+  // hash map with enhanced keys. Elements are `std::pair<K, V>`,
+  // whose keys must not be modified.
+  template<class K, class V, class Hasher = typename Hash<K>::Functor,
+           class KeyEqual = typename Equal<K>::Functor>
+  class FlatHashMap
+    : public FlatHashTable<std::pair<K, V>, K, flat::First, Hasher, KeyEqual> {
+  public:
+    typedef V mapped_type;
+
+    using FlatHashMap::FlatHashTable::FlatHashTable;
+
+    V& operator[](const K& k){
+      const size_t h = this->hashOf(k);
+      size_t i = this->findIndex(k, h);
+      if(i == this->capacity)
+        i = this->insertUnique(std::make_pair(k, V()), h);
+      return this->slots[i].second;
+    }
+
+    V& at(const K& k){
+      auto i = this->find(k);
+      if(i == this->end())
+        throw std::out_of_range("FlatHashMap::at");
+      return i->second;
+    }
+
+    const V& at(const K& k) const{
+      auto i = this->find(k);
+      if(i == this->end())
+        throw std::out_of_range("FlatHashMap::at");
+      return i->second;
+    }
+  };
+
+    //############ 4.11 Hash analysis ###############
+  /*
+    `analyzeHash<H>(sample)` measures, how well the functor
+    `H::Functor` of a hash combiner `H` (e.g. `Hash<T, Hasher,
+    HashCombiner>`) distributes a sample of distinct objects:
+
+    - the number of distinct hash values
+    - per table size: the bucket occupancy histogram (with bucket
+      `hash % buckets`) and the collision rate, compared to the
+      expected rate of a random hash
+    - per hash bit: the bias `|P(bit is set) - 1/2|`
+    - per hash bit: the avalanche bias `|P(bit flips) - 1/2|` when a
+      single bit of an arithmetic member is flipped, maximized over
+      all such input bits
+    - the throughput
+   */
+
+  struct HashReport {
+    struct Table {
+      size_t buckets;
+      // non-empty buckets
+      size_t used;
+      // fraction of the objects, that share a bucket with an earlier one
+      double collisionRate;
+      double randomCollisionRate;
+      // histogram[k]: number of buckets with k objects
+      std::vector<size_t> histogram;
+    };
+
+    size_t samples;
+    size_t distinct;
+    std::vector<Table> tables;
+    std::vector<double> bitBias;
+    std::vector<double> avalancheBias;
+    // number of flipped input bits, 0 if there are no arithmetic members
+    size_t inputBits;
+    double nanosecondsPerHash;
+
+    static size_t maxIndex(const std::vector<double>& v){
+      return size_t(std::max_element(v.begin(), v.end()) - v.begin());
+    }
+  };
+
+  inline std::ostream& operator<<(std::ostream& os, const HashReport& r){
+    os << std::fixed << std::setprecision(4)
+       << "samples: " << r.samples << ", distinct hashes: " << r.distinct << "\n";
+    for(const HashReport::Table& t : r.tables){
+      os << "buckets: " << t.buckets << ", used: " << t.used
+         << ", collision rate: " << t.collisionRate
+         << " (random: " << t.randomCollisionRate << ")\n  occupancy:";
+      for(size_t k = 0; k < t.histogram.size(); ++k)
+        os << " " << k << ":" << t.histogram[k];
+      os << "\n";
+    }
+    size_t b = HashReport::maxIndex(r.bitBias);
+    os << "max bit bias: " << r.bitBias[b] << " (bit " << b << ")\n";
+    if(r.inputBits){
+      size_t a = HashReport::maxIndex(r.avalancheBias);
+      os << "max avalanche bias: " << r.avalancheBias[a] << " (bit " << a
+         << ", " << r.inputBits << " input bits)\n";
+    }
+    return os << std::setprecision(2) << "throughput: "
+              << r.nanosecondsPerHash << " ns/hash\n";
+  }
+
+  namespace analysis {
+
+    // flips bit `bit` of the `field`th arithmetic member, or collects
+    // the widths of all arithmetic members, if `widths` is given
+    struct FlipState {
+      size_t field, bit, index;
+      std::vector<size_t>* widths;
+    };
+
+    struct FlipBitOp {
+      typedef FlipState* result_t;
+
+      template<class Value>
+      static typename std::enable_if<
+        std::is_lvalue_reference<Value>::value &&
+        std::is_arithmetic<typename std::decay<Value>::type>::value &&
+        !std::is_same<typename std::decay<Value>::type, bool>::value, bool>::type
+      apply(result_t s, Value&& v){
+        if(s->widths)
+          s->widths->push_back(8 * sizeof(v));
+        else if(s->index == s->field){
+          reinterpret_cast<unsigned char*>(&v)[s->bit / 8] ^= (unsigned char)(1u << (s->bit % 8));
+          return true;
+        }
+        ++s->index;
+        return false;
+      }
+
+      template<class Value>
+      static typename std::enable_if<
+        !(std::is_lvalue_reference<Value>::value &&
+          std::is_arithmetic<typename std::decay<Value>::type>::value &&
+          !std::is_same<typename std::decay<Value>::type, bool>::value), bool>::type
+      apply(result_t, Value&&){
+        return false;
+      }
+    };
+
+    template<class Target>
+    void flip(Target& x, FlipState& s){
+      UnaryCombiner<FlipBitOp, Target>(x, &s).callEnhance();
+    }
+  }
+
+  // `tableSizes` defaults to the smallest power of two with at least
+  // as many buckets as objects, a size of 0 throws
+  // `std::invalid_argument`. The avalanche is measured on the first
+  // `avalancheSamples` objects.
+  template<class H, class Target>
+  HashReport analyzeHash(const std::vector<Target>& sample,
+                         std::vector<size_t> tableSizes = std::vector<size_t>(),
+                         size_t avalancheSamples = 1000){
+    for(size_t m : tableSizes)
+      if(!m)
+        throw std::invalid_argument("table size 0");
+    typename H::Functor f;
+    const size_t n = sample.size(), bits = 8 * sizeof(size_t);
+    HashReport r;
+    r.samples = n;
+
+    std::vector<size_t> hashes(n);
+    for(size_t i = 0; i < n; ++i)
+      hashes[i] = f(sample[i]);
+
+    std::vector<size_t> sorted(hashes);
+    std::sort(sorted.begin(), sorted.end());
+    r.distinct = size_t(std::unique(sorted.begin(), sorted.end()) - sorted.begin());
+
+    if(tableSizes.empty()){
+      size_t m = 1;
+      while(m < n)
+        m *= 2;
+      tableSizes.push_back(m);
+    }
+    for(size_t m : tableSizes){
+      HashReport::Table t;
+      t.buckets = m;
+      std::vector<size_t> load(m);
+      for(size_t h : hashes)
+        ++load[h % m];
+      for(size_t l : load){
+        if(l >= t.histogram.size())
+          t.histogram.resize(l + 1);
+        ++t.histogram[l];
+      }
+      t.used = m - t.histogram[0];
+      t.collisionRate = n ? double(n - t.used) / n : 0;
+      const double used = m * -std::expm1(n * std::log1p(-1.0 / m));
+      t.randomCollisionRate = n ? (n - used) / n : 0;
+      r.tables.push_back(t);
+    }
+
+    r.bitBias.assign(bits, 0);
+    for(size_t b = 0; b < bits; ++b){
+      size_t set = 0;
+      for(size_t h : hashes)
+        set += (h >> b) & 1;
+      r.bitBias[b] = n ? std::fabs(double(set) / n - 0.5) : 0;
+    }
+
+    r.avalancheBias.assign(bits, 0);
+    std::vector<size_t> widths;
+    if(n){
+      analysis::FlipState s = {0, 0, 0, &widths};
+      Target x(sample[0]);
+      analysis::flip(x, s);
+    }
+    r.inputBits = 0;
+    const size_t m = std::min(n, avalancheSamples);
+    std::vector<size_t> flips(bits);
+    for(size_t field = 0; field < widths.size(); ++field)
+      for(size_t bit = 0; bit < widths[field]; ++bit, ++r.inputBits){
+        std::fill(flips.begin(), flips.end(), 0);
+        for(size_t i = 0; i < m; ++i){
+          Target x(sample[i]);
+          analysis::FlipState s = {field, bit, 0, nullptr};
+          analysis::flip(x, s);
+          const size_t d = hashes[i] ^ f(x);
+          for(size_t b = 0; b < bits; ++b)
+            flips[b] += (d >> b) & 1;
+        }
+        for(size_t b = 0; b < bits; ++b)
+          r.avalancheBias[b] = std::max(r.avalancheBias[b],
+                                        std::fabs(double(flips[b]) / m - 0.5));
+      }
+
+    // hash the sample repeatedly for at least 20ms
+    typedef std::chrono::steady_clock clock;
+    volatile size_t sink = 0;
+    size_t rounds = 0;
+    const clock::time_point start = clock::now();
+    std::chrono::duration<double, std::nano> elapsed;
+    do{
+      size_t s = 0;
+      for(const Target& x : sample)
+        s += f(x);
+      sink = s;
+      ++rounds;
+      elapsed = clock::now() - start;
+    }while(n && elapsed.count() < 2e7);
+    (void)sink;
+    r.nanosecondsPerHash = n ? elapsed.count() / (double(rounds) * n) : 0;
+    return r;
+  }
 
 }
 
@@ -0,0 +1,1421 @@
+/*
+ *  Enhance v0.1 - Benchmarks
+ *
+ *  Rough timings of the combiners against the straightforward (or
+ *  previous) implementations. Build and run all benchmarks with
+ *  `make bench` or a single one with `./benchmark <name>`.
+ *
+ *  ----------------------------------------------------------
+ *  Copyright (c) 2016 Johannes Gerer.
+ *
+ *  Distributed under the MIT License. (See accompanying file
+ *  LICENSE.txt)
+ * 
+ */
+#include "../enhance.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+#include <boost/archive/text_iarchive.hpp>
+#include <boost/archive/text_oarchive.hpp>
+#include <boost/serialization/string.hpp>
+#include <boost/serialization/vector.hpp>
+
+using namespace enhance;
+using std::string;
+using std::vector;
+
+//#################### benchmark registry ############################
+
+typedef void (*benchmark_t)();
+
+std::vector<std::pair<string, benchmark_t>>& benchmarks(){
+  static std::vector<std::pair<string, benchmark_t>> all;
+  return all;
+}
+
+struct Register {
+  Register(const char* name, benchmark_t f){
+    benchmarks().push_back(std::make_pair(string(name), f));
+  }
+};
+
+// runs `f` `repeats` times and returns the best time in milliseconds
+template<class F>
+double timeIt(F f, int repeats = 5){
+  double best = 1e300;
+  for(int i = 0; i < repeats; ++i){
+    auto start = std::chrono::steady_clock::now();
+    f();
+    std::chrono::duration<double, std::milli> d =
+      std::chrono::steady_clock::now() - start;
+    best = std::min(best, d.count());
+  }
+  return best;
+}
+
+void report(const string& name, double ms, double baselineMs){
+  cout << "  " << std::left << std::setw(40) << name
+       << std::right << std::setw(10) << std::fixed << std::setprecision(2)
+       << ms << " ms  (" << std::setprecision(2) << baselineMs / ms
+       << "x)" << endl;
+}
+
+// defeats dead code elimination
+volatile size_t sink;
+
+// largest problem size (as power of 10) of scaling benchmarks, can be
+// given as second argument: `./benchmark sort 8`
+int maxExponent = 6;
+
+//#################### 1 three-way lexicographic comparison ############################
+
+// the previous implementation of `LexicographicalComparisonOp`,
+// which runs `==` and then `Operator` on every component
+template<template<class> class Operator>
+struct EqualThenOp {
+  template<class Value>
+  static bool apply(bool& r, Value&& a, Value&& b){
+    Operator<Value> op;
+    if(a == b) return false;
+    r = op(std::forward<Value>(a),std::forward<Value>(b));
+    return true;
+  }
+};
+
+struct Record {
+  string key1, key2;
+  long id;
+
+  template<class C> void enhance(C& c) const{
+    c(&Record::key1, &Record::key2, &Record::id);
+  }
+};
+
+vector<Record> makeRecords(size_t n){
+  std::mt19937_64 rng(42);
+  const string prefix(24, 'k');
+  vector<Record> v(n);
+  for(size_t i = 0; i < n; ++i){
+    // long common prefixes and equal lengths make every string
+    // comparison expensive
+    v[i].key1 = prefix + std::to_string(10 + rng() % 8);
+    v[i].key2 = prefix + std::to_string(1000 + rng() % 9000);
+    v[i].id = long(i);
+  }
+  return v;
+}
+
+void lexicographicComparison(){
+  cout << "Sorting records with string keys:" << endl;
+  const vector<Record> records = makeRecords(1000000);
+
+  typedef BinaryCombiner<ComparisonOp<EqualThenOp<std::less>>,
+                         const Record> OldLess;
+
+  vector<Record> v;
+  double old = timeIt([&]{
+      v = records;
+      std::sort(v.begin(), v.end(), OldLess::Functor());
+    }, 3);
+  report("== then < (previous)", old, old);
+
+  double lex = timeIt([&]{
+      v = records;
+      std::sort(v.begin(), v.end(), Less<Record>::Functor());
+    }, 3);
+  report("Less<T>::Functor (three-way)", lex, old);
+
+  double cmp = timeIt([&]{
+      v = records;
+      std::sort(v.begin(), v.end(), [](const Record& a, const Record& b){
+          return compare(a, b) < 0;
+        });
+    }, 3);
+  report("compare(a, b) < 0", cmp, old);
+}
+Register r1("compare", lexicographicComparison);
+
+//#################### 2 runs of adjacent members ############################
+
+struct Box {
+  int x0, y0, x1, y1;
+  long id;
+
+  template<class C> void enhance(C& c) const{
+    c(&Box::x0, &Box::y0, &Box::x1, &Box::y1, &Box::id);
+  }
+};
+
+// member by member versions of `Equal`, `Copy` and `Hash`
+struct FieldwiseEqualOp {
+  typedef bool result_t;
+  template<class A, class B>
+  static bool init(A&, B&){ return true; }
+  template<class Value>
+  static bool apply(bool& r, const Value& a, const Value& b){
+    if(a == b) return false;
+    r = false;
+    return true;
+  }
+};
+
+struct FieldwiseCopyOp {
+  typedef Box& result_t;
+  static result_t init(Box& target, const Box&){ return target; }
+  template<class Value>
+  static bool apply(result_t&, Value& a, const Value& b){
+    a = b;
+    return false;
+  }
+};
+
+struct FieldwiseHashOp {
+  typedef size_t result_t;
+  static result_t init(const Box&){ return 0; }
+  template<class Value>
+  static bool apply(result_t& r, const Value& v){
+    DefaultHashCombiner()(r, std::hash<Value>()(v));
+    return false;
+  }
+};
+
+void adjacentMembers(){
+  cout << "Equal, Copy and Hash of {int, int, int, int, long}:" << endl;
+  const size_t n = 1 << 20;
+  std::mt19937 rng(1);
+  vector<Box> a(n), b;
+  for(auto& x : a){
+    x.x0 = rng() % 4; x.y0 = rng() % 4; x.x1 = rng() % 4; x.y1 = rng() % 4;
+    x.id = rng() % 4;
+  }
+  b = a;
+  std::shuffle(b.begin(), b.end(), rng);
+
+  double old = timeIt([&]{
+      size_t s = 0;
+      for(size_t i = 0; i < n; ++i)
+        s += BinaryCombiner<FieldwiseEqualOp, const Box>(a[i], b[i]).callEnhance();
+      sink = s;
+    });
+  report("fieldwise ==", old, old);
+  report("Equal<T> (memcmp)", timeIt([&]{
+      size_t s = 0;
+      for(size_t i = 0; i < n; ++i)
+        s += Equal<Box>(a[i], b[i]).callEnhance();
+      sink = s;
+      }), old);
+
+  vector<Box> c(n);
+  old = timeIt([&]{
+      for(size_t i = 0; i < n; ++i)
+        BinaryCombiner<FieldwiseCopyOp, Box, const Box>(c[i], a[i]).callEnhance();
+      sink = c[n / 2].id;
+    });
+  report("fieldwise copy", old, old);
+  report("Copy<T> (memcpy)", timeIt([&]{
+      for(size_t i = 0; i < n; ++i)
+        Copy<Box>(c[i], a[i]).callEnhance();
+      sink = c[n / 2].id;
+      }), old);
+
+  old = timeIt([&]{
+      size_t s = 0;
+      for(size_t i = 0; i < n; ++i)
+        s += UnaryCombiner<FieldwiseHashOp, const Box>(a[i]).callEnhance();
+      sink = s;
+    });
+  report("fieldwise std::hash", old, old);
+  report("Hash<T> (byte hash)", timeIt([&]{
+      size_t s = 0;
+      for(size_t i = 0; i < n; ++i)
+        s += Hash<Box>(a[i]).callEnhance();
+      sink = s;
+      }), old);
+}
+Register r2("adjacent", adjacentMembers);
+
+//#################### 3 vectorized ranges ############################
+
+struct Signal {
+  vector<double> data;
+
+  template<class C> void enhance(C& c) const{
+    c(container(&Signal::data));
+  }
+};
+
+// applies `Operator` element by element, like the combiners without
+// `Operator::applyRange`
+template<class Operator>
+struct ElementwiseOp {
+  typedef typename Operator::result_t result_t;
+  template<class... A>
+  static result_t init(A&... a){ return Operator::init(a...); }
+  template<class... A>
+  static bool apply(A&&... a){ return Operator::apply(std::forward<A>(a)...); }
+};
+
+template<class Operator>
+struct ElementwiseScalarOp {
+  typedef typename Operator::result_t result_t;
+  template<class... A>
+  static bool apply(A&&... a){ return Operator::apply(std::forward<A>(a)...); }
+};
+
+void vectorizedRanges(){
+  cout << "Range kernels on vector<double> of 4096 elements:" << endl;
+  const size_t n = 4096, repeats = 2000;
+  Signal a, b;
+  for(size_t i = 0; i < n; ++i){
+    a.data.push_back(i * 0.25);
+    b.data.push_back(1.0 / (i + 1));
+  }
+  Signal c(a);
+
+  typedef ComparisonOp<PointwiseComparisonOp<std::equal_to>> EqOp;
+  double old = timeIt([&]{
+      size_t s = 0;
+      for(size_t r = 0; r < repeats; ++r)
+        s += BinaryCombiner<ElementwiseOp<EqOp>, const Signal>(a, c).callEnhance();
+      sink = s;
+    });
+  report("elementwise ==", old, old);
+  report("Equal<T>", timeIt([&]{
+      size_t s = 0;
+      for(size_t r = 0; r < repeats; ++r)
+        s += Equal<Signal>(a, c).callEnhance();
+      sink = s;
+      }), old);
+
+  typedef ArithmeticComponentwiseOp<AdditionOp> AddOp;
+  old = timeIt([&]{
+      for(size_t r = 0; r < repeats; ++r)
+        BinaryCombiner<ElementwiseOp<AddOp>, Signal, const Signal>(c, b).callEnhance();
+      sink = size_t(c.data[7]);
+    });
+  report("elementwise +=", old, old);
+  report("Addition<T>", timeIt([&]{
+      for(size_t r = 0; r < repeats; ++r)
+        Addition<Signal>(c, b).callEnhance();
+      sink = size_t(c.data[7]);
+      }), old);
+
+  old = timeIt([&]{
+      double s = 0;
+      for(size_t r = 0; r < repeats; ++r)
+        s += BinaryCombiner<ElementwiseOp<ScalarProductOp<double>>, Signal>(a, b).callEnhance();
+      sink = size_t(s);
+    });
+  report("elementwise scalar product", old, old);
+  report("ScalarProduct<double, T>", timeIt([&]{
+      double s = 0;
+      for(size_t r = 0; r < repeats; ++r)
+        s += ScalarProduct<double, Signal>(a, b).callEnhance();
+      sink = size_t(s);
+      }), old);
+
+  old = timeIt([&]{
+      for(size_t r = 0; r < repeats; ++r)
+        UnaryCombiner<ElementwiseScalarOp<ScalarDivideOp<double>>, Signal>(c, 1.0001).callEnhance();
+      sink = size_t(c.data[7]);
+    });
+  report("elementwise /= scalar", old, old);
+  report("ScalarDivide<double, T>", timeIt([&]{
+      for(size_t r = 0; r < repeats; ++r)
+        ScalarDivide<double, Signal>(c, 1.0001).callEnhance();
+      sink = size_t(c.data[7]);
+      }), old);
+}
+Register r3("simd", vectorizedRanges);
+
+//#################### 5 radix sort ############################
+
+struct Quote {
+  int64_t time;
+  double price;
+  int32_t venue;
+
+  template<class C> void enhance(C& c) const{
+    c(&Quote::time, &Quote::price, &Quote::venue);
+  }
+};
+
+template<class T, class Make>
+void sortScaling(const char* name, Make make){
+  cout << "  " << name << ":" << endl;
+  for(int e = 3; e <= maxExponent; ++e){
+    size_t n = 1;
+    for(int i = 0; i < e; ++i)
+      n *= 10;
+    const vector<T> input = make(n);
+    vector<T> v;
+    int repeats = e < 6 ? 5 : 1;
+    double old = timeIt([&]{
+        v = input;
+        std::sort(v.begin(), v.end(), typename Less<T>::Functor());
+      }, repeats);
+    double radix = timeIt([&]{
+        v = input;
+        enhance::sort(v.begin(), v.end());
+      }, repeats);
+    cout << "    n = 1e" << e << ": ";
+    report("enhance::sort vs std::sort", radix, old);
+  }
+}
+
+void radixSort(){
+  cout << "enhance::sort against std::sort with Less<T>::Functor" << endl;
+  // keys are unique, as `Less` is not a strict weak ordering for
+  // equal objects
+  sortScaling<Quote>("{int64, double, int32}", [](size_t n){
+      std::mt19937_64 rng(3);
+      vector<Quote> v(n);
+      for(size_t i = 0; i < n; ++i){
+        v[i].time = int64_t(rng() % 1000000);
+        v[i].price = (rng() % 100000) / 100.0 - 500;
+        v[i].venue = int32_t(i);
+      }
+      return v;
+    });
+  sortScaling<Record>("{string, string, long}", [](size_t n){
+      return makeRecords(n);
+    });
+}
+Register r5("sort", radixSort);
+
+//#################### 6 heterogeneous lookup ############################
+
+void heterogeneousLookup(){
+  cout << "Binary search of 10^5 records by (const char*, const char*, long):"
+       << endl;
+  vector<Record> v = makeRecords(100000);
+  std::sort(v.begin(), v.end(), TransparentLess<Record>());
+
+  // probes arrive as plain character buffers
+  std::mt19937 rng(5);
+  vector<std::array<char, 32> > k1(v.size()), k2(v.size());
+  vector<long> ids(v.size());
+  for(size_t i = 0; i < v.size(); ++i){
+    const Record& r = v[rng() % v.size()];
+    std::strcpy(k1[i].data(), r.key1.c_str());
+    std::strcpy(k2[i].data(), r.key2.c_str());
+    ids[i] = r.id;
+  }
+
+  double old = timeIt([&]{
+      size_t s = 0;
+      for(size_t i = 0; i < v.size(); ++i){
+        Record probe{k1[i].data(), k2[i].data(), ids[i]};
+        s += std::lower_bound(v.begin(), v.end(), probe,
+                              TransparentLess<Record>()) - v.begin();
+      }
+      sink = s;
+    });
+  report("temporary Record", old, old);
+
+  report("key tuple", timeIt([&]{
+      size_t s = 0;
+      for(size_t i = 0; i < v.size(); ++i)
+        s += std::lower_bound(v.begin(), v.end(),
+                              std::make_tuple(k1[i].data(), k2[i].data(), ids[i]),
+                              TransparentLess<Record>()) - v.begin();
+      sink = s;
+    }), old);
+}
+Register r6("lookup", heterogeneousLookup);
+
+//#################### 7 branchless point-wise comparison ############################
+
+struct Point3 {
+  double x, y, z;
+
+  template<class C> void enhance(C& c) const{
+    c(&Point3::x, &Point3::y, &Point3::z);
+  }
+};
+
+// the short-circuiting `PointwiseComparisonOp`, without `applyBranchless`
+template<template<class> class Operator>
+struct ShortCircuitOp {
+  template<class Value>
+  static bool apply(bool& r, Value&& a, Value&& b){
+    if(Operator<typename std::decay<Value>::type>()(a, b))
+      return false;
+    r = false;
+    return true;
+  }
+};
+
+template<template<class> class Operator, class T>
+void pointwise(const string& name, const vector<T>& a, const vector<T>& b){
+  typedef BinaryCombiner<ComparisonOp<ShortCircuitOp<Operator> >, const T> Old;
+  typedef ComparisonPW<Operator, T> New;
+  double old = timeIt([&]{
+      size_t s = 0;
+      for(size_t i = 0; i < a.size(); ++i)
+        s += Old(a[i], b[i]).callEnhance();
+      sink = s;
+    });
+  report(name + " short-circuit", old, old);
+  report(name + " ComparisonPW", timeIt([&]{
+      size_t s = 0;
+      for(size_t i = 0; i < a.size(); ++i)
+        s += New(a[i], b[i]).callEnhance();
+      sink = s;
+    }), old);
+}
+
+void branchless(){
+  cout << "Point-wise comparisons of random {double, double, double}"
+       << " and {int, int, int, int, long}:" << endl;
+  const size_t n = 1 << 20;
+  std::mt19937 rng(9);
+  // every component decides the result with probability 1/2
+  vector<Point3> p(n), q(n);
+  for(size_t i = 0; i < n; ++i){
+    p[i] = Point3{double(rng() % 2), double(rng() % 2), double(rng() % 2)};
+    q[i] = Point3{double(rng() % 2), double(rng() % 2), double(rng() % 2)};
+  }
+  vector<Box> a(n), b(n);
+  for(size_t i = 0; i < n; ++i){
+    a[i] = Box{int(rng() % 2), int(rng() % 2), int(rng() % 2), int(rng() % 2), long(rng() % 2)};
+    b[i] = Box{int(rng() % 2), int(rng() % 2), int(rng() % 2), int(rng() % 2), long(rng() % 2)};
+  }
+  pointwise<std::equal_to>("Point3 ==", p, q);
+  pointwise<std::less_equal>("Point3 <=", p, q);
+  pointwise<std::equal_to>("Box ==", a, b);
+  pointwise<std::less_equal>("Box <=", a, b);
+}
+Register r7("branchless", branchless);
+
+//#################### 8 streaming hash ############################
+
+struct Series {
+  long id;
+  vector<int> values;
+
+  template<class C> void enhance(C& c) const{
+    c(&Series::id, range(begin(&Series::values), end(&Series::values)));
+  }
+};
+
+template<class T>
+void hashes(const string& name, const vector<T>& v){
+  auto run = [&](size_t (*f)(const T&)){
+    return timeIt([&]{
+        size_t s = 0;
+        for(const T& x : v)
+          s += f(x);
+        sink = s;
+      });
+  };
+  double old = run([](const T& x) -> size_t { return Hash<T>(x); });
+  report(name + " Hash<T>", old, old);
+  report(name + " Streaming<WyHash>", run([](const T& x) -> size_t {
+        return Hash<T, std::hash, Streaming<WyHash> >(x); }), old);
+  report(name + " Streaming<XXH64>", run([](const T& x) -> size_t {
+        return Hash<T, std::hash, Streaming<XXH64> >(x); }), old);
+}
+
+void streamingHash(){
+  cout << "Hashing 10^6 objects per field (std::hash + combine)"
+       << " and streaming:" << endl;
+  const size_t n = 1000000;
+  hashes("{string, string, long}", makeRecords(n));
+
+  std::mt19937 rng(3);
+  vector<Box> boxes(n);
+  for(auto& x : boxes)
+    x = Box{int(rng()), int(rng()), int(rng()), int(rng()), long(rng())};
+  hashes("{int, int, int, int, long}", boxes);
+
+  vector<Series> series(n / 10);
+  for(auto& x : series){
+    x.id = long(rng());
+    x.values.resize(64);
+    for(auto& y : x.values)
+      y = int(rng());
+  }
+  hashes("{long, 64 x int}", series);
+}
+Register r8("hash_append", streamingHash);
+
+//#################### 9 incremental hash ############################
+
+struct BookEntry {
+  long id;
+  double price;
+  int quantity;
+  string trader, venue;
+  vector<int> fills;
+
+  template<class C> void enhance(C& c) const{
+    c(&BookEntry::id, &BookEntry::price, &BookEntry::quantity,
+      &BookEntry::trader, &BookEntry::venue,
+      range(begin(&BookEntry::fills), end(&BookEntry::fills)));
+  }
+};
+
+void incremental(){
+  cout << "Rehashing 10^6 entries after a price change:" << endl;
+  const size_t n = 1000000;
+  std::mt19937 rng(4);
+  vector<BookEntry> entries(n);
+  vector<size_t> hashes(n);
+  for(size_t i = 0; i < n; ++i){
+    auto& x = entries[i];
+    x.id = long(i);
+    x.price = rng() % 10000 / 100.0;
+    x.quantity = int(rng() % 1000);
+    x.trader = "trader-" + std::to_string(rng() % 1000);
+    x.venue = "venue-" + std::to_string(rng() % 10);
+    x.fills.resize(rng() % 16);
+    for(auto& y : x.fills)
+      y = int(rng());
+    hashes[i] = incrementalHash(x);
+  }
+
+  double old = timeIt([&]{
+      size_t s = 0;
+      for(auto& x : entries){
+        x.price += 0.01;
+        s += hash(x);
+      }
+      sink = s;
+    });
+  report("Hash<T>", old, old);
+  report("IncrementalHash<T>", timeIt([&]{
+        size_t s = 0;
+        for(auto& x : entries){
+          x.price += 0.01;
+          s += incrementalHash(x);
+        }
+        sink = s;
+      }), old);
+  report("updateHash", timeIt([&]{
+        size_t s = 0;
+        for(size_t i = 0; i < n; ++i){
+          double price = entries[i].price;
+          entries[i].price += 0.01;
+          s += hashes[i] = updateHash(entries[i], hashes[i], &BookEntry::price, price);
+        }
+        sink = s;
+      }), old);
+}
+Register r9("incremental", incremental);
+
+//#################### 10 batch hashing ############################
+
+template<class T>
+void batch(const string& name, const vector<T>& v){
+  vector<size_t> out(v.size());
+  double old = timeIt([&]{
+      for(size_t i = 0; i < v.size(); ++i)
+        out[i] = hash(v[i]);
+      sink = out.back();
+    });
+  report(name + " Hash<T>", old, old);
+  report(name + " 4 at once", timeIt([&]{
+        size_t i = 0;
+        for(; i + 4 <= v.size(); i += 4){
+          const size_t a = hash(v[i]), b = hash(v[i + 1]),
+            c = hash(v[i + 2]), d = hash(v[i + 3]);
+          out[i] = a; out[i + 1] = b; out[i + 2] = c; out[i + 3] = d;
+        }
+        for(; i < v.size(); ++i)
+          out[i] = hash(v[i]);
+        sink = out.back();
+      }), old);
+  report(name + " hashMany", timeIt([&]{
+        hashMany(v.data(), v.size(), out.data());
+        sink = out.back();
+      }), old);
+}
+
+void batchHash(){
+  cout << "Hashing 10^6 objects one by one and in batches:" << endl;
+  const size_t n = 1000000;
+  std::mt19937 rng(5);
+  vector<Box> boxes(n);
+  for(auto& x : boxes)
+    x = Box{int(rng()), int(rng()), int(rng()), int(rng()), long(rng())};
+  batch("{int, int, int, int, long}", boxes);
+
+  vector<Record> records = makeRecords(n);
+  batch("{string, string, long}", records);
+  // strings scattered over the heap
+  std::shuffle(records.begin(), records.end(), rng);
+  batch("{string, string, long}, scattered", records);
+}
+Register r10("batch_hash", batchHash);
+
+//#################### 11 flat hash set ############################
+
+template<class T>
+void hashSets(const string& name, const vector<T>& v){
+  typedef std::unordered_set<T, typename Hash<T>::Functor,
+                             typename Equal<T>::Functor> Node;
+  vector<T> queries(v);
+  std::shuffle(queries.begin(), queries.end(), std::mt19937(6));
+
+  double old = timeIt([&]{
+      Node s;
+      for(const T& x : v)
+        s.insert(x);
+      sink = s.size();
+    }, 3);
+  report(name + " insert unordered_set", old, old);
+  report(name + " insert FlatHashSet", timeIt([&]{
+        FlatHashSet<T> s;
+        for(const T& x : v)
+          s.insert(x);
+        sink = s.size();
+      }, 3), old);
+
+  Node node(v.begin(), v.end());
+  FlatHashSet<T> flat;
+  for(const T& x : v)
+    flat.insert(x);
+
+  old = timeIt([&]{
+      size_t n = 0;
+      for(const T& x : queries)
+        n += node.count(x);
+      sink = n;
+    }, 3);
+  report(name + " find unordered_set", old, old);
+  report(name + " find FlatHashSet", timeIt([&]{
+        size_t n = 0;
+        for(const T& x : queries)
+          n += flat.count(x);
+        sink = n;
+      }, 3), old);
+  vector<typename FlatHashSet<T>::const_iterator> found(queries.size());
+  report(name + " find_many FlatHashSet", timeIt([&]{
+        flat.find_many(queries.data(), queries.size(), found.begin());
+        sink = found.size();
+      }, 3), old);
+}
+
+void flatHash(){
+  cout << "Inserting and finding 10^6 objects:" << endl;
+  const size_t n = 1000000;
+  std::mt19937 rng(6);
+  vector<Box> boxes(n);
+  for(size_t i = 0; i < n; ++i)
+    boxes[i] = Box{int(i), int(rng()), int(rng()), int(rng()), long(rng())};
+  hashSets("{int, int, int, int, long}", boxes);
+
+  hashSets("{string, string, long}", makeRecords(n));
+}
+Register r11("flat_hash", flatHash);
+
+//#################### 12 stable hash ############################
+
+template<class T>
+void stableHashes(const string& name, const vector<T>& v){
+  auto run = [&](size_t (*f)(const T&)){
+    return timeIt([&]{
+        size_t s = 0;
+        for(const T& x : v)
+          s += f(x);
+        sink = s;
+      });
+  };
+  double old = run([](const T& x) -> size_t { return Hash<T>(x); });
+  report(name + " Hash<T>", old, old);
+  report(name + " StableHash<T>", run([](const T& x) -> size_t {
+        return StableHash<T>(x); }), old);
+  report(name + " StableHash<T, WyHash>", run([](const T& x) -> size_t {
+        return StableHash<T, WyHash>(x); }), old);
+}
+
+void stable(){
+  cout << "Hashing 10^6 objects with std::hash and stable hashes:" << endl;
+  const size_t n = 1000000;
+  stableHashes("{string, string, long}", makeRecords(n));
+
+  std::mt19937 rng(7);
+  vector<Box> boxes(n);
+  for(auto& x : boxes)
+    x = Box{int(rng()), int(rng()), int(rng()), int(rng()), long(rng())};
+  stableHashes("{int, int, int, int, long}", boxes);
+
+  vector<Point3> points(n);
+  for(auto& x : points)
+    x = Point3{rng() % 100 / 10.0, rng() % 100 / 10.0, rng() % 100 / 10.0};
+  stableHashes("{double, double, double}", points);
+}
+Register r12("stable_hash", stable);
+
+//#################### 13 hash analysis ############################
+
+// small integer coordinates, the case that clusters easily
+struct Voxel {
+  int x, y, z;
+  unsigned char material;
+
+  template<class C> void enhance(C& c) const{
+    c(&Voxel::x, &Voxel::y, &Voxel::z, &Voxel::material);
+  }
+};
+
+void hashAnalysis(){
+  cout << "Distribution of 2^20 voxels {0..63}^3 x {0..3}:" << endl;
+  vector<Voxel> voxels;
+  for(int x = 0; x < 64; ++x)
+    for(int y = 0; y < 64; ++y)
+      for(int z = 0; z < 64; ++z)
+        for(int m = 0; m < 4; ++m)
+          voxels.push_back(Voxel{x, y, z, (unsigned char)m});
+  const vector<size_t> sizes{1 << 18, 1 << 19, 262139};
+
+  cout << "-- Hash<T>" << endl
+       << analyzeHash<Hash<Voxel> >(voxels, sizes);
+  cout << "-- Hash<T, std::hash, Streaming<WyHash>>" << endl
+       << analyzeHash<Hash<Voxel, std::hash, Streaming<WyHash> > >(voxels, sizes);
+  cout << "-- StableHash<T>" << endl
+       << analyzeHash<StableHash<Voxel> >(voxels, sizes);
+}
+Register r13("hash_analysis", hashAnalysis);
+
+//#################### 14 binary archive ############################
+
+struct Tick : Serializable<Tick> {
+  long time;
+  int venue, side;
+  double price, size;
+  string symbol;
+  vector<float> book;
+
+  template<class C>
+  void enhance(C& c) const{
+    c(&Tick::time, &Tick::venue, &Tick::side, &Tick::price, &Tick::size,
+      &Tick::symbol, &Tick::book);
+  }
+};
+
+void binaryArchive(){
+  cout << "Saving and loading 10^5 ticks {long, int, int, double, double,"
+    " string, vector<float>(8)}:" << endl;
+  std::mt19937 rng(11);
+  vector<Tick> ticks(100000);
+  for(auto& t : ticks){
+    t.time = long(rng());
+    t.venue = int(rng() % 16);
+    t.side = int(rng() % 2);
+    t.price = rng() % 100000 / 100.0;
+    t.size = rng() % 1000;
+    t.symbol = "SYM" + std::to_string(rng() % 1000);
+    t.book.assign(8, float(rng() % 100));
+  }
+
+  std::string boostBytes;
+  double oldSave = timeIt([&]{
+      std::ostringstream ss;
+      {
+        boost::archive::binary_oarchive oa(ss, boost::archive::no_header);
+        oa << ticks;
+      }
+      boostBytes = ss.str();
+    });
+  report("boost binary_oarchive", oldSave, oldSave);
+
+  BinaryWriter w;
+  report("BinaryWriter", timeIt([&]{
+        w.clear();
+        w << ticks;
+      }), oldSave);
+
+  vector<Tick> loaded;
+  double oldLoad = timeIt([&]{
+      std::istringstream ss(boostBytes);
+      boost::archive::binary_iarchive ia(ss, boost::archive::no_header);
+      ia >> loaded;
+    });
+  report("boost binary_iarchive", oldLoad, oldLoad);
+  report("BinaryReader", timeIt([&]{
+        BinaryReader r(w.buffer());
+        r >> loaded;
+      }), oldLoad);
+  sink = loaded.size();
+}
+Register r14("binary_archive", binaryArchive);
+
+//#################### 15 flat buffer view ############################
+
+void flatBufferView(){
+  cout << "Reading price and symbol of 10^5 ticks from single messages:" << endl;
+  std::mt19937 rng(13);
+  vector<vector<char> > binary, flat;
+  for(int i = 0; i < 100000; ++i){
+    Tick t;
+    t.time = long(rng());
+    t.venue = int(rng() % 16);
+    t.side = int(rng() % 2);
+    t.price = rng() % 100000 / 100.0;
+    t.size = rng() % 1000;
+    t.symbol = "SYM" + std::to_string(rng() % 1000);
+    t.book.assign(8, float(rng() % 100));
+    BinaryWriter w;
+    w << t;
+    binary.push_back(w.buffer());
+    flat.push_back(toFlat(t));
+  }
+
+  double old = timeIt([&]{
+      double s = 0;
+      for(const auto& m : binary){
+        Tick t;
+        BinaryReader r(m);
+        r >> t;
+        s += t.price + t.symbol.size();
+      }
+      sink = size_t(s);
+    });
+  report("BinaryReader, whole object", old, old);
+  report("View<T>, validated", timeIt([&]{
+        double s = 0;
+        for(const auto& m : flat){
+          View<Tick> v = flatView<Tick>(m);
+          s += v.get(&Tick::price) + v.get(&Tick::symbol).size();
+        }
+        sink = size_t(s);
+      }), old);
+  report("View<T>, trusted", timeIt([&]{
+        double s = 0;
+        for(const auto& m : flat){
+          View<Tick> v(m);
+          s += v.get(&Tick::price) + v.get(&Tick::symbol).size();
+        }
+        sink = size_t(s);
+      }), old);
+}
+Register r15("flat_view", flatBufferView);
+
+//#################### 16 memory mapped record file ############################
+
+void mappedRecordFile(){
+  cout << "Opening a file of 10^6 ticks and reading 10^5 random prices:" << endl;
+  std::mt19937 rng(17);
+  vector<Tick> ticks(1000000);
+  for(auto& t : ticks){
+    t.time = long(rng());
+    t.price = rng() % 100000 / 100.0;
+    t.symbol = "SYM" + std::to_string(rng() % 1000);
+    t.book.assign(8, float(rng() % 100));
+  }
+  vector<size_t> picks(100000);
+  for(auto& i : picks)
+    i = rng() % ticks.size();
+
+  const string boostPath = "/tmp/enhance_bench_ticks.boost";
+  const string recordPath = "/tmp/enhance_bench_ticks.records";
+  {
+    std::ofstream out(boostPath, std::ios::binary);
+    boost::archive::binary_oarchive oa(out, boost::archive::no_header);
+    oa << ticks;
+  }
+  MappedRecordFile<Tick>::write(recordPath, ticks);
+
+  double old = timeIt([&]{
+      vector<Tick> loaded;
+      std::ifstream in(boostPath, std::ios::binary);
+      boost::archive::binary_iarchive ia(in, boost::archive::no_header);
+      ia >> loaded;
+      double s = 0;
+      for(size_t i : picks)
+        s += loaded[i].price;
+      sink = size_t(s);
+    }, 3);
+  report("boost binary_iarchive, whole file", old, old);
+  report("MappedRecordFile<T>::view", timeIt([&]{
+        MappedRecordFile<Tick> file(recordPath);
+        double s = 0;
+        for(size_t i : picks)
+          s += file.view(i).get(&Tick::price);
+        sink = size_t(s);
+      }, 3), old);
+  report("MappedRecordFile<T>::operator[]", timeIt([&]{
+        MappedRecordFile<Tick> file(recordPath);
+        double s = 0;
+        for(size_t i : picks)
+          s += file[i].price;
+        sink = size_t(s);
+      }, 3), old);
+  std::remove(boostPath.c_str());
+  std::remove(recordPath.c_str());
+}
+Register r16("mapped_records", mappedRecordFile);
+
+//#################### 17 columnar serialization ############################
+
+void columnar(){
+  cout << "Summing the prices of 10^6 serialized ticks:" << endl;
+  std::mt19937 rng(19);
+  vector<Tick> ticks(1000000);
+  for(auto& t : ticks){
+    t.time = long(rng());
+    t.price = rng() % 100000 / 100.0;
+    t.symbol = "SYM" + std::to_string(rng() % 1000);
+    t.book.assign(8, float(rng() % 100));
+  }
+  BinaryWriter w;
+  w << ticks;
+  const vector<char> columns = toColumns(ticks);
+
+  double old = timeIt([&]{
+      vector<Tick> loaded;
+      BinaryReader r(w.buffer());
+      r >> loaded;
+      double s = 0;
+      for(const Tick& t : loaded)
+        s += t.price;
+      sink = size_t(s);
+    }, 3);
+  report("BinaryReader, all rows", old, old);
+  report("ColumnReader::loadAll", timeIt([&]{
+        vector<Tick> loaded = ColumnReader<Tick>(columns).loadAll();
+        double s = 0;
+        for(const Tick& t : loaded)
+          s += t.price;
+        sink = size_t(s);
+      }, 3), old);
+  report("ColumnReader::loadColumn", timeIt([&]{
+        vector<double> prices = ColumnReader<Tick>(columns).loadColumn(&Tick::price);
+        double s = 0;
+        for(double p : prices)
+          s += p;
+        sink = size_t(s);
+      }, 3), old);
+  report("ColumnReader::column, in place", timeIt([&]{
+        ColumnView<double> prices = ColumnReader<Tick>(columns).column(&Tick::price);
+        double s = 0;
+        for(size_t i = 0; i < prices.size(); ++i)
+          s += prices[i];
+        sink = size_t(s);
+      }, 3), old);
+}
+Register r17("columnar", columnar);
+
+//#################### 18 compact encoding ############################
+
+void compactEncoding(){
+  cout << "Saving and loading 10^7 small int32 (|x| < 64, every 16th < 2^20):"
+       << endl;
+  std::mt19937 rng(23);
+  vector<int32_t> values(10000000);
+  for(size_t i = 0; i < values.size(); ++i)
+    values[i] = i % 16 ? int32_t(rng() % 127) - 63 : int32_t(rng() % (1 << 20));
+
+  BinaryWriter fixed;
+  CompactWriter compact;
+  double oldSave = timeIt([&]{ fixed.clear(); fixed << values; });
+  report("BinaryWriter", oldSave, oldSave);
+  report("CompactWriter", timeIt([&]{ compact.clear(); compact << values; }), oldSave);
+  cout << "  bytes: " << fixed.size() << " fixed, " << compact.size() << " compact" << endl;
+
+  vector<int32_t> loaded;
+  double oldLoad = timeIt([&]{
+      BinaryReader r(fixed.buffer());
+      r >> loaded;
+    });
+  report("BinaryReader", oldLoad, oldLoad);
+  report("CompactReader, one varint at a time", timeIt([&]{
+        const char* p = compact.data();
+        const char* end = p + compact.size();
+        uint64_t n;
+        p += varint::decode(p, end, n);
+        loaded.resize(size_t(n));
+        for(auto& x : loaded){
+          uint64_t u;
+          p += varint::decode(p, end, u);
+          varint::fromUnsigned(u, x);
+        }
+      }), oldLoad);
+  report("CompactReader", timeIt([&]{
+        CompactReader r(compact.buffer());
+        r >> loaded;
+      }), oldLoad);
+  sink = loaded.size();
+}
+Register r18("compact", compactEncoding);
+
+//#################### 19 delta serialization ############################
+
+struct Book {
+  long sequence;
+  int venue, status;
+  std::array<double, 256> bids, asks;
+
+  template<class C>
+  void enhance(C& c) const{
+    c(&Book::sequence, &Book::venue, &Book::status,
+      range(begin(&Book::bids), end(&Book::bids)),
+      range(begin(&Book::asks), end(&Book::asks)));
+  }
+};
+
+void deltaSerialization(){
+  cout << "Publishing 10^4 updates of a book {long, int, int, 2 x double[256]},"
+    " 3 values changed each:" << endl;
+  std::mt19937 rng(29);
+  Book prev{};
+  for(auto& x : prev.bids) x = rng() % 1000;
+  for(auto& x : prev.asks) x = rng() % 1000;
+  vector<Book> updates(10000, prev);
+  for(size_t i = 0; i < updates.size(); ++i){
+    updates[i].sequence = long(i);
+    updates[i].bids[rng() % 256] += 1;
+    updates[i].asks[rng() % 256] -= 1;
+  }
+
+  size_t full = 0, delta = 0;
+  BinaryWriter w;
+  double old = timeIt([&]{
+      full = 0;
+      for(const Book& b : updates){
+        w.clear();
+        Save<BinaryWriter, const Book>(b, w).callEnhance();
+        full += w.size();
+      }
+    });
+  report("Save, whole object", old, old);
+  report("saveDelta", timeIt([&]{
+        delta = 0;
+        const Book* last = &prev;
+        for(const Book& b : updates){
+          w.clear();
+          saveDelta(*last, b, w);
+          delta += w.size();
+          last = &b;
+        }
+      }), old);
+  cout << "  bytes per update: " << full / updates.size() << " whole, "
+       << delta / updates.size() << " delta" << endl;
+}
+Register r19("delta", deltaSerialization);
+
+//#################### 20 tagged serialization ############################
+
+struct Order {
+  long id;
+  int qty, venue;
+  double price;
+  string symbol;
+
+  template<class C>
+  void enhance(C& c) const{
+    c(tag<1>(&Order::id), tag<2>(&Order::qty), tag<3>(&Order::venue),
+      tag<4>(&Order::price), tag<5>(&Order::symbol));
+  }
+};
+
+// an older version, which does not know `venue` and `price`
+struct OldOrder {
+  long id;
+  int qty;
+  string symbol;
+
+  template<class C>
+  void enhance(C& c) const{
+    c(tag<1>(&OldOrder::id), tag<2>(&OldOrder::qty), tag<5>(&OldOrder::symbol));
+  }
+};
+
+void taggedSerialization(){
+  cout << "Saving and loading 10^5 orders {long, int, int, double, string}"
+    " with CompactWriter:" << endl;
+  std::mt19937 rng(31);
+  vector<Order> orders(100000);
+  for(size_t i = 0; i < orders.size(); ++i){
+    orders[i].id = long(i);
+    orders[i].qty = int(rng() % 1000);
+    orders[i].venue = int(rng() % 8);
+    orders[i].price = (rng() % 100000) / 100.;
+    orders[i].symbol = "SYM" + std::to_string(rng() % 500);
+  }
+
+  CompactWriter plain, tagged;
+  double oldSave = timeIt([&]{
+      plain.clear();
+      for(const Order& o : orders)
+        Save<CompactWriter, const Order>(o, plain).callEnhance();
+    });
+  report("Save, same accessor list", oldSave, oldSave);
+  report("saveTagged", timeIt([&]{
+        tagged.clear();
+        for(const Order& o : orders)
+          saveTagged(o, tagged);
+      }), oldSave);
+  cout << "  bytes per order: " << plain.size() / orders.size() << " plain, "
+       << tagged.size() / orders.size() << " tagged" << endl;
+
+  vector<Order> loaded(orders.size());
+  vector<OldOrder> old(orders.size());
+  double oldLoad = timeIt([&]{
+      CompactReader r(plain.buffer());
+      for(Order& o : loaded)
+        Load<CompactReader, Order>(o, r).callEnhance();
+    });
+  report("Load, same accessor list", oldLoad, oldLoad);
+  report("loadTagged", timeIt([&]{
+        CompactReader r(tagged.buffer());
+        for(Order& o : loaded)
+          loadTagged(o, r);
+      }), oldLoad);
+  report("loadTagged, older version", timeIt([&]{
+        CompactReader r(tagged.buffer());
+        for(OldOrder& o : old)
+          loadTagged(o, r);
+      }), oldLoad);
+  sink = loaded.size() + old.size();
+}
+Register r20("tagged", taggedSerialization);
+
+//#################### 21 serialized size ############################
+
+struct Fixed {
+  long time;
+  int venue, side;
+  double price, size;
+
+  template<class C>
+  void enhance(C& c) const{
+    c(&Fixed::time, &Fixed::venue, &Fixed::side, &Fixed::price, &Fixed::size);
+  }
+};
+
+template<class Writer, class T>
+void sizedSaves(const string& name, const vector<T>& v){
+  double old = timeIt([&]{
+      Writer w;
+      for(const T& x : v)
+        w << x;
+      sink = w.size();
+    });
+  report(name + ", growing buffer", old, old);
+  report(name + ", sized first", timeIt([&]{
+        Writer w;
+        w.reserve(serializedSize<Writer>(v.begin(), v.end()));
+        for(const T& x : v)
+          w << x;
+        sink = w.size();
+      }), old);
+  report(name + ", size only", timeIt([&]{
+        sink = serializedSize<Writer>(v.begin(), v.end());
+      }), old);
+}
+
+void serializedSizes(){
+  cout << "Saving 10^5 objects into a new buffer:" << endl;
+  std::mt19937 rng(37);
+  vector<Tick> ticks(100000);
+  vector<Fixed> fixed(100000);
+  for(size_t i = 0; i < ticks.size(); ++i){
+    Tick& t = ticks[i];
+    t.time = long(rng());
+    t.venue = int(rng() % 16);
+    t.side = int(rng() % 2);
+    t.price = rng() % 100000 / 100.0;
+    t.size = rng() % 1000;
+    t.symbol = "SYM" + std::to_string(rng() % 1000);
+    t.book.assign(8, float(rng() % 100));
+    fixed[i] = Fixed{t.time, t.venue, t.side, t.price, t.size};
+  }
+  sizedSaves<BinaryWriter>("ticks, BinaryWriter", ticks);
+  sizedSaves<CompactWriter>("ticks, CompactWriter", ticks);
+  sizedSaves<BinaryWriter>("fixed size, BinaryWriter", fixed);
+}
+Register r21("serialized_size", serializedSizes);
+
+//#################### 22 ranges in Boost archives ############################
+
+// saves and loads element by element, like `Serialize` without
+// `Operator::applyRange` and `Operator::applyContainer`
+template<class Archive, class Operator>
+struct ElementwiseSerializeOp {
+  typedef Archive& result_t;
+  template<class... A>
+  static bool apply(A&&... a){ return Operator::apply(std::forward<A>(a)...); }
+};
+
+template<class OArchive, class IArchive>
+void boostRanges(const string& name, size_t n){
+  Signal s, loaded;
+  for(size_t i = 0; i < n; ++i)
+    s.data.push_back(i * 0.25);
+  loaded.data.resize(n);
+
+  string old, bulk;
+  double oldSave = timeIt([&]{
+      std::ostringstream ss;
+      {
+        OArchive oa(ss, boost::archive::no_header);
+        UnaryCombiner<ElementwiseSerializeOp<OArchive, SaveOp>, const Signal>(s, oa)
+          .callEnhance();
+      }
+      old = ss.str();
+    });
+  report(name + " save, per element", oldSave, oldSave);
+  report(name + " save, make_array", timeIt([&]{
+        std::ostringstream ss;
+        {
+          OArchive oa(ss, boost::archive::no_header);
+          Save<OArchive, const Signal>(s, oa).callEnhance();
+        }
+        bulk = ss.str();
+      }), oldSave);
+
+  double oldLoad = timeIt([&]{
+      std::istringstream ss(old);
+      IArchive ia(ss, boost::archive::no_header);
+      UnaryCombiner<ElementwiseSerializeOp<IArchive, LoadOp>, Signal>(loaded, ia)
+        .callEnhance();
+    });
+  report(name + " load, per element", oldLoad, oldLoad);
+  report(name + " load, make_array", timeIt([&]{
+        std::istringstream ss(bulk);
+        IArchive ia(ss, boost::archive::no_header);
+        Load<IArchive, Signal>(loaded, ia).callEnhance();
+      }), oldLoad);
+  sink = loaded.data.size();
+}
+
+void boostRangeArchives(){
+  cout << "Saving and loading container(&Signal::data) with Boost archives:" << endl;
+  boostRanges<boost::archive::binary_oarchive, boost::archive::binary_iarchive>
+    ("10^6 doubles, binary", 1000000);
+  boostRanges<boost::archive::text_oarchive, boost::archive::text_iarchive>
+    ("10^5 doubles, text", 100000);
+}
+Register r22("boost_ranges", boostRangeArchives);
+
+//#################### 23 chunked serialization ############################
+
+void chunkedSerialization(){
+  const size_t threads = parallel::threads();
+  cout << "Saving and loading 10^6 ticks {long, int, int, double, double,"
+    " string, vector<float>(8)}, " << threads << " hardware threads:" << endl;
+  std::mt19937 rng(41);
+  vector<Tick> ticks(1000000);
+  for(auto& t : ticks){
+    t.time = long(rng());
+    t.venue = int(rng() % 16);
+    t.side = int(rng() % 2);
+    t.price = rng() % 100000 / 100.0;
+    t.size = rng() % 1000;
+    t.symbol = "SYM" + std::to_string(rng() % 1000);
+    t.book.assign(8, float(rng() % 100));
+  }
+
+  BinaryWriter w;
+  double oldSave = timeIt([&]{
+      w = BinaryWriter();
+      w << ticks;
+    }, 3);
+  report("BinaryWriter, whole vector", oldSave, oldSave);
+  vector<char> bytes;
+  report("saveChunked, 1 thread", timeIt([&]{
+        bytes = saveChunked(ticks, 1);
+      }, 3), oldSave);
+  report("saveChunked, all threads", timeIt([&]{
+        bytes = saveChunked(ticks, threads);
+      }, 3), oldSave);
+
+  vector<Tick> loaded;
+  double oldLoad = timeIt([&]{
+      BinaryReader r(w.buffer());
+      r >> loaded;
+    }, 3);
+  report("BinaryReader, whole vector", oldLoad, oldLoad);
+  report("loadChunked, 1 thread", timeIt([&]{
+        loadChunked(bytes, loaded, 1);
+      }, 3), oldLoad);
+  report("loadChunked, all threads", timeIt([&]{
+        loadChunked(bytes, loaded, threads);
+      }, 3), oldLoad);
+  sink = loaded.size();
+}
+Register r23("chunked", chunkedSerialization);
+
+//#################### 24 arena loading ############################
+
+struct ArenaTick : Serializable<ArenaTick> {
+  long time;
+  int venue, side;
+  double price, size;
+  ArenaString symbol;
+  ArenaVector<float> book;
+
+  template<class C>
+  void enhance(C& c) const{
+    c(&ArenaTick::time, &ArenaTick::venue, &ArenaTick::side, &ArenaTick::price,
+      &ArenaTick::size, &ArenaTick::symbol, &ArenaTick::book);
+  }
+};
+
+void arenaLoading(){
+  cout << "Loading 10^5 ticks {long, int, int, double, double, string(>15),"
+    " vector<float>(8)}:" << endl;
+  std::mt19937 rng(43);
+  vector<Tick> ticks(100000);
+  for(auto& t : ticks){
+    t.time = long(rng());
+    t.venue = int(rng() % 16);
+    t.side = int(rng() % 2);
+    t.price = rng() % 100000 / 100.0;
+    t.size = rng() % 1000;
+    t.symbol = "EXCHANGE:SYMBOL-" + std::to_string(rng() % 1000);
+    t.book.assign(8, float(rng() % 100));
+  }
+  BinaryWriter w;
+  w << ticks;
+
+  vector<Tick> loaded;
+  double heap = timeIt([&]{
+      vector<Tick> fresh;
+      BinaryReader r(w.buffer());
+      r >> fresh;
+      loaded.swap(fresh);
+    }, 10);
+  report("std::allocator", heap, heap);
+
+  Arena arena;
+  ArenaVector<ArenaTick> arenaLoaded;
+  report("Arena, reset per batch", timeIt([&]{
+        arenaLoaded = ArenaVector<ArenaTick>();
+        arena.reset();
+        BinaryReader r(w.buffer());
+        r.useArena(&arena);
+        r >> arenaLoaded;
+      }, 10), heap);
+  cout << "  arena bytes per batch: " << arena.size() << endl;
+  sink = loaded.size() + arenaLoaded.size();
+}
+Register r24("arena", arenaLoading);
+
+//#################### main ############################
+
+int main(int argc, char** argv){
+  if(argc > 2)
+    maxExponent = std::atoi(argv[2]);
+  for(auto& b : benchmarks())
+    if(argc < 2 || b.first == argv[1]){
+      cout << "[" << b.first << "] ";
+      b.second();
+    }
+  return 0;
+}
@@ -24,10 +24,17 @@
 #include <iostream>
 #include <set>
 #include <unordered_set>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <algorithm>
 
 #ifndef ENHANCE_NO_SERIALIZE
 #include <boost/archive/text_oarchive.hpp>
 #include <boost/archive/text_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/serialization/string.hpp>
 #endif // ENHANCE_NO_SERIALIZE
 
 using namespace enhance;
@@ -299,8 +306,991 @@ TEST_CASE( "Serialize" ) {
 
 
 }
+
+struct Trace : EqualComparable<Trace>, Serializable<Trace> {
+  int id;
+  std::vector<double> samples;
+  std::array<int16_t, 4> corners;
+  std::vector<string> labels;
+
+  Trace() : id(0), corners() {}
+
+  template<class C> void enhance(C& c) const{
+    c(&Trace::id, container(&Trace::samples),
+      range(begin(&Trace::corners), end(&Trace::corners)),
+      container(&Trace::labels));
+  }
+};
+
+struct Triple {
+  std::array<int, 3> values;
+
+  template<class C> void enhance(C& c) const{
+    c(container(&Triple::values));
+  }
+};
+
+template<class OArchive, class IArchive, class Value>
+void boostRoundTrip(const Value& x, Value& y){
+  std::stringstream ss;
+  {
+    OArchive oa(ss);
+    oa << x;
+  }
+  IArchive ia(ss);
+  ia >> y;
+}
+
+TEST_CASE( "Serialize ranges in Boost archives" ) {
+  Trace x;
+  x.id = 3;
+  for(int i = 0; i < 1000; ++i)
+    x.samples.push_back(i * 0.5);
+  x.corners = {{1, -2, 3, -4}};
+  x.labels = {"a", "bc"};
+
+  // found without ENHANCE_BOOST_SERIALIZATION being defined here
+  REQUIRE( IsBoostArchive<boost::archive::binary_oarchive>::value );
+  REQUIRE( IsBoostArchive<boost::archive::text_iarchive>::value );
+  REQUIRE( !IsBoostArchive<BinaryWriter>::value );
+
+  // containers are resized on load
+  Trace text, binary;
+  boostRoundTrip<boost::archive::text_oarchive, boost::archive::text_iarchive>(x, text);
+  REQUIRE( text == x );
+  boostRoundTrip<boost::archive::binary_oarchive, boost::archive::binary_iarchive>(x, binary);
+  REQUIRE( binary == x );
+
+  // containers without `resize` need the right number of elements
+  std::stringstream ss;
+  {
+    boost::archive::text_oarchive oa(ss);
+    std::vector<int> four = {1, 2, 3, 4};
+    oa << uint64_t(four.size()) << boost::serialization::make_array(four.data(), 4);
+  }
+  boost::archive::text_iarchive ia(ss);
+  Triple triple;
+  auto load = serialize(triple, ia);
+  REQUIRE_THROWS_AS( load.callEnhance(), const std::runtime_error& );
+}
 #endif // ENHANCE_NO_SERIALIZE
 
+// archives of numbers only, that are not Boost archives, so contiguous
+// ranges are saved and loaded one element at a time
+struct ValueWriter {
+  typedef std::true_type is_saving;
+  typedef std::false_type is_loading;
+
+  std::vector<char> bytes;
+  size_t calls = 0;
+
+  template<class Value>
+  ValueWriter& operator<<(const Value& v){
+    static_assert(std::is_arithmetic<Value>::value, "numbers only");
+    const char* p = reinterpret_cast<const char*>(&v);
+    bytes.insert(bytes.end(), p, p + sizeof(Value));
+    ++calls;
+    return *this;
+  }
+
+  template<class Value>
+  ValueWriter& operator&(const Value& v){
+    return *this << v;
+  }
+};
+
+struct ValueReader {
+  typedef std::false_type is_saving;
+  typedef std::true_type is_loading;
+
+  const std::vector<char>& bytes;
+  size_t pos = 0;
+
+  explicit ValueReader(const std::vector<char>& bytes) : bytes(bytes){}
+
+  template<class Value>
+  ValueReader& operator>>(Value& v){
+    static_assert(std::is_arithmetic<Value>::value, "numbers only");
+    if(bytes.size() - pos < sizeof(Value))
+      throw std::runtime_error("ValueReader: unexpected end of data");
+    std::memcpy(&v, &bytes[pos], sizeof(Value));
+    pos += sizeof(Value);
+    return *this;
+  }
+
+  template<class Value>
+  ValueReader& operator&(Value& v){
+    return *this >> v;
+  }
+};
+
+struct Curve : EqualComparable<Curve>, Serializable<Curve> {
+  int id;
+  std::vector<double> points;
+  std::array<int16_t, 3> knots;
+
+  Curve() : id(0), knots() {}
+
+  template<class C> void enhance(C& c) const{
+    c(&Curve::id, container(&Curve::points), container(&Curve::knots));
+  }
+};
+
+TEST_CASE( "element-wise ranges" ) {
+  Curve c, d;
+  c.id = 4;
+  c.points = {0.5, -1, 2, 8};
+  c.knots = {{1, -2, 3}};
+  d.points = {7};
+
+  REQUIRE( !IsBoostArchive<ValueWriter>::value );
+  ValueWriter w;
+  c.serialize(w, 0);
+  // the id, two numbers of elements and every element on its own
+  REQUIRE( w.calls == 1 + (1 + 4) + (1 + 3) );
+  REQUIRE( w.bytes.size() == 4 + (8 + 4 * 8) + (8 + 3 * 2) );
+
+  ValueReader r(w.bytes);
+  d.serialize(r, 0);
+  REQUIRE( c == d );
+  REQUIRE( r.pos == w.bytes.size() );
+
+  // a corrupt number of elements fails on the missing data, instead
+  // of allocating that many
+  ValueWriter corrupt;
+  corrupt << 4 << (uint64_t(1) << 60) << 0.5;
+  ValueReader rc(corrupt.bytes);
+  REQUIRE_THROWS_AS( d.serialize(rc, 0), const std::runtime_error& );
+
+  // more elements than fit into the first step
+  Curve large;
+  for(int i = 0; i < 20000; ++i)
+    large.points.push_back(i / 4.0);
+  ValueWriter wl;
+  large.serialize(wl, 0);
+  ValueReader rl(wl.bytes);
+  d.serialize(rl, 0);
+  REQUIRE( large == d );
+}
+
+struct Sample : EqualComparable<Sample>, Serializable<Sample> {
+  int32_t id, kind;
+  double weight;
+  string name;
+  std::vector<float> values;
+  std::vector<string> tags;
+  std::array<int16_t, 3> position;
+
+  template<class C> void enhance(C& c) const{
+    c(&Sample::id, &Sample::kind, &Sample::weight, &Sample::name,
+      &Sample::values, &Sample::tags,
+      range(begin(&Sample::position), end(&Sample::position)));
+  }
+};
+
+// not `Serializable`, saved through its accessed values
+struct Batch : EqualComparable<Batch> {
+  Q first;
+  std::vector<Sample> samples;
+
+  Batch() {}
+  Batch(Q first, std::vector<Sample> samples): first(first), samples(samples) {}
+
+  template<class C> void enhance(C& c) const{
+    c(&Batch::first, &Batch::samples);
+  }
+};
+
+TEST_CASE( "binary archive" ) {
+  Sample s{}, t{};
+  s.id = 7;
+  s.kind = -3;
+  s.weight = 0.25;
+  s.name = "sensor";
+  s.values = {1.5f, -2.0f, 3.25f};
+  s.tags = {"a", "", "bc"};
+  s.position = {{4, 5, -6}};
+
+  BinaryWriter w;
+  w << s;
+  // id, kind and weight are a single run of 16 bytes, the position a
+  // single range of 6 bytes after its number of elements
+  REQUIRE( w.size() == 16 + (8 + 6) + (8 + 3 * 4) + (8 + 3 * 8 + 3) + (8 + 6) );
+
+  BinaryReader r(w.buffer());
+  r >> t;
+  REQUIRE( s == t );
+  REQUIRE( r.remaining() == 0 );
+
+  Batch b(Q(1, 2, 3), {s, t, Sample{}}), c;
+  BinaryWriter w2;
+  w2 << b;
+  BinaryReader r2(w2.buffer());
+  r2 >> c;
+  REQUIRE( b == c );
+
+  BinaryReader truncated(w2.data(), w2.size() - 1);
+  REQUIRE_THROWS_AS( truncated >> c, const std::runtime_error& );
+
+  // `container(ac)` accessors save the number of elements, which
+  // resizes the container on load
+  Trace trace, loadedTrace;
+  trace.id = 3;
+  trace.samples = {0.5, -1.5};
+  trace.corners = {{1, 2, 3, 4}};
+  trace.labels = {"x", "yz", ""};
+  loadedTrace.samples = {1, 2, 3, 4, 5};
+  CompactWriter w4;
+  w4 << trace;
+  REQUIRE( w4.size() == 1 + (1 + 2 * 8) + (1 + 4) + (1 + 2 + 3 + 1) );
+  CompactReader r4(w4.buffer());
+  r4 >> loadedTrace;
+  REQUIRE( trace == loadedTrace );
+  REQUIRE( r4.remaining() == 0 );
+
+  // a corrupt number of elements fails on the missing data
+  BinaryWriter corrupt;
+  corrupt << 3 << (uint64_t(1) << 60) << 0.5 << 1.5;
+  BinaryReader rc(corrupt.buffer());
+  REQUIRE_THROWS_AS( rc >> loadedTrace, const std::runtime_error& );
+
+  // containers without `resize` need the right number of elements
+  BinaryWriter w5;
+  w5 << uint64_t(4) << 1 << 2 << 3 << 4;
+  BinaryReader r5(w5.buffer());
+  Triple triple;
+  REQUIRE_THROWS_AS( r5 >> triple, const std::runtime_error& );
+
+  // `std::vector<bool>` is saved element by element
+  std::vector<bool> flags = {true, false, false, true, true}, loaded = {false};
+  BinaryWriter w3;
+  w3 << flags;
+  REQUIRE( w3.size() == 8 + flags.size() );
+  BinaryReader r3(w3.buffer());
+  r3 >> loaded;
+  REQUIRE( loaded == flags );
+}
+
+struct Window : EqualComparable<Window> {
+  int lo, hi;
+
+  Window(int lo, int hi) : lo(lo), hi(hi) {}
+
+  template<class C> void enhance(C& c) const{
+    c(&Window::lo, &Window::hi);
+  }
+};
+
+struct Snapshot : EqualComparable<Snapshot> {
+  int64_t version;
+  string owner;
+  std::array<double, 32> levels;
+  Window limits;
+  std::vector<int> history;
+
+  Snapshot() : version(0), levels(), limits(0, 0) {}
+
+  template<class C> void enhance(C& c) const{
+    c(&Snapshot::version, &Snapshot::owner,
+      range(begin(&Snapshot::levels), end(&Snapshot::levels)),
+      &Snapshot::limits, &Snapshot::history);
+  }
+};
+
+TEST_CASE( "delta serialization" ) {
+  Snapshot prev;
+  prev.owner = "desk 7";
+  for(size_t i = 0; i < prev.levels.size(); ++i)
+    prev.levels[i] = double(i);
+  prev.history = {1, 2, 3};
+  Snapshot cur = prev;
+  cur.version = 1;
+  cur.levels[3] = -1;
+  cur.levels[30] = -2;
+
+  BinaryWriter w;
+  saveDelta(prev, cur, w);
+  // 36 values and the length of the range: a bitmap of 5 bytes, then
+  // 3 changed values
+  REQUIRE( w.size() == (8 + 5) + 3 * 8 );
+  Snapshot x = prev;
+  BinaryReader r(w.buffer());
+  applyDelta(x, r);
+  REQUIRE( x == cur );
+  REQUIRE( r.remaining() == 0 );
+
+  // nothing changed
+  BinaryWriter same;
+  saveDelta(cur, cur, same);
+  BinaryReader rs(same.buffer());
+  applyDelta(x, rs);
+  REQUIRE( x == cur );
+
+  // members of other types and compact archives
+  Snapshot next = cur;
+  next.owner = "desk 8";
+  next.limits = Window(-5, 5);
+  next.history.push_back(4);
+  CompactWriter cw;
+  saveDelta(cur, next, cw);
+  CompactReader cr(cw.buffer());
+  applyDelta(x, cr);
+  REQUIRE( x == next );
+
+  // containers, that grow and shrink, are saved as a whole
+  Trace small, large;
+  small.samples = {1, 2};
+  small.labels = {"a", "b", "c"};
+  large = small;
+  large.samples = {1, 2, 3, 4};
+  large.labels = {"a"};
+  large.corners[2] = 7;
+  for(int k = 0; k < 2; ++k){
+    const Trace& from = k ? large : small;
+    const Trace& to = k ? small : large;
+    BinaryWriter wt;
+    saveDelta(from, to, wt);
+    Trace t = from;
+    BinaryReader rt(wt.buffer());
+    applyDelta(t, rt);
+    REQUIRE( t == to );
+    REQUIRE( rt.remaining() == 0 );
+  }
+
+  // a delta of another type
+  BinaryReader other(w.buffer());
+  Window window(0, 0);
+  REQUIRE_THROWS_AS( applyDelta(window, other), const std::runtime_error& );
+}
+
+enum class Side : char { buy, sell };
+
+struct Counters : EqualComparable<Counters>, Serializable<Counters> {
+  uint32_t hits;
+  int64_t delta;
+  int8_t small;
+  bool flag;
+  Side side;
+  double ratio;
+  std::vector<int32_t> samples;
+
+  template<class C> void enhance(C& c) const{
+    c(&Counters::hits, &Counters::delta, &Counters::small, &Counters::flag,
+      &Counters::side, &Counters::ratio, &Counters::samples);
+  }
+};
+
+TEST_CASE( "compact archive" ) {
+  char buffer[10];
+  REQUIRE( varint::encode(0, buffer) == 1 );
+  REQUIRE( varint::encode(127, buffer) == 1 );
+  REQUIRE( varint::encode(300, buffer) == 2 );
+  REQUIRE( (unsigned char)buffer[0] == 0xac );
+  REQUIRE( (unsigned char)buffer[1] == 0x02 );
+  REQUIRE( varint::encode(std::numeric_limits<uint64_t>::max(), buffer) == 10 );
+  REQUIRE( varint::zigzag(0) == 0 );
+  REQUIRE( varint::zigzag(-1) == 1 );
+  REQUIRE( varint::zigzag(1) == 2 );
+  REQUIRE( varint::zigzag(std::numeric_limits<int64_t>::min()) ==
+           std::numeric_limits<uint64_t>::max() );
+  REQUIRE( varint::unzigzag(varint::zigzag(-123456789)) == -123456789 );
+
+  Counters x{}, y{};
+  x.hits = 5;
+  x.delta = -2;
+  x.small = -128;
+  x.flag = true;
+  x.side = Side::sell;
+  x.ratio = 0.5;
+  // single byte varints and some longer ones in between
+  for(int i = 0; i < 100; ++i)
+    x.samples.push_back(i % 17 == 0 ? -100000 * i : i % 50 - 25);
+
+  CompactWriter w;
+  w << x;
+  BinaryWriter fixed;
+  fixed << x;
+  REQUIRE( w.size() < fixed.size() / 3 );
+  CompactReader r(w.buffer());
+  r >> y;
+  REQUIRE( x == y );
+  REQUIRE( r.remaining() == 0 );
+
+  // extreme values
+  std::vector<int64_t> extremes{std::numeric_limits<int64_t>::min(),
+      std::numeric_limits<int64_t>::max(), 0, -1}, back;
+  CompactWriter we;
+  we << extremes;
+  CompactReader re(we.buffer());
+  re >> back;
+  REQUIRE( back == extremes );
+
+  // values out of the range of the type, overlong and truncated varints
+  CompactWriter big;
+  big << uint64_t(256);
+  uint8_t narrow;
+  CompactReader rb(big.buffer());
+  REQUIRE_THROWS_AS( rb >> narrow, const std::runtime_error& );
+
+  std::vector<char> overlong(11, char(0x80));
+  overlong.back() = 0;
+  uint64_t wide;
+  CompactReader ro(overlong);
+  REQUIRE_THROWS_AS( ro >> wide, const std::runtime_error& );
+
+  CompactReader truncated(w.data(), w.size() - 1);
+  REQUIRE_THROWS_AS( truncated >> y, const std::runtime_error& );
+}
+
+struct Fill : TaggedSerializable<Fill>, EqualComparable<Fill> {
+  int32_t qty;
+  double price;
+
+  Fill(int32_t qty = 0, double price = 0) : qty(qty), price(price) {}
+
+  template<class C> void enhance(C& c) const{
+    c(tag<1>(&Fill::qty), tag<2>(&Fill::price));
+  }
+};
+
+struct OrderV1 : TaggedSerializable<OrderV1>, EqualComparable<OrderV1> {
+  int64_t id;
+  string symbol;
+  Side side;
+
+  OrderV1() : id(0), side(Side::buy) {}
+
+  template<class C> void enhance(C& c) const{
+    c(tag<1>(&OrderV1::id), tag<2>(&OrderV1::symbol), tag<3>(&OrderV1::side));
+  }
+};
+
+// a later version: new fields and another order of the accessors
+struct OrderV2 : TaggedSerializable<OrderV2>, EqualComparable<OrderV2> {
+  int64_t id;
+  double limit;
+  string symbol;
+  Side side;
+  std::vector<Fill> fills;
+  Fill last;
+
+  OrderV2() : id(0), limit(0), side(Side::buy) {}
+
+  template<class C> void enhance(C& c) const{
+    c(tag<1>(&OrderV2::id), tag<4>(&OrderV2::limit), tag<2>(&OrderV2::symbol),
+      tag<3>(&OrderV2::side), tag<5>(&OrderV2::fills), tag<6>(&OrderV2::last));
+  }
+};
+
+// the field with tag 1 changed its type
+struct OrderV3 : EqualComparable<OrderV3> {
+  double id;
+
+  OrderV3() : id(0) {}
+
+  template<class C> void enhance(C& c) const{
+    c(tag<1>(&OrderV3::id));
+  }
+};
+
+TEST_CASE( "tagged serialization" ) {
+  OrderV1 v1;
+  v1.id = 7;
+  v1.symbol = "ab";
+  v1.side = Side::sell;
+
+  CompactWriter w1;
+  saveTagged(v1, w1);
+  // length, then key and value of every field (the string has its
+  // own size in front)
+  REQUIRE( w1.size() == 1 + (1 + 1) + (1 + 1 + 1 + 2) + (1 + 1) );
+  OrderV1 back1;
+  CompactReader r1(w1.buffer());
+  loadTagged(back1, r1);
+  REQUIRE( back1 == v1 );
+  REQUIRE( r1.remaining() == 0 );
+
+  OrderV2 v2;
+  v2.id = -3;
+  v2.limit = 101.5;
+  v2.symbol = "xyz";
+  v2.side = Side::sell;
+  v2.fills = {Fill(10, 101.25), Fill(5, 101.5)};
+  v2.last = Fill(5, 101.5);
+
+  // `TaggedSerializable` and both encodings
+  CompactWriter w2;
+  w2 << v2 << v1;
+  OrderV2 back2;
+  CompactReader r2(w2.buffer());
+  r2 >> back2;
+  REQUIRE( back2 == v2 );
+
+  BinaryWriter b2;
+  b2 << v2;
+  OrderV2 backb;
+  BinaryReader rb(b2.buffer());
+  rb >> backb;
+  REQUIRE( backb == v2 );
+
+  // payloads of 128 bytes and more have longer length prefixes
+  OrderV2 longer = v2;
+  longer.symbol = string(300, 's');
+  longer.fills.resize(40, Fill(1, 2));
+  CompactWriter wl;
+  wl << longer;
+  CompactReader rl(wl.buffer());
+  rl >> back2;
+  REQUIRE( back2 == longer );
+  REQUIRE( rl.remaining() == 0 );
+
+  // old readers skip the new fields
+  OrderV1 old;
+  CompactReader r3(w2.buffer());
+  r3 >> old;
+  REQUIRE( old.id == v2.id );
+  REQUIRE( old.symbol == v2.symbol );
+  REQUIRE( old.side == v2.side );
+  // and the next value is read correctly
+  r3 >> back1;
+  REQUIRE( back1 == v1 );
+  REQUIRE( r3.remaining() == 0 );
+
+  // new readers keep the values of missing fields
+  OrderV2 fresh;
+  CompactReader r4(w1.buffer());
+  r4 >> fresh;
+  REQUIRE( fresh.id == v1.id );
+  REQUIRE( fresh.symbol == v1.symbol );
+  REQUIRE( fresh.limit == 0 );
+  REQUIRE( fresh.fills.empty() );
+
+  // fields of another wire type and corrupt data
+  OrderV3 v3;
+  CompactReader r5(w1.buffer());
+  REQUIRE_THROWS_AS( loadTagged(v3, r5), const std::runtime_error& );
+
+  CompactReader truncated(w2.data(), w2.size() - w1.size() - 1);
+  REQUIRE_THROWS_AS( truncated >> back2, const std::runtime_error& );
+
+  std::vector<char> unknownWire = {2, char(1 << 3 | 7), 0};
+  CompactReader r6(unknownWire);
+  REQUIRE_THROWS_AS( loadTagged(v1, r6), const std::runtime_error& );
+}
+
+template<class Writer, class Value>
+size_t savedSize(const Value& x){
+  Writer w;
+  w << x;
+  return w.size();
+}
+
+TEST_CASE( "serialized size" ) {
+  Counters c{};
+  c.hits = 300;
+  c.delta = -70000;
+  c.side = Side::sell;
+  c.samples = {1, -1, 1000000, 0};
+  REQUIRE( serializedSize<BinaryWriter>(c) == savedSize<BinaryWriter>(c) );
+  REQUIRE( serializedSize<CompactWriter>(c) == savedSize<CompactWriter>(c) );
+  SerializedSize<CompactWriter, const Counters> sizer(c);
+  REQUIRE( sizer.callEnhance() == savedSize<CompactWriter>(c) );
+
+  // ranges, nested classes, strings and vectors of classes
+  Snapshot s;
+  s.owner = "desk";
+  s.history = {5, 6};
+  std::vector<Snapshot> snapshots(3, s);
+  REQUIRE( serializedSize<BinaryWriter>(s) == savedSize<BinaryWriter>(s) );
+  REQUIRE( serializedSize<CompactWriter>(snapshots) == savedSize<CompactWriter>(snapshots) );
+
+  // tagged messages, with payloads of 128 bytes and more
+  OrderV2 o;
+  o.id = 12345;
+  o.symbol = string(200, 'x');
+  o.fills = {Fill(1, 2.5), Fill(-3, 4)};
+  REQUIRE( serializedSize<CompactWriter>(o) == savedSize<CompactWriter>(o) );
+  REQUIRE( serializedSize<BinaryWriter>(o) == savedSize<BinaryWriter>(o) );
+
+  // tagged messages of numbers only are not of a fixed size
+  std::vector<Fill> fills(10, Fill(7, 1.5));
+  REQUIRE( (FixedSerializedSize<BinaryWriter, Fill>::get(fills[0])) == 0 );
+  REQUIRE( serializedSize<BinaryWriter>(fills.begin(), fills.end()) ==
+           10 * serializedSize<BinaryWriter>(fills[0]) );
+  REQUIRE( serializedSize<BinaryWriter>(fills) == savedSize<BinaryWriter>(fills) );
+
+  // objects of a fixed size
+  const Window window(1, 2);
+  REQUIRE( (FixedSerializedSize<BinaryWriter, Window>::get(window)) == 8 );
+  REQUIRE( (FixedSerializedSize<CompactWriter, Window>::get(window)) == 0 );
+  REQUIRE( (FixedSerializedSize<BinaryWriter, Snapshot>::get(s)) == 0 );
+
+  std::vector<Window> windows(10, window);
+  REQUIRE( serializedSize<BinaryWriter>(windows.begin(), windows.end()) == 80 );
+  REQUIRE( serializedSize<CompactWriter>(snapshots.begin(), snapshots.end()) ==
+           savedSize<CompactWriter>(snapshots) - 1 );
+
+  // a single allocation
+  BinaryWriter w;
+  w.reserve(serializedSize<BinaryWriter>(snapshots));
+  const char* data = w.data();
+  w << snapshots;
+  REQUIRE( w.data() == data );
+
+  // saving into bytes of the caller, which have to suffice
+  std::vector<char> bytes(w.size());
+  BinaryWriter in(bytes.data(), bytes.size());
+  in << snapshots;
+  REQUIRE( in.data() == bytes.data() );
+  REQUIRE( bytes == w.buffer() );
+  REQUIRE_THROWS_AS( in << char(0), const std::length_error& );
+}
+
+// saves no bytes
+struct Marker {
+  template<class C> void enhance(C& c) const{
+    c();
+  }
+};
+
+TEST_CASE( "chunked serialization" ) {
+  std::vector<Sample> samples(1000);
+  for(size_t i = 0; i < samples.size(); ++i){
+    samples[i].id = int32_t(i);
+    samples[i].kind = -int32_t(i % 7);
+    samples[i].name = "s" + std::to_string(i);
+    samples[i].values.assign(i % 5, float(i));
+    samples[i].position = {{int16_t(i), 0, -1}};
+  }
+
+  // frames of 64 objects, decoded with another number of threads
+  std::vector<char> bytes = saveChunked(samples, 4, 64);
+  std::vector<Sample> back;
+  loadChunked(bytes, back, 3);
+  REQUIRE( back == samples );
+
+  std::vector<char> compact = saveChunked<CompactWriter>(samples, 2, 100);
+  REQUIRE( compact.size() < bytes.size() );
+  loadChunked<CompactReader>(compact, back);
+  REQUIRE( back == samples );
+
+  // the frames are the objects saved back to back
+  BinaryWriter w;
+  for(size_t i = 64; i < 128; ++i)
+    w << samples[i];
+  chunked::Frame second;
+  std::memcpy(&second, &bytes[sizeof(chunked::Header) + sizeof(second)], sizeof(second));
+  REQUIRE( second.first == 64 );
+  REQUIRE( second.count == 64 );
+  REQUIRE( std::vector<char>(&bytes[second.offset], &bytes[second.offset] + second.length) ==
+           w.buffer() );
+
+  std::vector<Sample> none;
+  loadChunked(saveChunked(none), back);
+  REQUIRE( back.empty() );
+
+  // invalid headers and frames
+  std::vector<char> truncated(bytes.begin(), bytes.end() - 1);
+  REQUIRE_THROWS_AS( loadChunked(truncated, back, 4), const std::runtime_error& );
+  // a frame, that ends early
+  std::vector<char> corrupt = bytes;
+  second.length -= 1;
+  std::memcpy(&corrupt[sizeof(chunked::Header) + sizeof(second)], &second, sizeof(second));
+  REQUIRE_THROWS_AS( loadChunked(corrupt, back, 4), const std::runtime_error& );
+  std::vector<char> other = bytes;
+  other[0] = 'X';
+  REQUIRE_THROWS_AS( loadChunked(other, back), const std::runtime_error& );
+  // a corrupt number of objects fails on the missing data, instead of
+  // allocating that many
+  std::vector<char> huge = bytes;
+  chunked::Header h;
+  std::memcpy(&h, huge.data(), sizeof(h));
+  chunked::Frame last;
+  const size_t lastAt = sizeof(h) + size_t(h.frames - 1) * sizeof(last);
+  std::memcpy(&last, &huge[lastAt], sizeof(last));
+  h.count = uint64_t(1) << 50;
+  last.count = h.count - last.first;
+  std::memcpy(huge.data(), &h, sizeof(h));
+  std::memcpy(&huge[lastAt], &last, sizeof(last));
+  REQUIRE_THROWS_AS( loadChunked(huge, back), const std::runtime_error& );
+
+  // tagged messages, whose lengths are inserted in front of them
+  std::vector<OrderV2> orders(300);
+  for(size_t i = 0; i < orders.size(); ++i){
+    orders[i].id = int64_t(i);
+    orders[i].symbol = string(i % 150, 'x');
+    orders[i].fills.assign(i % 3, Fill(int(i), 0.5));
+  }
+  std::vector<OrderV2> loadedOrders;
+  loadChunked<CompactReader>(saveChunked<CompactWriter>(orders, 3, 7), loadedOrders);
+  REQUIRE( loadedOrders == orders );
+
+  // tagged messages of numbers only
+  std::vector<Fill> fills;
+  for(int i = 0; i < 10; ++i)
+    fills.push_back(Fill(i, i * 0.5));
+  std::vector<Fill> loadedFills;
+  loadChunked(saveChunked(fills, 2, 4), loadedFills);
+  REQUIRE( loadedFills == fills );
+
+  // objects without bytes: more than the data has bytes, in frames of
+  // 1000 objects and in one large frame
+  std::vector<Marker> markers(200000), loaded;
+  for(size_t records : {size_t(1000), markers.size()}){
+    std::vector<char> empty = saveChunked(markers, 2, records);
+    REQUIRE( empty.size() < markers.size() );
+    loadChunked(empty, loaded, 2);
+    REQUIRE( loaded.size() == markers.size() );
+  }
+}
+
+struct Note : EqualComparable<Note>, Serializable<Note> {
+  int64_t time;
+  ArenaString text;
+  ArenaVector<int32_t> values;
+  ArenaVector<ArenaString> tags;
+
+  template<class C> void enhance(C& c) const{
+    c(&Note::time, &Note::text, &Note::values, &Note::tags);
+  }
+};
+
+// the same on the heap
+struct HeapNote : Serializable<HeapNote> {
+  int64_t time;
+  string text;
+  std::vector<int32_t> values;
+  std::vector<string> tags;
+
+  template<class C> void enhance(C& c) const{
+    c(&HeapNote::time, &HeapNote::text, &HeapNote::values, &HeapNote::tags);
+  }
+};
+
+TEST_CASE( "arena loading" ) {
+  std::vector<HeapNote> heap(50);
+  ArenaVector<Note> notes(50);
+  for(size_t i = 0; i < heap.size(); ++i){
+    heap[i].time = notes[i].time = int64_t(i) << 40;
+    heap[i].text = string(i, 'a');
+    notes[i].text.assign(i, 'a');
+    heap[i].values.assign(i % 4, int32_t(i));
+    notes[i].values.assign(i % 4, int32_t(i));
+    heap[i].tags.assign(i % 3, "tag");
+    notes[i].tags.assign(i % 3, ArenaString("tag"));
+  }
+
+  // the same bytes as with standard containers
+  BinaryWriter w;
+  w << notes;
+  BinaryWriter hw;
+  hw << heap;
+  REQUIRE( w.buffer() == hw.buffer() );
+
+  // everything is allocated in the arena
+  Arena arena(256);
+  ArenaVector<Note> back;
+  BinaryReader r(w.buffer());
+  r.useArena(&arena);
+  r >> back;
+  REQUIRE( back == notes );
+  REQUIRE( back.get_allocator().arena() == &arena );
+  REQUIRE( back[49].text.get_allocator().arena() == &arena );
+  REQUIRE( back[49].values.get_allocator().arena() == &arena );
+  REQUIRE( back[2].tags[1].get_allocator().arena() == &arena );
+  REQUIRE( arena.size() >= 50 * sizeof(Note) );
+
+  // reused for the next batch after the objects are gone
+  const size_t used = arena.size();
+  back = ArenaVector<Note>();
+  arena.reset();
+  REQUIRE( arena.size() == 0 );
+  BinaryReader again(w.buffer());
+  again.useArena(&arena);
+  again >> back;
+  REQUIRE( back == notes );
+  REQUIRE( arena.size() == used );
+
+  // allocations are aligned
+  REQUIRE( reinterpret_cast<uintptr_t>(arena.allocate(3, 1)) != 0 );
+  REQUIRE( reinterpret_cast<uintptr_t>(arena.allocate(8, 64)) % 64 == 0 );
+  REQUIRE( reinterpret_cast<uintptr_t>(arena.allocate(1 << 20)) % alignof(std::max_align_t) == 0 );
+
+  // reset keeps the largest block, even if a smaller one follows it
+  Arena blocks(256);
+  void* large = blocks.allocate(1 << 20);
+  blocks.allocate(1 << 12);
+  blocks.allocate(200);
+  blocks.reset();
+  REQUIRE( blocks.allocate(200) == large );
+
+  // without an arena, containers use the heap
+  ArenaVector<Note> plain;
+  BinaryReader(w.buffer()) >> plain;
+  REQUIRE( plain == notes );
+  REQUIRE( plain[1].text.get_allocator().arena() == nullptr );
+  back = ArenaVector<Note>();
+  arena.release();
+  REQUIRE( arena.size() == 0 );
+}
+
+struct Level {
+  double price;
+  int32_t size;
+
+  template<class C> void enhance(C& c) const{
+    c(&Level::price, &Level::size);
+  }
+};
+
+struct Quote {
+  int64_t time;
+  Side side;
+  string symbol;
+  Level best;
+  std::vector<double> prices;
+  int unlisted;
+
+  template<class C> void enhance(C& c) const{
+    c(&Quote::time, &Quote::side, &Quote::symbol, &Quote::best, &Quote::prices);
+  }
+};
+
+TEST_CASE( "flat buffer view" ) {
+  Quote q{1234567, Side::sell, "ACME", Level{10.5, 300}, {1.0, 2.5, -3.0}, 0};
+  std::vector<char> buffer = toFlat(q);
+  // time, side, symbol slot, best, prices slot; then the contents
+  REQUIRE( FlatLayout<Quote>::get().fixedSize == 8 + 1 + 8 + (8 + 4) + 8 );
+  REQUIRE( buffer.size() == 37 + 4 + 3 * 8 );
+
+  View<Quote> v = flatView<Quote>(buffer);
+  REQUIRE( v.get(&Quote::time) == 1234567 );
+  REQUIRE( v.get(&Quote::side) == Side::sell );
+  REQUIRE( v.get(&Quote::symbol) == "ACME" );
+  REQUIRE( v.get(&Quote::symbol).str() == "ACME" );
+  REQUIRE( v.get(&Quote::best).get(&Level::price) == 10.5 );
+  REQUIRE( v.get(&Quote::best).get(&Level::size) == 300 );
+  FlatArray<double> prices = v.get(&Quote::prices);
+  REQUIRE( prices.size() == 3 );
+  REQUIRE( prices[1] == 2.5 );
+  REQUIRE( prices.vector() == q.prices );
+  REQUIRE_THROWS_AS( v.get(&Quote::unlisted), const std::invalid_argument& );
+
+  // the buffer needs no alignment
+  std::vector<char> shifted(1);
+  shifted.insert(shifted.end(), buffer.begin(), buffer.end());
+  REQUIRE( View<Quote>(shifted.data() + 1, buffer.size()).get(&Quote::best)
+           .get(&Level::size) == 300 );
+
+  // empty strings and vectors
+  Quote e{};
+  REQUIRE( flatView<Quote>(toFlat(e)).get(&Quote::symbol).empty() );
+
+  REQUIRE_FALSE( View<Quote>(buffer.data(), 36).valid() );
+  REQUIRE_FALSE( View<Quote>(buffer.data(), buffer.size() - 1).valid() );
+  REQUIRE_THROWS_AS( flatView<Quote>(buffer.data(), buffer.size() - 1),
+                     const std::runtime_error& );
+  // a corrupt offset of the symbol
+  buffer[9] = char(0xff);
+  REQUIRE_FALSE( View<Quote>(buffer).valid() );
+}
+
+TEST_CASE( "mapped record file" ) {
+  std::vector<Quote> quotes;
+  for(int i = 0; i < 100; ++i)
+    quotes.push_back(Quote{i, Side(i % 2), string(size_t(i % 7), 'x'),
+                           Level{i / 4.0, i}, std::vector<double>(size_t(i % 3), i), 0});
+  const string path = "mapped_record_file.tmp";
+
+  // strings and vectors, indexed records
+  MappedRecordFile<Quote>::write(path, quotes);
+  {
+    MappedRecordFile<Quote> file(path);
+    REQUIRE( file.size() == quotes.size() );
+    REQUIRE( file.valid() );
+    REQUIRE( file.view(42).get(&Quote::best).get(&Level::size) == 42 );
+    REQUIRE( file.view(13).get(&Quote::symbol) == "xxxxxx" );
+    for(size_t i = 0; i < quotes.size(); ++i){
+      Quote q = file[i];
+      REQUIRE( q.time == quotes[i].time );
+      REQUIRE( q.symbol == quotes[i].symbol );
+      REQUIRE( q.best.price == quotes[i].best.price );
+      REQUIRE( q.prices == quotes[i].prices );
+    }
+    REQUIRE_THROWS_AS( MappedRecordFile<Level> wrong(path), const std::runtime_error& );
+  }
+
+  // fixed stride
+  std::vector<Level> levels{{1.5, 1}, {2.5, 2}, {3.5, 3}};
+  MappedRecordFile<Level>::write(path, levels);
+  {
+    MappedRecordFile<Level> file(path);
+    REQUIRE( file.size() == 3 );
+    REQUIRE( file.valid() );
+    REQUIRE( file.view(2).get(&Level::price) == 3.5 );
+    REQUIRE( file[1].size == 2 );
+  }
+
+  std::remove(path.c_str());
+  REQUIRE_THROWS_AS( MappedRecordFile<Level> missing(path), const std::runtime_error& );
+}
+
+TEST_CASE( "columnar serialization" ) {
+  std::vector<Quote> quotes;
+  for(int i = 0; i < 50; ++i)
+    quotes.push_back(Quote{i * 10, Side(i % 2), string(size_t(i % 5), 'a' + char(i % 26)),
+                           Level{i / 2.0, -i}, std::vector<double>(size_t(i % 4), i), 0});
+  std::vector<char> bytes = toColumns(quotes);
+  ColumnReader<Quote> reader(bytes);
+  REQUIRE( reader.size() == 50 );
+
+  // fixed width columns are contiguous and aligned
+  ColumnView<int64_t> times = reader.column(&Quote::time);
+  REQUIRE( (times.data() - bytes.data()) % 8 == 0 );
+  REQUIRE( reinterpret_cast<const int64_t*>(times.data())[7] == 70 );
+  REQUIRE( times[49] == 490 );
+  REQUIRE( reader.column(&Quote::side)[3] == Side::sell );
+  REQUIRE( reader.column(&Quote::symbol)[6] == "g" );
+  REQUIRE( reader.column(&Quote::prices)[3].size() == 3 );
+  REQUIRE( reader.column(&Quote::best)[8].get(&Level::size) == -8 );
+  REQUIRE( reader.loadColumn(&Quote::symbol)[9] == "jjjj" );
+  REQUIRE_THROWS_AS( reader.column(&Quote::unlisted), const std::invalid_argument& );
+
+  // only the requested columns
+  std::vector<Quote> partial = reader.load(&Quote::time, &Quote::prices);
+  REQUIRE( partial[5].time == 50 );
+  REQUIRE( partial[5].prices == quotes[5].prices );
+  REQUIRE( partial[5].symbol.empty() );
+  REQUIRE( partial[5].best.size == 0 );
+
+  std::vector<Quote> all = reader.loadAll();
+  for(size_t i = 0; i < quotes.size(); ++i){
+    REQUIRE( all[i].symbol == quotes[i].symbol );
+    REQUIRE( all[i].best.price == quotes[i].best.price );
+    REQUIRE( all[i].prices == quotes[i].prices );
+  }
+
+  const string path = "columns.tmp";
+  writeColumns(path, quotes);
+  {
+    ColumnFile<Quote> file(path);
+    REQUIRE( file.column(&Quote::best)[20].get(&Level::price) == 10 );
+  }
+  std::remove(path.c_str());
+
+  REQUIRE_THROWS_AS( ColumnReader<Level> wrong(bytes), const std::runtime_error& );
+  REQUIRE_THROWS_AS( ColumnReader<Quote>(bytes.data(), 100), const std::runtime_error& );
+  // a corrupt offset of the symbols
+  std::vector<char> corrupt = bytes;
+  const size_t symbols = 24 + 2 * 24;
+  uint64_t offset;
+  std::memcpy(&offset, &corrupt[symbols], 8);
+  corrupt[size_t(offset) + 8 * 10 + 7] = char(0x7f);
+  ColumnReader<Quote> damaged(corrupt);
+  REQUIRE( damaged.column(&Quote::time)[1] == 10 );
+  REQUIRE_THROWS_AS( damaged.column(&Quote::symbol), const std::runtime_error& );
+}
+
 struct K : LessPWComparable<K>, GreaterPWComparable<K> {
   int i;
   int* j;
@@ -590,3 +1580,1036 @@ TEST_CASE( "hash" ) {
   REQUIRE( hash(p1) != hash(p3) );
   REQUIRE( hash(p1)(&Person::name) == hash(p3)(&Person::name) );
 }
+
+TEST_CASE( "batch hashing" ) {
+  std::mt19937 rng(5);
+  std::vector<Person> people;
+  for(int i = 0; i < 21; ++i)
+    people.push_back(Person{"p" + std::to_string(rng() % 7), uint(rng() % 3)});
+  std::vector<size_t> h;
+  hashMany(people, h);
+  REQUIRE( h.size() == people.size() );
+  for(size_t i = 0; i < people.size(); ++i)
+    REQUIRE( h[i] == hash(people[i]) );
+
+  // through the specialized `enhance(Hash<U>&)`
+  std::vector<U> us;
+  for(int i = 0; i < 3; ++i)
+    us.push_back(U(i, 2 * i));
+  hashMany(us, h);
+  for(size_t i = 0; i < us.size(); ++i)
+    REQUIRE( h[i] == hash(us[i]) );
+
+  hashMany(people.data(), 0, h.data());
+}
+
+struct Document : CachedHashable<Document> {
+  string title;
+  std::vector<string> lines;
+
+  Document(string title, std::vector<string> lines): title(title), lines(lines) {}
+
+  template<class C> void enhance(C& c) const{
+    c(&Document::title, container(&Document::lines));
+  }
+};
+
+ENHANCE_STD_HASH(Document)
+
+TEST_CASE( "cached hash" ) {
+  Document d1{"a", {"x", "y"}}, d2{"a", {"x", "y"}}, d3{"a", {"x", "z"}};
+
+  REQUIRE( d1.hashValue() == hash(d1) );
+  REQUIRE( std::hash<Document>()(d1) == hash(d2) );
+  REQUIRE( d1 == d2 );
+  REQUIRE_FALSE( d1 == d3 );
+
+  std::unordered_set<Document> set{d1, d2, d3};
+  REQUIRE( set.size() == 2 );
+  REQUIRE( set.count(Document{"a", {"x", "z"}}) == 1 );
+
+  // copies keep the cached hash
+  Document d4 = d3;
+  d3.lines[1] = "y";
+  REQUIRE( std::hash<Document>()(d3) == hash(d4) );
+  REQUIRE_FALSE( d3 == d1 );
+  // `Equal` compares the (stale) hashes first, explicit accessor
+  // lists only the members
+  REQUIRE( equal(d3, d1) == false );
+  REQUIRE_FALSE( Equal<Document>::Functor()(d3, d1) );
+  REQUIRE( equal(d3, d1)(&Document::title, container(&Document::lines)) == true );
+
+  d3.invalidateHash();
+  REQUIRE( std::hash<Document>()(d3) == hash(d1) );
+  REQUIRE( d3 == d1 );
+}
+
+struct Order : EqualComparable<Order> {
+  long id;
+  double price;
+  int quantity;
+  string trader;
+  std::vector<int> fills;
+
+  Order(long id, double price, int quantity, string trader, std::vector<int> fills)
+    : id(id), price(price), quantity(quantity), trader(trader), fills(fills) {}
+
+  template<class C> void enhance(C& c) const{
+    c(&Order::id, &Order::price, &Order::quantity, &Order::trader,
+      container(&Order::fills));
+  }
+};
+
+struct Halves {
+  std::vector<int> left, right;
+
+  Halves(std::vector<int> left, std::vector<int> right): left(left), right(right) {}
+
+  template<class C> void enhance(C& c) const{
+    c(container(&Halves::left), container(&Halves::right));
+  }
+};
+
+TEST_CASE( "incremental hash" ) {
+  Order o{1, 10.5, 3, "ann", {1, 2}};
+  size_t h = incrementalHash(o);
+
+  REQUIRE( h == incrementalHash(Order{1, 10.5, 3, "ann", {1, 2}}) );
+  REQUIRE( h != incrementalHash(Order{1, 10.5, 3, "ann", {2, 1}}) );
+  REQUIRE( incrementalHash(Order{3, 10.5, 1, "ann", {}}) !=
+           incrementalHash(Order{1, 10.5, 3, "ann", {}}) );
+
+  double price = o.price;
+  o.price = 11;
+  h = updateHash(o, h, &Order::price, price);
+  REQUIRE( h == incrementalHash(o) );
+
+  string trader = o.trader;
+  o.trader = "bob";
+  h = updateHash(o, h, &Order::trader, trader);
+  REQUIRE( h == incrementalHash(o) );
+
+  int quantity = o.quantity;
+  o.quantity = 0;
+  o.fills.push_back(3);
+  h = updateHash(o, h, &Order::quantity, quantity);
+  REQUIRE( h != incrementalHash(o) );
+
+  std::unordered_set<Order, IncrementalHash<const Order>::Functor> orders{o, o};
+  REQUIRE( orders.size() == 1 );
+
+  // elements, that move from one range to the next
+  REQUIRE( incrementalHash(Halves({1, 2, 3}, {4})) !=
+           incrementalHash(Halves({1, 2}, {3, 4})) );
+  REQUIRE( incrementalHash(Halves({}, {5})) != incrementalHash(Halves({5}, {})) );
+  REQUIRE( incrementalHash(Halves({1}, {2})) == incrementalHash(Halves({1}, {2})) );
+}
+
+struct Name : ThreeWayComparable<Name>, LessComparable<Name> {
+  string first, last;
+
+  Name(string first, string last): first(first), last(last) {}
+
+  template<class C> void enhance(C& c) const{
+    c(&Name::last, &Name::first);
+  }
+};
+
+struct Entry : ThreeWayComparable<Entry>,
+               LessEqualComparable<Entry>,
+               GreaterEqualComparable<Entry> {
+  Name name;
+  double score;
+
+  Entry(Name name, double score): name(name), score(score) {}
+
+  template<class C> void enhance(C& c) const{
+    c(&Entry::name, &Entry::score);
+  }
+};
+
+struct Pixel {
+  int x, y;
+  float value;
+  std::vector<int> tags;
+
+  template<class C> void enhance(C& c) const{
+    c(&Pixel::x, &Pixel::y, &Pixel::value, &Pixel::tags);
+  }
+};
+
+// padding-free, so hashed by its bytes
+struct GridPoint {
+  int32_t row, column;
+
+  template<class C> void enhance(C& c) const{
+    c(&GridPoint::row, &GridPoint::column);
+  }
+};
+
+namespace enhance {
+  template<>
+  struct IsBitwiseComparable<GridPoint> : std::true_type {};
+}
+
+template<class H>
+uint64_t hashBytesWith(const string& s, size_t chunk){
+  H h;
+  for(size_t i = 0; i < s.size(); i += chunk)
+    h(s.data() + i, std::min(chunk, s.size() - i));
+  return uint64_t(typename H::result_type(h));
+}
+
+TEST_CASE( "streaming hash" ) {
+  // reference values of XXH64 with seed 0
+  REQUIRE( hashBytesWith<XXH64>("", 1) == 0xef46db3751d8e999ULL );
+  REQUIRE( hashBytesWith<XXH64>("abc", 1) == 0x44bc2cf5ad770999ULL );
+  REQUIRE( hashBytesWith<XXH64>("Nobody inspects the spammish repetition", 5)
+           == 0xfbcea83c8a378bf1ULL );
+
+  // independent of how the bytes are split
+  string s;
+  for(int i = 0; i < 300; ++i)
+    s += char(i * 37);
+  for(size_t chunk : {1, 3, 8, 16, 17, 32, 100})
+    REQUIRE( hashBytesWith<XXH64>(s, chunk) == hashBytesWith<XXH64>(s, 300) );
+
+  // all lengths of short pieces are distinguished
+  std::set<uint64_t> pieces;
+  for(size_t n = 0; n <= 40; ++n)
+    pieces.insert(hashBytesWith<WyHash>(string(n, '\0'), 40));
+  REQUIRE( pieces.size() == 41 );
+
+  typedef Hash<Person, std::hash, Streaming<WyHash> > PersonHash;
+  Person p1{"Frank", 21}, p2{"Frank", 21}, p3{"Frank", 22};
+  REQUIRE( PersonHash(p1) == PersonHash(p2) );
+  REQUIRE( size_t(PersonHash(p1)) != size_t(PersonHash(p3)) );
+  REQUIRE( PersonHash(p1)(&Person::name) == PersonHash(p3)(&Person::name) );
+  REQUIRE( size_t(hash<Person, std::hash, Streaming<WyHash> >(p1)) ==
+           size_t(PersonHash(p1)) );
+
+  // every value feeds the same hasher, strings are followed by their size
+  XXH64 h;
+  hashAppend(h, string("Frank"));
+  hashAppend(h, 21u);
+  REQUIRE( size_t(Hash<Person, std::hash, Streaming<XXH64> >(p1)) ==
+           size_t(uint64_t(h)) );
+  typedef Hash<Name, std::hash, Streaming<XXH64> > NameHash;
+  REQUIRE( NameHash(Name("ab", "c")) != NameHash(Name("a", "bc")) );
+
+  // adjacent members, -0.0, vectors and nested classes
+  Pixel a{1, 2, 0.0f, {3, 4}}, b{1, 2, -0.0f, {3, 4}}, c{1, 2, 0.0f, {3}};
+  typedef Hash<Pixel, std::hash, Streaming<XXH64> > PixelHash;
+  REQUIRE( PixelHash(a) == PixelHash(b) );
+  REQUIRE( size_t(PixelHash(a)) != size_t(PixelHash(c)) );
+  XXH64 g;
+  hashAppend(g, 1);
+  hashAppend(g, 2);
+  hashAppend(g, 0.0f);
+  hashAppend(g, a.tags);
+  REQUIRE( size_t(PixelHash(a)) == size_t(uint64_t(g)) );
+
+  Entry e1(Name("a", "b"), 1), e2(Name("a", "b"), 1), e3(Name("a", "c"), 1);
+  typedef Hash<Entry, std::hash, Streaming<WyHash> > EntryHash;
+  REQUIRE( EntryHash(e1) == EntryHash(e2) );
+  REQUIRE( size_t(EntryHash(e1)) != size_t(EntryHash(e3)) );
+
+  // ranges are followed by their length
+  Vector v;
+  XXH64 r;
+  hashAppend(r, 4);
+  hashAppend(r, 9);
+  hashAppend(r, 2);
+  hashAppend(r, size_t(3));
+  REQUIRE( size_t(Hash<Vector, std::hash, Streaming<XXH64> >(v)) ==
+           size_t(uint64_t(r)) );
+
+  std::unordered_set<Person, PersonHash::Functor> set{p1, p2, p3};
+  REQUIRE( set.size() == 2 );
+
+  // enhanced classes, that are bitwise comparable
+  GridPoint cell{3, -4};
+  XXH64 byBytes, byHashAppend;
+  byBytes(&cell, sizeof(cell));
+  hashAppend(byHashAppend, cell);
+  REQUIRE( uint64_t(byBytes) == uint64_t(byHashAppend) );
+  // canonical hashers still hash them member by member
+  REQUIRE( uint64_t(stableHash(cell)) == uint64_t(stableHash(GridPoint{3, -4})) );
+}
+
+enum class Unit : char { celsius, kelvin };
+
+struct Reading {
+  int32_t sensor;
+  Unit unit;
+  double value;
+  string location;
+  std::vector<short> samples;
+
+  template<class C> void enhance(C& c) const{
+    c(&Reading::sensor, &Reading::unit, &Reading::value, &Reading::location,
+      container(&Reading::samples));
+  }
+};
+
+struct Series {
+  Reading first;
+  std::vector<uint64_t> times;
+
+  template<class C> void enhance(C& c) const{
+    c(&Series::first, &Series::times);
+  }
+};
+
+struct Widths {
+  int32_t a;
+  int64_t b;
+};
+
+struct Characters {
+  char c;
+  signed char s;
+  int32_t i;
+  wchar_t w;
+  uint32_t u;
+};
+
+TEST_CASE( "stable hash" ) {
+  Reading r{-7, Unit::kelvin, 21.5, "lab", {1, -2, 3}};
+
+  // XXH64 of the canonical bytes
+  string bytes;
+  auto append = [&](uint64_t v){
+    for(int i = 0; i < 8; ++i)
+      bytes += char(v >> (8 * i));
+  };
+  append(uint64_t(-7));
+  append(1);
+  double value = 21.5;
+  uint64_t bits;
+  std::memcpy(&bits, &value, 8);
+  append(bits);
+  append(3);
+  bytes += "lab";
+  append(1);
+  append(uint64_t(-2));
+  append(3);
+  append(3);
+  REQUIRE( uint64_t(stableHash(r)) == hashBytesWith<XXH64>(bytes, bytes.size()) );
+
+  // golden values
+  REQUIRE( uint64_t(stableHash(r)) == 0x2cea796f76d50062ULL );
+  REQUIRE( uint64_t(stableHash(Series{r, {1, 2}})) == 0x8f430abf3ea7f33eULL );
+  REQUIRE( uint64_t(StableHash<Reading, WyHash>(r)) == 0x2e1e3be166cde5deULL );
+
+  // equal values of different types, -0.0 and NaN
+  Reading zero{0, Unit::celsius, 0.0, "", {}}, negativeZero = zero;
+  negativeZero.value = -0.0;
+  REQUIRE( uint64_t(stableHash(zero)) == uint64_t(stableHash(negativeZero)) );
+  Reading nan1 = zero, nan2 = zero;
+  nan1.value = std::numeric_limits<double>::quiet_NaN();
+  nan2.value = -std::numeric_limits<double>::signaling_NaN();
+  REQUIRE( uint64_t(stableHash(nan1)) == uint64_t(stableHash(nan2)) );
+  Widths w{-3, -3};
+  REQUIRE( uint64_t(stableHash(w)(&Widths::a)) == uint64_t(stableHash(w)(&Widths::b)) );
+
+  // `char` is signed and `wchar_t` unsigned on every platform
+  Characters ch{char(-23), -23, -23, wchar_t(0x263a), 0x263a};
+  REQUIRE( uint64_t(stableHash(ch)(&Characters::c)) ==
+           uint64_t(stableHash(ch)(&Characters::s)) );
+  REQUIRE( uint64_t(stableHash(ch)(&Characters::c)) ==
+           uint64_t(stableHash(ch)(&Characters::i)) );
+  REQUIRE( uint64_t(stableHash(ch)(&Characters::w)) ==
+           uint64_t(stableHash(ch)(&Characters::u)) );
+}
+
+// only provides `compare`, so containers of it have to be compared
+// in a single pass
+struct Version {
+  int number;
+
+  int compare(const Version& o) const{
+    return threeWay(number, o.number);
+  }
+};
+
+struct Release : ThreeWayComparable<Release> {
+  std::vector<Version> versions;
+
+  Release(std::vector<Version> versions): versions(versions) {}
+
+  template<class C> void enhance(C& c) const{
+    c(&Release::versions);
+  }
+};
+
+// iterable, but ordered by its own `operator<` (shorter paths first)
+struct Path {
+  std::vector<int> steps;
+
+  std::vector<int>::const_iterator begin() const{ return steps.begin(); }
+  std::vector<int>::const_iterator end() const{ return steps.end(); }
+
+  bool operator==(const Path& o) const{ return steps == o.steps; }
+  bool operator<(const Path& o) const{
+    return steps.size() != o.steps.size() ? steps.size() < o.steps.size()
+      : steps < o.steps;
+  }
+};
+
+struct Route : ThreeWayComparable<Route>, LessComparable<Route> {
+  Path path;
+  int id;
+
+  Route(Path path, int id): path(path), id(id) {}
+
+  template<class C> void enhance(C& c) const{
+    c(&Route::path, &Route::id);
+  }
+};
+
+struct Observation : ThreeWayComparable<Observation>, LessComparable<Observation>,
+                     LessEqualComparable<Observation> {
+  double x;
+  int id;
+
+  Observation(double x, int id): x(x), id(id) {}
+
+  template<class C> void enhance(C& c) const{
+    c(&Observation::x, &Observation::id);
+  }
+};
+
+TEST_CASE( "three-way comparison" ) {
+  Name a{"Ada", "Lovelace"}, b{"Alan", "Turing"}, c{"Grace", "Hopper"};
+
+  REQUIRE( compare(a, a) == 0 );
+  REQUIRE( compare(a, b) < 0 );
+  REQUIRE( compare(b, a) > 0 );
+  REQUIRE( compare(a, c) > 0 );
+  REQUIRE( a.compare(b) < 0 );
+  REQUIRE( compare(a, b)(&Name::first) < 0 );
+  REQUIRE( c < a );
+  REQUIRE( less(c, a) == true );
+  REQUIRE( greater(a, c) == true );
+
+  Entry e1{a, 1.5}, e2{a, 2.5}, e3{c, 9};
+  REQUIRE( compare(e1, e2) < 0 );
+  REQUIRE( compare(e3, e1) < 0 );
+  REQUIRE( e1 <= e2 );
+  REQUIRE( e1 <= e1 );
+  REQUIRE( e2 >= e1 );
+  REQUIRE( !(e1 >= e2) );
+  REQUIRE( lessEqual(e3, e1) == true );
+  REQUIRE( greaterEqual(e1, e3) == true );
+
+  // containers
+  Release r1({{1}, {2}}), r2({{1}, {3}}), r3({{1}, {2}, {0}}), r4({});
+  REQUIRE( compare(r1, r1) == 0 );
+  REQUIRE( compare(r1, r2) < 0 );
+  REQUIRE( compare(r2, r3) > 0 );
+  REQUIRE( compare(r1, r3) < 0 );
+  REQUIRE( compare(r3, r1) > 0 );
+  REQUIRE( compare(r4, r1) < 0 );
+  REQUIRE( compare(r4, Release({})) == 0 );
+  std::vector<int> v1 = {1, -2}, v2 = {1, 2};
+  REQUIRE( threeWay(v1, v2) < 0 );
+  REQUIRE( threeWay(string("b"), string("ab")) > 0 );
+  std::array<int, 2> a1 = {{1, 2}}, a2 = {{1, 3}};
+  REQUIRE( threeWay(a1, a2) < 0 );
+
+  // other iterable classes are compared with their own `<`
+  Route long1(Path{{1, 1, 1}}, 0), short9(Path{{9}}, 0);
+  REQUIRE( short9 < long1 );
+  REQUIRE( compare(short9, long1) < 0 );
+
+  // NaNs: `compare` moves on, the comparison operators are false
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  Observation s1(nan, 1), s2(1.0, 2);
+  REQUIRE( compare(s1, s2) < 0 );
+  REQUIRE( !(s1 < s2) );
+  REQUIRE( !(s2 < s1) );
+  REQUIRE( !(s1 <= s2) );
+  REQUIRE( !less(s1, s1) );
+}
+
+struct Dense : EqualComparable<Dense> {
+  int a, b, c;
+  short d, e;
+
+  Dense(int a, int b, int c, short d, short e)
+    : a(a), b(b), c(c), d(d), e(e) {}
+
+  template<class C> void enhance(C& t) const{
+    t(&Dense::a, &Dense::b, &Dense::c, &Dense::d, &Dense::e);
+  }
+
+  ENHANCE_COPY_ASSIGMENT(const, Dense)
+};
+
+// padding between `c` and `i`, between `i` and `s` (probably), a
+// non-trivial member and floating point values (where -0.0 == 0.0)
+struct Padded : EqualComparable<Padded> {
+  char c;
+  int i;
+  string s;
+  double x;
+  short k;
+
+  template<class C> void enhance(C& t) const{
+    t(&Padded::c, &Padded::i, &Padded::s, &Padded::x, &Padded::k);
+  }
+};
+
+TEST_CASE( "runs of adjacent members" ) {
+  Dense d1(1, 2, 3, 4, 5), d2(d1);
+  REQUIRE( d1 == d2 );
+  REQUIRE( hash(d1) == hash(d2) );
+  for(int i = 0; i < 5; ++i){
+    Dense d3(d1);
+    switch(i){
+    case 0: d3.a = 9; break;
+    case 1: d3.b = 9; break;
+    case 2: d3.c = 9; break;
+    case 3: d3.d = 9; break;
+    case 4: d3.e = 9; break;
+    }
+    REQUIRE( !(d3 == d1) );
+    REQUIRE( hash(d3) != hash(d1) );
+    d3 = d1;
+    REQUIRE( d3 == d1 );
+  }
+  // only a subset of the members
+  Dense d4(1, 2, 7, 4, 7);
+  REQUIRE( equal(d1, d4)(&Dense::a, &Dense::b, &Dense::d) == true );
+  REQUIRE( equal(d1, d4)(&Dense::a, &Dense::b, &Dense::e) == false );
+  REQUIRE( hash(d1)(&Dense::a, &Dense::b) == hash(d4)(&Dense::a, &Dense::b) );
+
+  // objects with different garbage in their padding bytes
+  typename std::aligned_storage<sizeof(Padded), alignof(Padded)>::type b1, b2;
+  std::memset(&b1, 0x00, sizeof(b1));
+  std::memset(&b2, 0xff, sizeof(b2));
+  Padded& p1 = *new(&b1) Padded;
+  Padded& p2 = *new(&b2) Padded;
+  p1.c = p2.c = 'x';
+  p1.i = p2.i = 42;
+  p1.s = p2.s = "padding";
+  p1.x = 0.0;
+  p2.x = -0.0;
+  p1.k = p2.k = 7;
+
+  REQUIRE( p1 == p2 );
+  REQUIRE( hash(p1)(&Padded::c, &Padded::i, &Padded::s, &Padded::k)
+           == hash(p2)(&Padded::c, &Padded::i, &Padded::s, &Padded::k) );
+  p2.s = "Padding";
+  REQUIRE( !(p1 == p2) );
+  copy(p2, p1).callEnhance();
+  REQUIRE( p2.s == "padding" );
+  REQUIRE( p1 == p2 );
+  p2.i = 43;
+  REQUIRE( !(p1 == p2) );
+
+  p1.~Padded();
+  p2.~Padded();
+}
+
+struct Samples : EqualComparable<Samples>, Addible<Samples>,
+                 Subtractable<Samples>,
+                 ScalarMultiplicable<double, Samples>,
+                 ScalarDividable<double, Samples>,
+                 WithScalarProduct<double, Samples> {
+  vector<double> data;
+
+  template<class C> void enhance(C& c) const{
+    c(container(&Samples::data));
+  }
+};
+
+struct Counts : EqualComparable<Counts>, Addible<Counts>,
+                ScalarMultiplicable<int, Counts>,
+                WithScalarProduct<int, Counts> {
+  vector<int> data;
+  int raw[5];
+
+  template<class C> void enhance(C& c) const{
+    c(container(&Counts::data),
+      range(&Counts::raw, [](const Counts& x){ return x.raw + 5; }));
+  }
+};
+
+TEST_CASE( "vectorized ranges" ) {
+  // odd lengths to cover the element by element tails
+  for(size_t n : {0, 1, 3, 13, 64, 101}){
+    Samples a, b;
+    for(size_t i = 0; i < n; ++i){
+      a.data.push_back(0.5 * i);
+      b.data.push_back(2.0 + i);
+    }
+    Samples c(a);
+    REQUIRE( a == c );
+    if(n){
+      c.data[n - 1] = -1;
+      REQUIRE( !(a == c) );
+      c.data[n - 1] = a.data[n - 1];
+      c.data[0] = -0.0;
+      REQUIRE( a == c );
+    }
+
+    double dot = 0;
+    for(size_t i = 0; i < n; ++i)
+      dot += a.data[i] * b.data[i];
+    REQUIRE( (a * b) == Approx(dot) );
+
+    c += b;
+    for(size_t i = 0; i < n; ++i)
+      REQUIRE( c.data[i] == a.data[i] + b.data[i] );
+    c -= a;
+    REQUIRE( c == b );
+    c *= 4.0;
+    c /= 2.0;
+    for(size_t i = 0; i < n; ++i)
+      REQUIRE( c.data[i] == 2 * b.data[i] );
+  }
+
+  Samples nan;
+  nan.data.assign(9, 1.0);
+  nan.data[8] = std::numeric_limits<double>::quiet_NaN();
+  REQUIRE( !(nan == nan) );
+
+  Counts x, y;
+  for(int i = 0; i < 21; ++i){
+    x.data.push_back(i);
+    y.data.push_back(100 - i);
+  }
+  for(int i = 0; i < 5; ++i){
+    x.raw[i] = i;
+    y.raw[i] = 1;
+  }
+  int dot = 0;
+  for(int i = 0; i < 21; ++i)
+    dot += i * (100 - i);
+  REQUIRE( x * y == dot + 10 );
+  Counts z(x);
+  REQUIRE( z == x );
+  z += y;
+  for(int i = 0; i < 21; ++i)
+    REQUIRE( z.data[i] == 100 );
+  REQUIRE( z.raw[4] == 5 );
+  z *= 3;
+  REQUIRE( z.data[20] == 300 );
+  REQUIRE( z.raw[0] == 3 );
+  REQUIRE( !(z == x) );
+}
+
+struct Trade : ThreeWayComparable<Trade> {
+  string symbol;
+  int qty;
+  double price;
+  unsigned char flags;
+  vector<short> legs;
+
+  Trade(string symbol, int qty, double price, unsigned char flags,
+        vector<short> legs)
+    : symbol(symbol), qty(qty), price(price), flags(flags), legs(legs) {}
+
+  template<class C> void enhance(C& c) const{
+    c(&Trade::symbol, &Trade::qty, &Trade::price, &Trade::flags,
+      container(&Trade::legs));
+  }
+};
+
+int sign(int x){
+  return (x > 0) - (x < 0);
+}
+
+TEST_CASE( "sort keys" ) {
+  vector<Trade> trades;
+  const string symbols[] = {"", "A", "AB", string("A\0B", 3),
+                            string("A\0", 2), "B"};
+  const int qtys[] = {std::numeric_limits<int>::min(), -7, 0, 3};
+  const double prices[] = {-std::numeric_limits<double>::infinity(),
+                           -2.5, -0.0, 0.0, 1e-300, 2.5};
+  for(auto& s : symbols)
+    for(int q : qtys)
+      for(double p : prices)
+        trades.push_back(Trade{s, q, p, (unsigned char)(q & 0xf),
+              vector<short>{short(q / 2), -1}});
+
+  for(auto& a : trades)
+    for(auto& b : trades){
+      string ka = sortKey(a), kb = sortKey(b);
+      REQUIRE( sign(ka.compare(kb)) == sign(compare(a, b)) );
+    }
+
+  Trade a{"X", 1, 1.0, 0, {}}, b{"X", 2, 0.5, 0, {}};
+  string ka = sortKey(a)(&Trade::symbol, descending(&Trade::qty));
+  string kb = sortKey(b)(&Trade::symbol, descending(&Trade::qty));
+  REQUIRE( kb < ka );
+  REQUIRE( string(sortKey(a)(descending(&Trade::price))) <
+           string(sortKey(b)(descending(&Trade::price))) );
+
+  // fixed length prefixes
+  string pa = sortKey(a, 4), pb = sortKey(b, 4);
+  REQUIRE( pa.size() == 4 );
+  REQUIRE( pa == pb );
+  REQUIRE( string(sortKey(a, 7)) < string(sortKey(b, 7)) );
+  REQUIRE( string(sortKey(a, 100)).size() == 100 );
+  REQUIRE( string(sortKey(a, 100)).compare(0, string(sortKey(a)).size(),
+                                           sortKey(a)) == 0 );
+}
+
+struct Tick {
+  int64_t time;
+  double price;
+  int seq;
+
+  template<class C> void enhance(C& c) const{
+    c(&Tick::time, &Tick::price);
+  }
+};
+
+// groups ascending, scores descending within a group
+struct Ranked {
+  int group, score;
+
+  template<class C> void enhance(C& c) const{
+    c(&Ranked::group, descending(&Ranked::score));
+  }
+};
+
+TEST_CASE( "radix sort" ) {
+  std::mt19937 rng(7);
+  // classes of numbers are sorted by comparison below
+  // `radix::arithmeticCutoff` objects
+  for(size_t n : {size_t(0), size_t(1), size_t(2), size_t(50), size_t(1000),
+                  size_t(5000), radix::arithmeticCutoff + 1000}){
+    // keys of 16 bytes, many equal ones
+    vector<Tick> ticks(n);
+    for(size_t i = 0; i < n; ++i){
+      ticks[i].time = int64_t(rng() % 50) - 25;
+      ticks[i].price = (int(rng() % 200) - 100) / 8.0;
+      ticks[i].seq = int(i);
+    }
+    vector<Tick> expected = ticks;
+    std::stable_sort(expected.begin(), expected.end(),
+                     [](const Tick& a, const Tick& b){
+                       return compare(a, b) < 0; });
+    enhance::sort(ticks.begin(), ticks.end());
+    for(size_t i = 0; i < n; ++i)
+      REQUIRE( ticks[i].seq == expected[i].seq );
+
+    // variable length keys, spanning several chunks
+    vector<Name> names;
+    for(size_t i = 0; i < n; ++i)
+      names.push_back(Name(string(rng() % 3 * 9, 'a') + std::to_string(rng() % 100),
+                           std::to_string(i)));
+    vector<Name> expectedNames = names;
+    std::stable_sort(expectedNames.begin(), expectedNames.end(),
+                     [](const Name& a, const Name& b){
+                       return compare(a, b) < 0; });
+    enhance::sort(names.begin(), names.end());
+    for(size_t i = 0; i < n; ++i)
+      REQUIRE( names[i].first == expectedNames[i].first );
+  }
+
+  // descending values, on both sides of `radix::arithmeticCutoff`
+  for(size_t n : {size_t(100), radix::arithmeticCutoff + 1000}){
+    vector<Ranked> ranked(n);
+    for(size_t i = 0; i < n; ++i){
+      ranked[i].group = int(rng() % 10);
+      ranked[i].score = int(rng() % 1000) - 500;
+    }
+    enhance::sort(ranked.begin(), ranked.end());
+    for(size_t i = 1; i < n; ++i)
+      REQUIRE( (ranked[i - 1].group < ranked[i].group ||
+                (ranked[i - 1].group == ranked[i].group &&
+                 ranked[i - 1].score >= ranked[i].score)) );
+  }
+
+  // long common prefixes, in small and in large buckets
+  for(size_t n : {30, 100}){
+    const string prefix(n == 30 ? 1 << 20 : 100000, 'p');
+    vector<Name> names;
+    for(size_t i = 0; i < n; ++i)
+      names.push_back(Name(std::to_string(i), prefix + std::to_string(rng() % 10)));
+    vector<Name> expectedNames = names;
+    std::stable_sort(expectedNames.begin(), expectedNames.end(),
+                     [](const Name& a, const Name& b){
+                       return compare(a, b) < 0; });
+    enhance::sort(names.begin(), names.end());
+    for(size_t i = 0; i < n; ++i)
+      REQUIRE( names[i].first == expectedNames[i].first );
+  }
+}
+
+struct Vec3 {
+  double x, y, z;
+
+  template<class C> void enhance(C& c) const{
+    c(&Vec3::x, &Vec3::y, &Vec3::z);
+  }
+};
+
+// not all components are scalars
+struct Label {
+  int id;
+  string text;
+
+  template<class C> void enhance(C& c) const{
+    c(&Label::id, &Label::text);
+  }
+};
+
+// counts the compared pairs of components
+struct CountingLessPW : BinaryCombiner<ComparisonOp<PointwiseComparisonOp<std::less> >,
+                                       const Vec3, const Vec3, CountingLessPW> {
+  int& steps;
+
+  CountingLessPW(const Vec3& a, const Vec3& b, int& steps)
+    : CountingLessPW::BinaryCombiner(a, b), steps(steps) {}
+
+  void beforeStep(){ ++steps; }
+};
+
+TEST_CASE( "branchless point-wise comparison" ) {
+  std::mt19937 rng(11);
+  for(int i = 0; i < 1000; ++i){
+    Vec3 a{double(rng() % 2), double(rng() % 2), double(rng() % 2)};
+    Vec3 b{double(rng() % 2), double(rng() % 2), double(rng() % 2)};
+    bool eq = a.x == b.x && a.y == b.y && a.z == b.z;
+    bool le = a.x <= b.x && a.y <= b.y && a.z <= b.z;
+    REQUIRE( equal(a, b) == eq );
+    REQUIRE( equalBranchless(a, b) == eq );
+    REQUIRE( lessEqualPW(a, b) == le );
+    REQUIRE( lessEqualPWBranchless(a, b) == le );
+    REQUIRE( unequalBranchless(a, b) ==
+             (a.x != b.x && a.y != b.y && a.z != b.z) );
+
+    Label c{int(rng() % 2), string(rng() % 2, 'x')};
+    Label d{int(rng() % 2), string(rng() % 2, 'x')};
+    REQUIRE( equal(c, d) == (c.id == d.id && c.text == d.text) );
+    REQUIRE( equalBranchless(c, d) == (c.id == d.id && c.text == d.text) );
+  }
+
+  // the branchless combiners evaluate every component
+  Vec3 a{1, 2, 3}, b{0, 2, 3};
+  int calls = 0;
+  auto count = [&](const Vec3& v){ ++calls; return v.z; };
+  REQUIRE( equalBranchless(a, b)(&Vec3::x, count) == false );
+  REQUIRE( calls == 2 );
+  REQUIRE( lessPW(a, b)(&Vec3::x, count) == false );
+  REQUIRE( calls == 4 );
+
+  // derived combiners keep their steps
+  int steps = 0;
+  REQUIRE( CountingLessPW(Vec3{1, 2, 3}, Vec3{2, 3, 4}, steps).callEnhance() == true );
+  REQUIRE( steps == 3 );
+  steps = 0;
+  REQUIRE( CountingLessPW(a, b, steps).callEnhance() == false );
+  REQUIRE( steps == 1 );
+}
+
+struct Account {
+  string owner;
+  int64_t id;
+  double balance;
+
+  Account(string owner, int64_t id, double balance)
+    : owner(owner), id(id), balance(balance) {}
+
+  template<class C> void enhance(C& c) const{
+    c(&Account::owner, &Account::id, &Account::balance);
+  }
+};
+
+// a key struct with the same projection, that does not allocate
+struct AccountKey {
+  const char* owner;
+  int id;
+
+  template<class C> void enhance(C& c) const{
+    c(&AccountKey::owner, &AccountKey::id);
+  }
+};
+
+TEST_CASE( "heterogeneous lookup" ) {
+  TransparentLess<Account> less;
+  TransparentEqual<Account> eq;
+  TransparentHash<Account> hash;
+  Account a("bob", 7, 1.5), b("bob", 9, 0.5), c("carl", 1, 2);
+
+  SECTION( "comparison" ) {
+    REQUIRE( less(a, b) );
+    REQUIRE( !less(b, a) );
+    REQUIRE( !less(a, a) );
+    REQUIRE( less(a, std::make_tuple("bob", 8)) );
+    REQUIRE( less(std::make_tuple("bob", 8), b) );
+    REQUIRE( less(AccountKey{"bob", 8}, b) );
+    REQUIRE( !less(AccountKey{"bob", 7}, a) );
+    REQUIRE( !less(a, AccountKey{"bob", 7}) );
+    REQUIRE( less(string("bo"), a) );
+    REQUIRE( less(a, "bob\x01") );
+    // prefix keys are equivalent to all objects starting with them
+    REQUIRE( !less(a, "bob") );
+    REQUIRE( !less("bob", b) );
+    // numbers of other types are compared by their values
+    Account d("dan", -1, -0.5);
+    REQUIRE( less(d, std::make_tuple("dan", 1u)) );
+    REQUIRE( !less(std::make_tuple("dan", 1u), d) );
+    REQUIRE( less(d, std::make_tuple("dan", -1, 0)) );
+    REQUIRE( less(std::make_tuple("dan", -1, -1), d) );
+    REQUIRE( less(std::make_tuple("dan", -1.5), d) );
+    REQUIRE( less(d, std::make_tuple("dan", -0.5)) );
+    REQUIRE( !less(d, std::make_tuple("dan", -1.0)) );
+
+    vector<Account> v = {c, b, a};
+    std::sort(v.begin(), v.end(), less);
+    REQUIRE( v[0].id == 7 );
+    REQUIRE( v[2].id == 1 );
+    auto r = std::equal_range(v.begin(), v.end(), "bob", less);
+    REQUIRE( r.second - r.first == 2 );
+    auto i = std::lower_bound(v.begin(), v.end(), AccountKey{"bob", 9}, less);
+    REQUIRE( i->id == 9 );
+
+#if __cplusplus >= 201402L
+    std::set<Account, TransparentLess<Account> > s = {a, b, c};
+    REQUIRE( s.find(AccountKey{"carl", 1})->balance == 2 );
+    REQUIRE( s.count("bob") == 2 );
+    REQUIRE( s.find(AccountKey{"carl", 2}) == s.end() );
+#endif
+  }
+
+  SECTION( "equality and hashing" ) {
+    REQUIRE( eq(a, a) );
+    REQUIRE( !eq(a, b) );
+    REQUIRE( eq(a, std::make_tuple("bob", 7, 1.5)) );
+    REQUIRE( eq(std::make_tuple(string("bob"), 7LL, 1.5), a) );
+    REQUIRE( !eq(a, std::make_tuple("bob", 7, 2.5)) );
+
+    REQUIRE( hash(a) == hash(std::make_tuple("bob", 7, 1.5)) );
+    REQUIRE( hash(a) == hash(std::make_tuple(string("bob"), int64_t(7), 1.5)) );
+    string owner = "bob";
+    REQUIRE( hash(a) == hash(std::tie(owner, a.id, a.balance)) );
+    REQUIRE( hash(a) != hash(b) );
+    REQUIRE( hash(Account("bob", 7, 1.5)) == hash(a) );
+
+    // numbers of other types than the members, with the same values
+    REQUIRE( eq(c, std::make_tuple("carl", 1u, 2)) );
+    REQUIRE( hash(c) == hash(std::make_tuple("carl", 1u, 2)) );
+    REQUIRE( hash(c) == hash(std::make_tuple("carl", 1.0, 2.0f)) );
+    REQUIRE( hash(a) == hash(std::make_tuple("bob", 7, 1.5f)) );
+    REQUIRE( !eq(c, std::make_tuple("carl", 1, 2.5)) );
+
+    std::unordered_set<Account, TransparentHash<Account>,
+                       TransparentEqual<Account> > s = {a, b, c};
+    REQUIRE( s.size() == 3 );
+    REQUIRE( s.count(Account("carl", 1, 2)) == 1 );
+  }
+}
+
+TEST_CASE( "flat hash set and map" ) {
+  FlatHashSet<Person> people{Person{"Frank", 21}, Person{"Frank", 21},
+                             Person{"Anne", 30}};
+  REQUIRE( people.size() == 2 );
+  REQUIRE( people.contains(Person{"Anne", 30}) );
+  REQUIRE_FALSE( people.contains(Person{"Anne", 31}) );
+  REQUIRE( people.find(Person{"Frank", 21})->age == 21 );
+  REQUIRE( people.find(Person{"Bob", 21}) == people.end() );
+  REQUIRE_FALSE( people.insert(Person{"Anne", 30}).second );
+
+  // growth, deleted slots and iteration
+  FlatHashSet<Tick> ticks;
+  for(int round = 0; round < 3; ++round){
+    for(int i = 0; i < 5000; ++i)
+      REQUIRE( ticks.insert(Tick{i, double(i % 7)}).second );
+    REQUIRE( ticks.size() == 5000 );
+    for(int i = 0; i < 5000; i += 2)
+      REQUIRE( ticks.erase(Tick{i, double(i % 7)}) == 1 );
+    REQUIRE( ticks.erase(Tick{0, 0}) == 0 );
+    REQUIRE( ticks.size() == 2500 );
+    size_t n = 0;
+    for(const Tick& t : ticks){
+      REQUIRE( t.time % 2 == 1 );
+      ++n;
+    }
+    REQUIRE( n == 2500 );
+    for(int i = 1; i < 5000; i += 2)
+      REQUIRE( ticks.erase(Tick{i, double(i % 7)}) == 1 );
+    REQUIRE( ticks.empty() );
+  }
+
+  std::vector<Person> keys{Person{"Anne", 30}, Person{"Bob", 1}, Person{"Frank", 21}};
+  std::vector<FlatHashSet<Person>::const_iterator> found(keys.size());
+  people.find_many(keys.data(), keys.size(), found.begin());
+  REQUIRE( found[0]->name == "Anne" );
+  REQUIRE( found[1] == people.end() );
+  REQUIRE( found[2]->name == "Frank" );
+
+  FlatHashSet<Person> copy = people;
+  people.clear();
+  REQUIRE( people.empty() );
+  REQUIRE( copy.size() == 2 );
+
+  FlatHashMap<Person, int> scores;
+  scores[Person{"Anne", 30}] = 3;
+  scores[Person{"Anne", 30}] += 4;
+  scores.insert(std::make_pair(Person{"Bob", 1}, 2));
+  REQUIRE( scores.size() == 2 );
+  REQUIRE( scores.at(Person{"Anne", 30}) == 7 );
+  REQUIRE_THROWS_AS( scores.at(Person{"Carl", 1}), const std::out_of_range& );
+}
+
+struct SmallPair {
+  short a, b;
+  string tag;
+
+  template<class C> void enhance(C& c) const{
+    c(&SmallPair::a, &SmallPair::b, &SmallPair::tag);
+  }
+};
+
+struct SumHash {
+  struct Functor {
+    size_t operator()(const SmallPair& x) const{
+      return size_t(x.a + x.b);
+    }
+  };
+};
+
+TEST_CASE( "hash analysis" ) {
+  std::vector<SmallPair> sample;
+  for(short a = 0; a < 64; ++a)
+    for(short b = 0; b < 64; ++b)
+      sample.push_back(SmallPair{a, b, "x"});
+
+  HashReport good = analyzeHash<Hash<SmallPair> >(sample, {4096, 1000}, 100);
+  REQUIRE( good.samples == 4096 );
+  REQUIRE( good.distinct == 4096 );
+  REQUIRE( good.tables.size() == 2 );
+  for(const HashReport::Table& t : good.tables){
+    size_t buckets = 0, objects = 0;
+    for(size_t k = 0; k < t.histogram.size(); ++k){
+      buckets += t.histogram[k];
+      objects += k * t.histogram[k];
+    }
+    REQUIRE( buckets == t.buckets );
+    REQUIRE( objects == 4096 );
+    REQUIRE( std::abs(t.collisionRate - t.randomCollisionRate) < 0.05 );
+  }
+  REQUIRE( good.inputBits == 32 );
+  REQUIRE( good.bitBias[HashReport::maxIndex(good.bitBias)] < 0.05 );
+  REQUIRE( good.avalancheBias[HashReport::maxIndex(good.avalancheBias)] < 0.25 );
+  REQUIRE( good.nanosecondsPerHash > 0 );
+
+  HashReport bad = analyzeHash<SumHash>(sample);
+  REQUIRE( bad.distinct == 127 );
+  REQUIRE( bad.tables[0].buckets == 4096 );
+  REQUIRE( bad.tables[0].used == 127 );
+  REQUIRE( bad.avalancheBias[HashReport::maxIndex(bad.avalancheBias)] == 0.5 );
+
+  std::ostringstream report;
+  report << good;
+  REQUIRE( report.str().find("buckets: 1000") != string::npos );
+
+  REQUIRE_THROWS_AS( analyzeHash<SumHash>(sample, {16, 0}), const std::invalid_argument& );
+}